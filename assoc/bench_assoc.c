@@ -0,0 +1,105 @@
+#include "bench.h"
+#include "harness/rng.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// assoc chases a cycle through `ways` addresses spaced `stride` bytes
+// apart. With a power-of-two stride at least as large as a cache's set
+// span (sets x 64 bytes) every address lands in the same set, so the cycle
+// fits exactly while `ways` does not exceed the associativity and misses
+// on every hop after that. An odd multiple of the line size spreads the
+// same addresses over all sets.
+#define ASSOC_ACCESSES ((size_t)1 << 20)
+#define MAX_ASSOC_WAYS 1024
+#define ASSOC_STREAM 0x6173736f63000000ULL  // "assoc"
+
+// alias4k copies a small buffer to a destination `delta` bytes past a
+// 4 KiB multiple. Loads whose low 12 address bits match an older store
+// still in the store buffer are held back as if they depended on it.
+#define ALIAS_ELEMS 512  // One 4 KiB page each; both stay in L1
+#define ALIAS_GAP 1024   // Elements from source to destination page
+#define ALIAS_COPIES ((size_t)1 << 13)
+
+static BenchResult RunAssoc(uint64_t *array, size_t n, size_t ways,
+                            size_t stride_bytes) {
+  BenchResult error = {0};
+  size_t stride = stride_bytes / sizeof(uint64_t);
+  if (ways == 0 || ways > MAX_ASSOC_WAYS || stride == 0 ||
+      (ways - 1) * stride >= n) {
+    fprintf(stderr, "Assoc: %zu addresses %zu bytes apart do not fit the "
+                    "array\n", ways, stride_bytes);
+    return error;
+  }
+  // Random order, so no prefetcher can learn the stride.
+  size_t order[MAX_ASSOC_WAYS];
+  Rng rng;
+  RngSeed(&rng, BenchSeed(), ASSOC_STREAM);
+  for (size_t i = 0; i < ways; i++) order[i] = i;
+  for (size_t i = ways - 1; i > 0; i--) {
+    size_t j = RngBounded(&rng, i + 1);
+    size_t t = order[i];
+    order[i] = order[j];
+    order[j] = t;
+  }
+  for (size_t i = 0; i < ways; i++) {
+    array[order[i] * stride] = order[(i + 1) % ways] * stride;
+  }
+
+  size_t idx = order[0] * stride;
+  for (size_t i = 0; i < ways; i++) idx = array[idx];  // Warm the lines
+  BenchTimer timer;
+  TimerStart(&timer);
+  for (size_t i = 0; i < ASSOC_ACCESSES; i++) idx = array[idx];
+  uint64_t ns = TimerStop(&timer);
+  Escape(&idx);
+
+  return (BenchResult){.name = "Set conflicts", .iterations = ASSOC_ACCESSES,
+                       .total_ns = ns,
+                       .ns_per_access = (double)ns / ASSOC_ACCESSES};
+}
+
+// Kept scalar so every element is one load and one store, in order.
+__attribute__((optimize("no-tree-vectorize"))) static uint64_t AliasCopy(
+    const uint64_t *src, uint64_t *dst, size_t copies) {
+  for (size_t c = 0; c < copies; c++) {
+    for (size_t i = 0; i < ALIAS_ELEMS; i++) dst[i] = src[i] + c;
+    Clobber();
+  }
+  return dst[ALIAS_ELEMS - 1];
+}
+
+static BenchResult RunAlias4k(uint64_t *array, size_t n, size_t delta) {
+  BenchResult error = {0};
+  // Elements stay aligned, so a misaligned store cannot blur the result.
+  if (delta % sizeof(uint64_t) != 0) {
+    fprintf(stderr, "Alias4k: delta %zu is not a multiple of 8\n", delta);
+    return error;
+  }
+  size_t offset = ALIAS_GAP + delta / sizeof(uint64_t);
+  if (offset + ALIAS_ELEMS > n) {
+    fprintf(stderr, "Alias4k: array too small\n");
+    return error;
+  }
+  uint64_t *src = array, *dst = array + offset;
+  for (size_t i = 0; i < ALIAS_ELEMS; i++) src[i] = i;
+
+  BenchTimer timer;
+  TimerStart(&timer);
+  uint64_t last = AliasCopy(src, dst, ALIAS_COPIES);
+  uint64_t ns = TimerStop(&timer);
+  Escape(&last);
+
+  size_t elements = ALIAS_COPIES * ALIAS_ELEMS;
+  return (BenchResult){.name = "4K aliasing", .iterations = elements,
+                       .total_ns = ns, .ns_per_access = (double)ns / elements};
+}
+
+BenchResult BenchAssoc(uint64_t *array, size_t n, const int64_t *params) {
+  return RunAssoc(array, n, (size_t)params[0], (size_t)params[1]);
+}
+
+BenchResult BenchAlias4k(uint64_t *array, size_t n, const int64_t *params) {
+  return RunAlias4k(array, n, (size_t)params[0]);
+}
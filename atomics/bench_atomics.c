@@ -0,0 +1,226 @@
+#define _GNU_SOURCE
+#include "bench.h"
+#include "harness/numa.h"
+#include "harness/pool.h"
+
+#include <inttypes.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define CACHE_LINE 64
+#define PAGE_BYTES 4096
+#define OPS_PER_THREAD (1u << 18)
+// Sharded layouts look up the current CPU this often, as a real per-CPU
+// counter would (threads may migrate between lookups).
+#define CPU_REFRESH 1024
+
+// Parameter values, in the order of the names registered in main.c.
+enum { kOpAdd, kOpCas, kOpXchg, kOpLoad, kOpStore };
+enum { kOrderRelaxed, kOrderAcqRel, kOrderSeqCst };
+enum { kLayoutShared, kLayoutPadded, kLayoutSharded, kLayoutNode };
+
+static const char *const kOpNames[] = {"fetch_add", "CAS loop", "exchange",
+                                       "load", "store"};
+static const char *const kOrderNames[] = {"relaxed", "acquire/release",
+                                          "seq_cst"};
+static const char *const kLayoutNames[] = {
+    "one shared line", "per-thread padded", "per-CPU shards",
+    "per-node shards"};
+
+typedef struct {
+  char *slots;         // Counter i at slots + i * stride
+  size_t stride;
+  size_t num_slots;
+  int layout;
+  const int *cpu_node;  // kLayoutNode: node of each CPU
+} Counter;
+
+typedef struct {
+  const Counter *counter;
+  size_t thread;
+  int op;
+  uint64_t ops;
+  uint64_t cas_failures;
+  uint64_t sink;
+} AtomicArg;
+
+static inline atomic_uint_fast64_t *Slot(const Counter *c, size_t i) {
+  return (atomic_uint_fast64_t *)(c->slots + i * c->stride);
+}
+
+// The slot this thread updates right now.
+static atomic_uint_fast64_t *OwnSlot(const AtomicArg *arg) {
+  const Counter *c = arg->counter;
+  switch (c->layout) {
+    case kLayoutPadded: return Slot(c, arg->thread);
+    case kLayoutSharded: {
+      int cpu = sched_getcpu();
+      return Slot(c, cpu >= 0 ? (size_t)cpu % c->num_slots : 0);
+    }
+    case kLayoutNode: {
+      int cpu = sched_getcpu();
+      int node = cpu >= 0 && cpu < MAX_CPUS ? c->cpu_node[cpu] : 0;
+      return Slot(c, (size_t)node % c->num_slots);
+    }
+    default: return Slot(c, 0);
+  }
+}
+
+// One worker per memory order; RMW, LOAD and STORE are the orders used for
+// read-modify-writes, loads and stores. Loads read the counter's value,
+// which for the padded and sharded layouts means summing every slot.
+#define DEFINE_WORKER(Name, RMW, LOAD, STORE)                                \
+  static void Name(void *p) {                                               \
+    AtomicArg *arg = p;                                                     \
+    const Counter *c = arg->counter;                                        \
+    atomic_uint_fast64_t *slot = OwnSlot(arg);                              \
+    uint64_t sink = 0, failures = 0;                                        \
+    for (uint64_t i = 0; i < arg->ops; i++) {                               \
+      if (i % CPU_REFRESH == 0 && c->layout >= kLayoutSharded) {            \
+        slot = OwnSlot(arg);                                                \
+      }                                                                     \
+      switch (arg->op) {                                                    \
+        case kOpAdd: atomic_fetch_add_explicit(slot, 1, RMW); break;        \
+        case kOpCas: {                                                      \
+          uint_fast64_t v = atomic_load_explicit(slot, memory_order_relaxed); \
+          while (!atomic_compare_exchange_weak_explicit(                    \
+              slot, &v, v + 1, RMW, memory_order_relaxed)) {                \
+            failures++;                                                     \
+          }                                                                 \
+          break;                                                            \
+        }                                                                   \
+        case kOpXchg: sink += atomic_exchange_explicit(slot, i, RMW); break; \
+        case kOpLoad:                                                       \
+          for (size_t s = 0; s < c->num_slots; s++) {                       \
+            sink += atomic_load_explicit(Slot(c, s), LOAD);                 \
+          }                                                                 \
+          break;                                                            \
+        case kOpStore: atomic_store_explicit(slot, i, STORE); break;        \
+      }                                                                     \
+    }                                                                       \
+    arg->sink = sink;                                                       \
+    arg->cas_failures = failures;                                           \
+  }
+
+DEFINE_WORKER(WorkerRelaxed, memory_order_relaxed, memory_order_relaxed,
+              memory_order_relaxed)
+DEFINE_WORKER(WorkerAcqRel, memory_order_acq_rel, memory_order_acquire,
+              memory_order_release)
+DEFINE_WORKER(WorkerSeqCst, memory_order_seq_cst, memory_order_seq_cst,
+              memory_order_seq_cst)
+
+static const PoolTask kWorkers[] = {WorkerRelaxed, WorkerAcqRel,
+                                    WorkerSeqCst};
+
+// Slot count and spacing for `layout`. Node shards get a page each so they
+// can be bound to their node.
+static int SetupCounter(Counter *c, int layout, int num_threads,
+                        int *cpu_node) {
+  memset(c, 0, sizeof(*c));
+  c->layout = layout;
+  c->stride = CACHE_LINE;
+  c->cpu_node = cpu_node;
+  switch (layout) {
+    case kLayoutPadded: c->num_slots = num_threads; break;
+    case kLayoutSharded: {
+      long cpus = sysconf(_SC_NPROCESSORS_CONF);
+      c->num_slots = cpus > 0 ? (size_t)cpus : 1;
+      break;
+    }
+    case kLayoutNode: {
+      c->num_slots = NumaNodeCount();
+      c->stride = PAGE_BYTES;
+      int cpus[MAX_CPUS];
+      for (size_t node = 0; node < c->num_slots; node++) {
+        int count = NumaNodeCpus((int)node, cpus, MAX_CPUS);
+        for (int i = 0; i < count; i++) {
+          if (cpus[i] < MAX_CPUS) cpu_node[cpus[i]] = (int)node;
+        }
+      }
+      break;
+    }
+    default: c->num_slots = 1; break;
+  }
+  size_t bytes = c->num_slots * c->stride;
+  c->slots = aligned_alloc(c->stride, bytes);
+  if (!c->slots) return 0;
+  memset(c->slots, 0, bytes);
+  if (layout == kLayoutNode && c->num_slots > 1) {
+    for (size_t node = 0; node < c->num_slots; node++) {
+      NumaBindMemory(c->slots + node * PAGE_BYTES, PAGE_BYTES, (int)node);
+    }
+  }
+  return 1;
+}
+
+static BenchResult RunAtomics(int op, int order, int layout,
+                              int num_threads) {
+  BenchResult error = {0};
+  int *cpu_node = calloc(MAX_CPUS, sizeof(int));
+  AtomicArg *args = malloc(num_threads * sizeof(AtomicArg));
+  Counter counter;
+  if (!cpu_node || !args ||
+      !SetupCounter(&counter, layout, num_threads, cpu_node)) {
+    fprintf(stderr, "Failed to allocate %d atomic workers\n", num_threads);
+    free(cpu_node);
+    free(args);
+    return error;
+  }
+  for (int t = 0; t < num_threads; t++) {
+    args[t] = (AtomicArg){.counter = &counter, .thread = t, .op = op,
+                          .ops = OPS_PER_THREAD};
+  }
+
+  int ok = PoolReserve(num_threads);
+  PoolTiming timing;
+  BenchTimer timer;
+  TimerStart(&timer);
+  ok = ok && PoolRun(num_threads, kWorkers[order], args, sizeof(AtomicArg),
+                     &timing);
+  TimerStop(&timer);
+
+  uint64_t total = 0, failures = 0, sink = 0;
+  for (size_t s = 0; s < counter.num_slots; s++) {
+    total += atomic_load(Slot(&counter, s));
+  }
+  for (int t = 0; t < num_threads; t++) {
+    failures += args[t].cas_failures;
+    sink += args[t].sink;
+  }
+  Escape(&sink);
+  free(counter.slots);
+  free(cpu_node);
+  free(args);
+  if (!ok) return error;
+
+  uint64_t ns = timing.span_ns;
+  size_t total_ops = (size_t)OPS_PER_THREAD * num_threads;
+  double mops = total_ops * 1e3 / (double)ns;
+  BenchLog("  %s, %s, %s, %d thread%s\n", kOpNames[op], kOrderNames[order],
+           kLayoutNames[layout], num_threads, num_threads == 1 ? "" : "s");
+  BenchLog("  Throughput: %.1f Mops/s (%.1f per thread; workers overlapped "
+           "%.0f%%)\n",
+           mops, mops / num_threads, 100.0 * PoolOverlap(&timing));
+  if (op == kOpAdd || op == kOpCas) {
+    BenchLog("  Counter: %" PRIu64 " (expected %zu)\n", total, total_ops);
+  }
+  if (op == kOpCas) {
+    BenchLog("  CAS retries: %.3f per op\n", (double)failures / total_ops);
+  }
+
+  return (BenchResult){.name = "Atomic counter", .iterations = total_ops,
+                       .total_ns = ns,
+                       .ns_per_access = (double)ns / total_ops};
+}
+
+BenchResult BenchAtomics(uint64_t *array, size_t n, const int64_t *params) {
+  (void)array;
+  (void)n;
+  return RunAtomics((int)params[0], (int)params[1], (int)params[2],
+                    (int)params[3]);
+}
@@ -1,7 +1,8 @@
 #include "bench.h"
+#include "harness/pool.h"
 
-#include <pthread.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <time.h>
 
 typedef struct {
@@ -10,7 +11,7 @@ typedef struct {
   uint64_t result;
 } ThreadArg;
 
-static void *SumThread(void *arg) {
+static void SumThread(void *arg) {
   ThreadArg *ta = (ThreadArg *)arg;
   uint64_t sum = 0;
   uint64_t *arr = ta->start;
@@ -21,40 +22,60 @@ static void *SumThread(void *arg) {
   }
 
   ta->result = sum;
-  return NULL;
 }
 
 static BenchResult RunBandwidth(uint64_t *array, size_t n, int num_threads, const char *name) {
-  pthread_t threads[32];
-  ThreadArg args[32];
+  BenchResult error = {0};
+  if (n < (size_t)num_threads) {
+    fprintf(stderr, "Bandwidth: array too small for %d threads\n",
+            num_threads);
+    return error;
+  }
+  ThreadArg *args = malloc(num_threads * sizeof(ThreadArg));
+  if (!args) {
+    fprintf(stderr, "Failed to allocate %d threads\n", num_threads);
+    return error;
+  }
+  // The last worker also reads the remainder.
   size_t chunk = n / num_threads;
-
-  struct timespec start, end;
-  clock_gettime(CLOCK_MONOTONIC, &start);
-
   for (int t = 0; t < num_threads; t++) {
     args[t].start = array + t * chunk;
-    args[t].count = chunk;
-    pthread_create(&threads[t], NULL, SumThread, &args[t]);
+    args[t].count = t + 1 == num_threads ? n - t * chunk : chunk;
+  }
+
+  // Workers time themselves; the main-thread timer only brackets the
+  // hardware counters.
+  if (!PoolReserve(num_threads)) {
+    free(args);
+    return error;
+  }
+  PoolTiming timing;
+  BenchTimer timer;
+  TimerStart(&timer);
+  int ok = PoolRun(num_threads, SumThread, args, sizeof(ThreadArg), &timing);
+  TimerStop(&timer);
+  if (!ok) {
+    free(args);
+    return error;
   }
 
   uint64_t total = 0;
   for (int t = 0; t < num_threads; t++) {
-    pthread_join(threads[t], NULL);
     total += args[t].result;
   }
-
-  clock_gettime(CLOCK_MONOTONIC, &end);
   Escape(&total);
+  free(args);
 
-  uint64_t ns = (end.tv_sec - start.tv_sec) * 1000000000ULL + (end.tv_nsec - start.tv_nsec);
-  double seconds = ns / 1e9;
-  double gb = (n * sizeof(uint64_t)) / 1e9;
-  double gbps = gb / seconds;
+  uint64_t ns = timing.span_ns;
+  size_t accesses = n;
+  double gbps = (accesses * sizeof(uint64_t)) / (double)ns;
 
-  printf("  Bandwidth: %.1f GB/s\n", gbps);
+  BenchLog("  Bandwidth: %.1f GB/s (workers overlapped %.0f%% of %.2f ms)\n",
+           gbps, 100.0 * PoolOverlap(&timing), ns / 1e6);
 
-  return (BenchResult){name, n, ns, (double)ns / n};
+  return (BenchResult){.name = name, .iterations = accesses,
+                       .total_ns = ns, .ns_per_access = (double)ns / accesses,
+                       .gbps = gbps};
 }
 
 BenchResult BenchBw1(uint64_t *a, size_t n) { return RunBandwidth(a, n, 1, "Bandwidth 1 thread"); }
@@ -62,3 +83,7 @@ BenchResult BenchBw2(uint64_t *a, size_t n) { return RunBandwidth(a, n, 2, "Band
 BenchResult BenchBw4(uint64_t *a, size_t n) { return RunBandwidth(a, n, 4, "Bandwidth 4 threads"); }
 BenchResult BenchBw8(uint64_t *a, size_t n) { return RunBandwidth(a, n, 8, "Bandwidth 8 threads"); }
 
+
+BenchResult BenchBwThreads(uint64_t *a, size_t n, const int64_t *params) {
+  return RunBandwidth(a, n, (int)params[0], "Bandwidth");
+}
@@ -3,12 +3,49 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <time.h>
+
+// Distribution of ns/access over repeated timed trials (see harness/runner.h)
+typedef struct {
+  size_t trials;
+  size_t warmup;
+  double min;
+  double max;
+  double median;
+  double mean;
+  double p90;
+  double p99;
+  double stddev;
+  double ci_low;  // 95% confidence interval of the mean
+  double ci_high;
+} BenchStats;
+
+// Hardware counters sampled around each timed region (harness/perf_counters.h)
+enum {
+  kCounterCycles,
+  kCounterInstructions,
+  kCounterLlcMisses,
+  kCounterDtlbMisses,
+  kCounterBranchMisses,
+  kCounterL1dReplacements,
+  kNumCounters,
+};
+
+typedef struct {
+  unsigned available;  // Bit i set if counter i was measured
+  uint64_t accesses;   // Accesses covered by `values` (summed over trials)
+  uint64_t values[kNumCounters];
+} BenchCounters;
 
 typedef struct {
   const char *name;
   size_t iterations;
   uint64_t total_ns;
   double ns_per_access;
+  BenchStats stats;
+  BenchCounters counters;
+  uint64_t setup_ns;  // Mean untimed work per call (setup, checks, frees)
+  double gbps;        // Bandwidth moved (or injected), 0 if not measured
 } BenchResult;
 
 static inline void Escape(void *p) {
@@ -19,20 +56,101 @@ static inline void Clobber(void) {
   __asm__ volatile("" : : : "memory");
 }
 
+// Brackets the measured region of a benchmark; hardware counters (if
+// enabled) run exactly while the region is open.
+void PerfRegionBegin(void);
+void PerfRegionEnd(void);
+
+// Monotonic time in nanoseconds, for bookkeeping outside the measured
+// region (setup, worker windows); kernels are timed with BenchTimer.
+static inline uint64_t NowNs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+typedef struct {
+  struct timespec start;
+} BenchTimer;
+
+static inline void TimerStart(BenchTimer *t) {
+  PerfRegionBegin();
+  clock_gettime(CLOCK_MONOTONIC, &t->start);
+}
+
+// Returns nanoseconds since TimerStart().
+static inline uint64_t TimerStop(BenchTimer *t) {
+  struct timespec end;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  PerfRegionEnd();
+  return (end.tv_sec - t->start.tv_sec) * 1000000000ULL +
+         (end.tv_nsec - t->start.tv_nsec);
+}
+
+// Informational output from inside a benchmark (bandwidth, checksums, ...).
+// Goes to stdout for text reports and to stderr for --format=json|csv.
+void BenchLog(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
 // Benchmark function signature
 typedef BenchResult (*BenchFunc)(uint64_t *array, size_t n);
 
+// Array contents a benchmark expects on entry. The harness prepares (and
+// caches) them, so results do not depend on which benchmark ran before.
+typedef enum {
+  kStateAny,           // Reads the array but does not depend on its values
+  kStateIdentity,      // array[i] == i
+  kStateRandomCycle,   // One random cycle: array[i] is the next slot
+  kStateRandomValues,  // Uniform values in [0, RAND_MAX]
+  kStateSorted,        // kStateRandomValues sorted ascending
+  kStateScratch,       // Overwrites the array; nothing may be assumed after
+  kStateLineCycle,     // Random cycle with one node per 64-byte line
+  kStatePageCycle,     // Random cycle with one node per 4 KiB page
+  kStateInPageCycle,   // Line cycle that visits every line of a page (in
+                       // random order) before moving to a random next page
+} ArrayState;
+
 // Benchmark registry entry
 typedef struct {
   const char *cli_name;    // Command line name (e.g., "seq")
   const char *description; // Help text description
   BenchFunc func;          // Function pointer
+  ArrayState input;        // Contents the harness prepares before each call
 } BenchEntry;
 
+#define MAX_BENCH_PARAMS 8
+
+// Typed integer parameter of a parameterized benchmark
+typedef struct {
+  const char *name;  // Command line key (e.g., "stride")
+  const char *help;  // Short description including the unit
+  int64_t def;       // Value used when the command line does not set it
+  int64_t min;       // Inclusive range accepted on the command line
+  int64_t max;
+  const char *const *names;  // Optional NULL-terminated names: value i may
+                             // be written names[i] (e.g. kernel=triad)
+} BenchParam;
+
+// Parameterized benchmark signature; params[i] is the value of the entry's
+// i-th BenchParam.
+typedef BenchResult (*BenchParamFunc)(uint64_t *array, size_t n,
+                                      const int64_t *params);
+
+// Parameterized registry entry, e.g. `bench tlb stride=4096,16384`
+typedef struct {
+  const char *cli_name;
+  const char *description;
+  BenchParamFunc func;
+  ArrayState input;
+  BenchParam params[MAX_BENCH_PARAMS];  // Unused slots have name == NULL
+} ParamBenchEntry;
+
 // Memory access benchmarks
 BenchResult BenchSequential(uint64_t *array, size_t n);
 BenchResult BenchRandom(uint64_t *array, size_t n);
 BenchResult BenchPointerChase(uint64_t *array, size_t n);
+BenchResult BenchChaseLine(uint64_t *array, size_t n);
+BenchResult BenchChasePage(uint64_t *array, size_t n);
+BenchResult BenchChaseInPage(uint64_t *array, size_t n);
 
 // Reduction benchmarks (ILP demonstration)
 BenchResult BenchReductionNaive(uint64_t *array, size_t n);
@@ -42,21 +160,35 @@ BenchResult BenchReductionThread(uint64_t *array, size_t n);
 BenchResult BenchReductionILPSimd(uint64_t *array, size_t n);
 BenchResult BenchReductionAll(uint64_t *array, size_t n);
 BenchResult BenchReductionOpt(uint64_t *array, size_t n);
+// Threaded sum (params: kernel, threads, schedule, chunk)
+BenchResult BenchReductionMt(uint64_t *array, size_t n,
+                             const int64_t *params);
 
-// Multi-chain pointer chase (MLP demonstration)
+// Multi-chain pointer chase (MLP demonstration). Chains per thread run
+// from 1 to MAX_CHASE_CHAINS.
+#define MAX_CHASE_CHAINS 128
 BenchResult BenchChase1(uint64_t *array, size_t n);
 BenchResult BenchChase2(uint64_t *array, size_t n);
 BenchResult BenchChase4(uint64_t *array, size_t n);
 BenchResult BenchChase8(uint64_t *array, size_t n);
 BenchResult BenchChase16(uint64_t *array, size_t n);
+// params: chains, threads
+BenchResult BenchChaseChains(uint64_t *array, size_t n, const int64_t *params);
 
 // Software prefetching
 BenchResult BenchPrefetchNone(uint64_t *array, size_t n);
+BenchResult BenchPrefetchDist(uint64_t *array, size_t n, const int64_t *params);
+BenchResult BenchSeqPrefetchDist(uint64_t *array, size_t n,
+                                 const int64_t *params);
 BenchResult BenchPrefetch8(uint64_t *array, size_t n);
 BenchResult BenchPrefetch32(uint64_t *array, size_t n);
 BenchResult BenchPrefetch128(uint64_t *array, size_t n);
 BenchResult BenchSeqPrefetchNone(uint64_t *array, size_t n);
 BenchResult BenchSeqPrefetch64(uint64_t *array, size_t n);
+// params: pattern (random, chase, strided), op (load, update), dist,
+// hint (nta, t2, t1, t0), intent (read, write), lines, stride
+BenchResult BenchPrefetchTune(uint64_t *array, size_t n,
+                              const int64_t *params);
 
 // False sharing
 BenchResult BenchFalseSharing(uint64_t *array, size_t n);
@@ -68,6 +200,10 @@ BenchResult BenchTlb64(uint64_t *array, size_t n);
 BenchResult BenchTlb512(uint64_t *array, size_t n);
 BenchResult BenchTlbPage(uint64_t *array, size_t n);
 BenchResult BenchTlb2Page(uint64_t *array, size_t n);
+BenchResult BenchTlbStride(uint64_t *array, size_t n, const int64_t *params);
+// One random line per page over `pages` pages, or the same lines packed
+// (params: pages, page, layout)
+BenchResult BenchTlbReach(uint64_t *array, size_t n, const int64_t *params);
 
 // Branch prediction
 BenchResult BenchBranchSorted(uint64_t *array, size_t n);
@@ -79,10 +215,50 @@ BenchResult BenchBw1(uint64_t *array, size_t n);
 BenchResult BenchBw2(uint64_t *array, size_t n);
 BenchResult BenchBw4(uint64_t *array, size_t n);
 BenchResult BenchBw8(uint64_t *array, size_t n);
+BenchResult BenchBwThreads(uint64_t *array, size_t n, const int64_t *params);
+
+// STREAM kernels over three thirds of the array (best ISA, 1 thread)
+BenchResult BenchStreamRead(uint64_t *array, size_t n);
+BenchResult BenchStreamWrite(uint64_t *array, size_t n);
+BenchResult BenchStreamCopy(uint64_t *array, size_t n);
+BenchResult BenchStreamScale(uint64_t *array, size_t n);
+BenchResult BenchStreamAdd(uint64_t *array, size_t n);
+BenchResult BenchStreamTriad(uint64_t *array, size_t n);
+// params: kernel, isa (auto, scalar, sse2, avx2, avx512), stores (cached, nt),
+// threads
+BenchResult BenchStream(uint64_t *array, size_t n, const int64_t *params);
+
+// Indexed loads: scalar vs hardware gathers (params: method, pattern, span)
+BenchResult BenchGather(uint64_t *array, size_t n, const int64_t *params);
+
+// Batched dependent lookups: naive, group prefetch, software pipelining,
+// AMAC (params: method, batch, depth, lengths)
+BenchResult BenchLookup(uint64_t *array, size_t n, const int64_t *params);
+
+// Atomic counter contention (params: op, order, layout, threads)
+BenchResult BenchAtomics(uint64_t *array, size_t n, const int64_t *params);
+
+// Core-to-core cache line transfer (params: cpu_a, cpu_b)
+BenchResult BenchPingPong(uint64_t *array, size_t n, const int64_t *params);
 
 // Store-to-load forwarding
 BenchResult BenchStoreFwdSame(uint64_t *array, size_t n);
 BenchResult BenchStoreFwdDiff(uint64_t *array, size_t n);
 BenchResult BenchStoreFwdNone(uint64_t *array, size_t n);
 
+// Write path: fill or copy `size` bytes with plain, streaming, rep, libc or
+// vector stores (params: op, method, size, misalign). Gigabytes per second
+// count the bytes written.
+#define WRITE_NUM_METHODS 6
+BenchResult BenchWrite(uint64_t *array, size_t n, const int64_t *params);
+// Whether this build and CPU can run write method `method`.
+int WriteMethodSupported(int method);
+
+// Set conflicts: a chase over `ways` addresses `stride` bytes apart
+// (params: ways, stride)
+BenchResult BenchAssoc(uint64_t *array, size_t n, const int64_t *params);
+// Copy whose stores land `delta` bytes past a 4 KiB multiple of the loads
+// (params: delta, a multiple of 8)
+BenchResult BenchAlias4k(uint64_t *array, size_t n, const int64_t *params);
+
 #endif
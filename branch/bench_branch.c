@@ -4,16 +4,15 @@
 #include <stdlib.h>
 #include <time.h>
 
-static int cmp(const void *a, const void *b) {
-  return (*(uint64_t *)a > *(uint64_t *)b) - (*(uint64_t *)a < *(uint64_t *)b);
-}
+// Inputs are prepared by the harness (see the entries in main.c): sorted
+// random values for br_sort, unsorted ones for br_rand and br_less, all
+// uniform in [0, RAND_MAX].
 
 BenchResult BenchBranchSorted(uint64_t *array, size_t n) {
-  qsort(array, n, sizeof(uint64_t), cmp);
   uint64_t threshold = array[n / 2];
 
-  struct timespec start, end;
-  clock_gettime(CLOCK_MONOTONIC, &start);
+  BenchTimer timer;
+  TimerStart(&timer);
 
   uint64_t sum = 0;
   for (size_t i = 0; i < n; i++) {
@@ -22,22 +21,18 @@ BenchResult BenchBranchSorted(uint64_t *array, size_t n) {
     Clobber();
   }
 
-  clock_gettime(CLOCK_MONOTONIC, &end);
+  uint64_t ns = TimerStop(&timer);
   Escape(&sum);
 
-  uint64_t ns = (end.tv_sec - start.tv_sec) * 1000000000ULL + (end.tv_nsec - start.tv_nsec);
-  return (BenchResult){"Branch sorted (predictable)", n, ns, (double)ns / n};
+  return (BenchResult){.name = "Branch sorted (predictable)", .iterations = n,
+                       .total_ns = ns, .ns_per_access = (double)ns / n};
 }
 
 BenchResult BenchBranchRandom(uint64_t *array, size_t n) {
-  srand(42);
-  for (size_t i = 0; i < n; i++)
-    array[i] = rand();
-
   uint64_t threshold = RAND_MAX / 2;
 
-  struct timespec start, end;
-  clock_gettime(CLOCK_MONOTONIC, &start);
+  BenchTimer timer;
+  TimerStart(&timer);
 
   uint64_t sum = 0;
   for (size_t i = 0; i < n; i++) {
@@ -46,22 +41,18 @@ BenchResult BenchBranchRandom(uint64_t *array, size_t n) {
     Clobber();
   }
 
-  clock_gettime(CLOCK_MONOTONIC, &end);
+  uint64_t ns = TimerStop(&timer);
   Escape(&sum);
 
-  uint64_t ns = (end.tv_sec - start.tv_sec) * 1000000000ULL + (end.tv_nsec - start.tv_nsec);
-  return (BenchResult){"Branch random (unpredictable)", n, ns, (double)ns / n};
+  return (BenchResult){.name = "Branch random (unpredictable)", .iterations = n,
+                       .total_ns = ns, .ns_per_access = (double)ns / n};
 }
 
 BenchResult BenchBranchless(uint64_t *array, size_t n) {
-  srand(42);
-  for (size_t i = 0; i < n; i++)
-    array[i] = rand();
-
   uint64_t threshold = RAND_MAX / 2;
 
-  struct timespec start, end;
-  clock_gettime(CLOCK_MONOTONIC, &start);
+  BenchTimer timer;
+  TimerStart(&timer);
 
   uint64_t sum = 0;
   for (size_t i = 0; i < n; i++) {
@@ -70,10 +61,10 @@ BenchResult BenchBranchless(uint64_t *array, size_t n) {
     Clobber();
   }
 
-  clock_gettime(CLOCK_MONOTONIC, &end);
+  uint64_t ns = TimerStop(&timer);
   Escape(&sum);
 
-  uint64_t ns = (end.tv_sec - start.tv_sec) * 1000000000ULL + (end.tv_nsec - start.tv_nsec);
-  return (BenchResult){"Branchless (mask)", n, ns, (double)ns / n};
+  return (BenchResult){.name = "Branchless (mask)", .iterations = n,
+                       .total_ns = ns, .ns_per_access = (double)ns / n};
 }
 
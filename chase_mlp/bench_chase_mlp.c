@@ -1,103 +1,130 @@
 #include "bench.h"
+#include "harness/array_state.h"
+#include "harness/pool.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
 
-static void BuildChain(uint64_t *array, size_t n, size_t *start_indices, size_t num_chains) {
-  size_t *indices = malloc(n * sizeof(size_t));
-  for (size_t i = 0; i < n; i++) indices[i] = i;
-
-  srand(42);
-  for (size_t i = n - 1; i > 0; i--) {
-    size_t j = rand() % (i + 1);
-    size_t tmp = indices[i];
-    indices[i] = indices[j];
-    indices[j] = tmp;
-  }
-
-  for (size_t i = 0; i < n - 1; i++) {
-    array[indices[i]] = indices[i + 1];
+// Walks `width` independent chains for `iters` hops each, starting from and
+// updating idx[0..width-1].
+typedef void (*ChaseKernel)(const uint64_t *array, size_t *idx, size_t iters);
+
+// One kernel per width: the chain loop is fully unrolled, so every hop is
+// its own load and nothing but the array links one hop to the next. Past
+// the register file the positions live on the stack; those loads hit L1
+// and stay independent across chains.
+#define DEFINE_CHASE(W)                                                 \
+  static void Chase##W(const uint64_t *array, size_t *idx,              \
+                       size_t iters) {                                  \
+    size_t p[W];                                                        \
+    for (size_t c = 0; c < W; c++) p[c] = idx[c];                       \
+    for (size_t i = 0; i < iters; i++) {                                \
+      _Pragma("GCC unroll 128") for (size_t c = 0; c < W; c++) {        \
+        p[c] = array[p[c]];                                             \
+      }                                                                 \
+      Clobber();                                                        \
+    }                                                                   \
+    for (size_t c = 0; c < W; c++) idx[c] = p[c];                       \
   }
-  array[indices[n - 1]] = indices[0];
 
-  size_t chunk = n / num_chains;
-  for (size_t c = 0; c < num_chains; c++) {
-    start_indices[c] = indices[c * chunk];
-  }
-  free(indices);
+#define CHASE_WIDTHS(X)                                                  \
+  X(1) X(2) X(3) X(4) X(5) X(6) X(7) X(8) X(9) X(10) X(11) X(12) X(13)   \
+  X(14) X(15) X(16) X(17) X(18) X(19) X(20) X(21) X(22) X(23) X(24)      \
+  X(25) X(26) X(27) X(28) X(29) X(30) X(31) X(32) X(33) X(34) X(35)      \
+  X(36) X(37) X(38) X(39) X(40) X(41) X(42) X(43) X(44) X(45) X(46)      \
+  X(47) X(48) X(49) X(50) X(51) X(52) X(53) X(54) X(55) X(56) X(57)      \
+  X(58) X(59) X(60) X(61) X(62) X(63) X(64) X(65) X(66) X(67) X(68)      \
+  X(69) X(70) X(71) X(72) X(73) X(74) X(75) X(76) X(77) X(78) X(79)      \
+  X(80) X(81) X(82) X(83) X(84) X(85) X(86) X(87) X(88) X(89) X(90)      \
+  X(91) X(92) X(93) X(94) X(95) X(96) X(97) X(98) X(99) X(100) X(101)   \
+  X(102) X(103) X(104) X(105) X(106) X(107) X(108) X(109) X(110) X(111)  \
+  X(112) X(113) X(114) X(115) X(116) X(117) X(118) X(119) X(120) X(121)  \
+  X(122) X(123) X(124) X(125) X(126) X(127) X(128)
+
+CHASE_WIDTHS(DEFINE_CHASE)
+
+#define CHASE_ENTRY(W) [W] = Chase##W,
+static const ChaseKernel kChaseKernels[MAX_CHASE_CHAINS + 1] = {
+    CHASE_WIDTHS(CHASE_ENTRY)};
+
+typedef struct {
+  const uint64_t *array;
+  size_t *idx;  // This thread's chains
+  size_t chains;
+  size_t iters;
+} ChaseArg;
+
+static void ChaseThread(void *p) {
+  ChaseArg *arg = p;
+  kChaseKernels[arg->chains](arg->array, arg->idx, arg->iters);
 }
 
-static BenchResult RunChase(uint64_t *array, size_t n, size_t num_chains, const char *name) {
-  size_t starts[16];
-  BuildChain(array, n, starts, num_chains);
-
-  size_t idx[16];
-  for (size_t c = 0; c < num_chains; c++) idx[c] = starts[c];
-
-  struct timespec start, end;
-  size_t iters = n / num_chains;
-
-  clock_gettime(CLOCK_MONOTONIC, &start);
-
-  switch (num_chains) {
-    case 1:
-      for (size_t i = 0; i < iters; i++) {
-        idx[0] = array[idx[0]];
-        Clobber();
-      }
-      break;
-    case 2:
-      for (size_t i = 0; i < iters; i++) {
-        idx[0] = array[idx[0]];
-        idx[1] = array[idx[1]];
-        Clobber();
-      }
-      break;
-    case 4:
-      for (size_t i = 0; i < iters; i++) {
-        idx[0] = array[idx[0]]; idx[1] = array[idx[1]];
-        idx[2] = array[idx[2]]; idx[3] = array[idx[3]];
-        Clobber();
-      }
-      break;
-    case 8:
-      for (size_t i = 0; i < iters; i++) {
-        idx[0] = array[idx[0]]; idx[1] = array[idx[1]];
-        idx[2] = array[idx[2]]; idx[3] = array[idx[3]];
-        idx[4] = array[idx[4]]; idx[5] = array[idx[5]];
-        idx[6] = array[idx[6]]; idx[7] = array[idx[7]];
-        Clobber();
-      }
-      break;
-    case 16:
-      for (size_t i = 0; i < iters; i++) {
-        idx[0] = array[idx[0]]; idx[1] = array[idx[1]];
-        idx[2] = array[idx[2]]; idx[3] = array[idx[3]];
-        idx[4] = array[idx[4]]; idx[5] = array[idx[5]];
-        idx[6] = array[idx[6]]; idx[7] = array[idx[7]];
-        idx[8] = array[idx[8]]; idx[9] = array[idx[9]];
-        idx[10] = array[idx[10]]; idx[11] = array[idx[11]];
-        idx[12] = array[idx[12]]; idx[13] = array[idx[13]];
-        idx[14] = array[idx[14]]; idx[15] = array[idx[15]];
-        Clobber();
-      }
-      break;
+// The array is one random cycle; every chain of every thread walks its own
+// disjoint, evenly spaced stretch of it.
+static BenchResult RunChase(uint64_t *array, size_t n, size_t num_chains,
+                            size_t num_threads, const char *name) {
+  BenchResult error = {0};
+  size_t total = num_chains * num_threads;
+  if (num_chains == 0 || num_chains > MAX_CHASE_CHAINS ||
+      total > MAX_CYCLE_MARKS) {
+    fprintf(stderr, "Chase: %zu chains x %zu threads exceeds %d chains per "
+                    "thread or %d in total\n",
+            num_chains, num_threads, MAX_CHASE_CHAINS, MAX_CYCLE_MARKS);
+    return error;
+  }
+  size_t *idx = malloc(total * sizeof(size_t));
+  ChaseArg *args = malloc(num_threads * sizeof(ChaseArg));
+  if (!idx || !args) {
+    fprintf(stderr, "Failed to allocate %zu chains\n", total);
+    free(idx);
+    free(args);
+    return error;
+  }
+  for (size_t c = 0; c < total; c++) idx[c] = CycleStart(c, total);
+  size_t iters = n / total;
+  for (size_t t = 0; t < num_threads; t++) {
+    args[t] = (ChaseArg){.array = array, .idx = idx + t * num_chains,
+                         .chains = num_chains, .iters = iters};
   }
 
-  clock_gettime(CLOCK_MONOTONIC, &end);
+  uint64_t ns;
+  if (num_threads == 1) {
+    BenchTimer timer;
+    TimerStart(&timer);
+    ChaseThread(&args[0]);
+    ns = TimerStop(&timer);
+  } else {
+    PoolTiming timing;
+    if (!PoolRun(num_threads, ChaseThread, args, sizeof(ChaseArg),
+                 &timing)) {
+      free(idx);
+      free(args);
+      return error;
+    }
+    ns = timing.span_ns;
+    BenchLog("  %zu chains x %zu threads (workers overlapped %.0f%% of "
+             "%.2f ms)\n",
+             num_chains, num_threads, 100.0 * PoolOverlap(&timing), ns / 1e6);
+  }
 
-  for (size_t c = 0; c < num_chains; c++) Escape(&idx[c]);
+  for (size_t c = 0; c < total; c++) Escape(&idx[c]);
+  free(idx);
+  free(args);
 
-  uint64_t ns = (end.tv_sec - start.tv_sec) * 1000000000ULL + (end.tv_nsec - start.tv_nsec);
-  size_t total_accesses = iters * num_chains;
+  size_t total_accesses = iters * total;
 
-  return (BenchResult){name, total_accesses, ns, (double)ns / total_accesses};
+  return (BenchResult){.name = name, .iterations = total_accesses,
+                       .total_ns = ns, .ns_per_access = (double)ns / total_accesses};
 }
 
-BenchResult BenchChase1(uint64_t *a, size_t n) { return RunChase(a, n, 1, "Chase 1 chain (MLP=1)"); }
-BenchResult BenchChase2(uint64_t *a, size_t n) { return RunChase(a, n, 2, "Chase 2 chains (MLP=2)"); }
-BenchResult BenchChase4(uint64_t *a, size_t n) { return RunChase(a, n, 4, "Chase 4 chains (MLP=4)"); }
-BenchResult BenchChase8(uint64_t *a, size_t n) { return RunChase(a, n, 8, "Chase 8 chains (MLP=8)"); }
-BenchResult BenchChase16(uint64_t *a, size_t n) { return RunChase(a, n, 16, "Chase 16 chains (MLP=16)"); }
+BenchResult BenchChase1(uint64_t *a, size_t n) { return RunChase(a, n, 1, 1, "Chase 1 chain (MLP=1)"); }
+BenchResult BenchChase2(uint64_t *a, size_t n) { return RunChase(a, n, 2, 1, "Chase 2 chains (MLP=2)"); }
+BenchResult BenchChase4(uint64_t *a, size_t n) { return RunChase(a, n, 4, 1, "Chase 4 chains (MLP=4)"); }
+BenchResult BenchChase8(uint64_t *a, size_t n) { return RunChase(a, n, 8, 1, "Chase 8 chains (MLP=8)"); }
+BenchResult BenchChase16(uint64_t *a, size_t n) { return RunChase(a, n, 16, 1, "Chase 16 chains (MLP=16)"); }
 
+
+BenchResult BenchChaseChains(uint64_t *a, size_t n, const int64_t *params) {
+  return RunChase(a, n, (size_t)params[0], (size_t)params[1], "Chase chains");
+}
@@ -0,0 +1,92 @@
+#include "bench.h"
+#include "harness/numa.h"
+#include "harness/pool.h"
+
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <time.h>
+
+#define CACHE_LINE 64
+#define ROUNDS (1u << 16)
+
+// The line that bounces between the two CPUs, alone in its cache line.
+static _Alignas(CACHE_LINE) atomic_uint_fast64_t g_flag;
+
+typedef struct {
+  int initiator;
+  uint64_t rounds;
+} PingArg;
+
+// Spins until the flag reads `value`, yielding now and then so a pair
+// sharing one CPU still makes progress.
+static inline void WaitFor(uint64_t value) {
+  for (unsigned spins = 1;
+       atomic_load_explicit(&g_flag, memory_order_acquire) != value;
+       spins++) {
+    if (spins % 1024 == 0) sched_yield();
+  }
+}
+
+// The initiator writes odd values and waits for the even reply; each round
+// trip moves the line to the other core and back.
+static void PingPong(void *arg) {
+  PingArg *pa = arg;
+  for (uint64_t r = 0; r < pa->rounds; r++) {
+    if (pa->initiator) {
+      atomic_store_explicit(&g_flag, 2 * r + 1, memory_order_release);
+      WaitFor(2 * r + 2);
+    } else {
+      WaitFor(2 * r + 1);
+      atomic_store_explicit(&g_flag, 2 * r + 2, memory_order_release);
+    }
+  }
+}
+
+BenchResult BenchPingPong(uint64_t *array, size_t n, const int64_t *params) {
+  (void)array;
+  (void)n;
+
+  // Worker 0 initiates on cpu_a, worker 1 answers on cpu_b; --cpus is put
+  // back afterwards.
+  BenchResult error = {0};
+  int pair[2] = {(int)params[0], (int)params[1]};
+  if (pair[0] == pair[1]) {
+    fprintf(stderr, "Ping-pong: cpu_a and cpu_b are both CPU %d\n", pair[0]);
+    return error;
+  }
+  int usable[MAX_CPUS];
+  int num_usable = GetLaunchCpus(usable, MAX_CPUS);
+  for (int p = 0; p < 2; p++) {
+    int found = 0;
+    for (int i = 0; i < num_usable && !found; i++) found = usable[i] == pair[p];
+    if (!found) {
+      fprintf(stderr, "Ping-pong: CPU %d is not available to this process\n",
+              pair[p]);
+      return error;
+    }
+  }
+  int saved[MAX_CPUS];
+  int num_saved = GetWorkerCpus(saved, MAX_CPUS);
+  SetWorkerCpus(pair, 2);
+
+  atomic_store(&g_flag, 0);
+  PingArg args[2] = {{.initiator = 1, .rounds = ROUNDS},
+                     {.initiator = 0, .rounds = ROUNDS}};
+  int ok = PoolReserve(2);
+  PoolTiming timing;
+  BenchTimer timer;
+  TimerStart(&timer);
+  ok = ok && PoolRun(2, PingPong, args, sizeof(PingArg), &timing);
+  TimerStop(&timer);
+  SetWorkerCpus(saved, num_saved);
+  if (!ok) return error;
+
+  uint64_t ns = timing.span_ns;
+  BenchLog("  CPU %d <-> CPU %d: %.1f ns round trip, %.1f ns one way\n",
+           pair[0], pair[1], (double)ns / ROUNDS, (double)ns / ROUNDS / 2);
+
+  return (BenchResult){.name = "Cache line ping-pong (round trip)",
+                       .iterations = ROUNDS, .total_ns = ns,
+                       .ns_per_access = (double)ns / ROUNDS};
+}
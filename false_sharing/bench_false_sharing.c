@@ -1,6 +1,6 @@
 #include "bench.h"
+#include "harness/pool.h"
 
-#include <pthread.h>
 #include <stdio.h>
 #include <time.h>
 
@@ -19,7 +19,7 @@ typedef struct {
   int use_padded;
 } ThreadArg;
 
-static void *CounterThread(void *arg) {
+static void CounterThread(void *arg) {
   ThreadArg *ta = (ThreadArg *)arg;
   size_t iters = ta->iterations;
   size_t tid = ta->thread_id;
@@ -35,7 +35,6 @@ static void *CounterThread(void *arg) {
       (*p)++;
     }
   }
-  return NULL;
 }
 
 static BenchResult RunContention(uint64_t *array, size_t n, int use_padded, const char *name) {
@@ -47,34 +46,41 @@ static BenchResult RunContention(uint64_t *array, size_t n, int use_padded, cons
   }
 
   size_t iters_per_thread = n * 10;
-  pthread_t threads[NUM_THREADS];
   ThreadArg args[NUM_THREADS];
-
-  struct timespec start, end;
-  clock_gettime(CLOCK_MONOTONIC, &start);
-
   for (int t = 0; t < NUM_THREADS; t++) {
     args[t].thread_id = t;
     args[t].iterations = iters_per_thread;
     args[t].use_padded = use_padded;
-    pthread_create(&threads[t], NULL, CounterThread, &args[t]);
   }
 
+  if (!PoolReserve(NUM_THREADS)) {
+    BenchResult error = {0};
+    return error;
+  }
+  PoolTiming timing = {0};
+  BenchTimer timer;
+  TimerStart(&timer);
+  int ok = PoolRun(NUM_THREADS, CounterThread, args, sizeof(ThreadArg),
+                   &timing);
+  TimerStop(&timer);
+  if (!ok) {
+    BenchResult error = {0};
+    return error;
+  }
+  uint64_t ns = timing.span_ns;
+
   uint64_t total = 0;
   for (int t = 0; t < NUM_THREADS; t++) {
-    pthread_join(threads[t], NULL);
     total += use_padded ? g_padded[t].count : g_packed[t].count;
   }
 
-  clock_gettime(CLOCK_MONOTONIC, &end);
-
   Escape(&total);
-  printf("  Total count: %lu\n", total);
+  BenchLog("  Total count: %lu\n", total);
 
-  uint64_t ns = (end.tv_sec - start.tv_sec) * 1000000000ULL + (end.tv_nsec - start.tv_nsec);
   size_t total_ops = iters_per_thread * NUM_THREADS;
 
-  return (BenchResult){name, total_ops, ns, (double)ns / total_ops};
+  return (BenchResult){.name = name, .iterations = total_ops,
+                       .total_ns = ns, .ns_per_access = (double)ns / total_ops};
 }
 
 BenchResult BenchFalseSharing(uint64_t *a, size_t n) {
@@ -0,0 +1,167 @@
+#include "bench.h"
+#include "harness/cpu_isa.h"
+#include "harness/parallel.h"
+#include "harness/rng.h"
+#include "harness/units.h"
+
+#include <stdio.h>
+#include <time.h>
+
+#if ISA_X86
+#include <immintrin.h>
+#endif
+
+// Lookups per trial are capped so small tables still run quickly.
+#define MAX_LOOKUPS ((size_t)1 << 24)
+// Clustered lookups come in groups that share one 4 KiB page.
+#define CLUSTER_LOOKUPS 8
+#define CLUSTER_ELEMS 512
+#define GATHER_STREAM 0x6761746865720000ULL  // "gather"
+
+// Parameter values, in the order of the names registered in main.c.
+enum { kMethodScalar, kMethodAvx2, kMethodAvx512 };
+enum { kPatternRandom, kPatternClustered, kPatternSequential };
+
+static const char *const kMethodNames[] = {"scalar loads", "AVX2 vpgatherqq",
+                                           "AVX-512 vpgatherqq"};
+static const Isa kMethodIsas[] = {kIsaScalar, kIsaAvx2, kIsaAvx512};
+static const char *const kPatternNames[] = {"random", "clustered",
+                                            "sequential"};
+
+typedef uint64_t (*GatherFunc)(const uint64_t *table, const uint64_t *idx,
+                               size_t count);
+
+// One load per index; kept scalar so the baseline is what a plain loop
+// over a dictionary compiles to without gathers.
+__attribute__((optimize("no-tree-vectorize"))) static uint64_t GatherScalar(
+    const uint64_t *table, const uint64_t *idx, size_t count) {
+  uint64_t s0 = 0, s1 = 0;
+  size_t i = 0;
+  for (; i + 2 <= count; i += 2) {
+    s0 += table[idx[i]];
+    s1 += table[idx[i + 1]];
+  }
+  for (; i < count; i++) s0 += table[idx[i]];
+  return s0 + s1;
+}
+
+#if ISA_X86
+ISA_TARGET_AVX2 static uint64_t GatherAvx2(const uint64_t *table,
+                                           const uint64_t *idx,
+                                           size_t count) {
+  const long long *base = (const long long *)table;
+  __m256i s0 = _mm256_setzero_si256(), s1 = _mm256_setzero_si256();
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256i i0 = _mm256_loadu_si256((const __m256i *)(idx + i));
+    __m256i i1 = _mm256_loadu_si256((const __m256i *)(idx + i + 4));
+    s0 = _mm256_add_epi64(s0, _mm256_i64gather_epi64(base, i0, 8));
+    s1 = _mm256_add_epi64(s1, _mm256_i64gather_epi64(base, i1, 8));
+  }
+  uint64_t tmp[4];
+  _mm256_storeu_si256((__m256i *)tmp, _mm256_add_epi64(s0, s1));
+  uint64_t sum = tmp[0] + tmp[1] + tmp[2] + tmp[3];
+  for (; i < count; i++) sum += table[idx[i]];
+  return sum;
+}
+
+ISA_TARGET_AVX512 static uint64_t GatherAvx512(const uint64_t *table,
+                                               const uint64_t *idx,
+                                               size_t count) {
+  __m512i s0 = _mm512_setzero_si512(), s1 = _mm512_setzero_si512();
+  size_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    __m512i i0 = _mm512_loadu_si512(idx + i);
+    __m512i i1 = _mm512_loadu_si512(idx + i + 8);
+    s0 = _mm512_add_epi64(s0, _mm512_i64gather_epi64(i0, table, 8));
+    s1 = _mm512_add_epi64(s1, _mm512_i64gather_epi64(i1, table, 8));
+  }
+  uint64_t sum = _mm512_reduce_add_epi64(_mm512_add_epi64(s0, s1));
+  for (; i < count; i++) sum += table[idx[i]];
+  return sum;
+}
+#endif
+
+// Indexed by method; only methods the CPU supports are ever selected.
+static const GatherFunc kGathers[] = {
+    [kMethodScalar] = GatherScalar,
+#if ISA_X86
+    [kMethodAvx2] = GatherAvx2,
+    [kMethodAvx512] = GatherAvx512,
+#endif
+};
+
+// Fills table[i] = i and writes `count` indices into [0, entries).
+// Returns their sum, the answer every method must reproduce.
+static uint64_t BuildLookups(uint64_t *table, size_t entries, uint64_t *idx,
+                             size_t count, int pattern) {
+  ParallelFillIdentity(table, entries);
+  Rng rng;
+  RngSeed(&rng, BenchSeed(), GATHER_STREAM | pattern);
+  uint64_t expected = 0;
+  size_t page = 0;
+  for (size_t i = 0; i < count; i++) {
+    switch (pattern) {
+      case kPatternClustered:
+        if (i % CLUSTER_LOOKUPS == 0) {
+          size_t pages = (entries + CLUSTER_ELEMS - 1) / CLUSTER_ELEMS;
+          page = RngBounded(&rng, pages) * CLUSTER_ELEMS;
+        }
+        idx[i] = page + RngBounded(&rng, CLUSTER_ELEMS);
+        if (idx[i] >= entries) idx[i] = RngBounded(&rng, entries);
+        break;
+      case kPatternSequential: idx[i] = i % entries; break;
+      default: idx[i] = RngBounded(&rng, entries); break;
+    }
+    expected += idx[i];
+  }
+  return expected;
+}
+
+// The first part of the array is the table; the indices follow it. By
+// default the table takes half the array; `span_bytes` shrinks it to fit
+// a chosen cache level.
+static BenchResult RunGather(uint64_t *array, size_t n, int method,
+                             int pattern, size_t span_bytes) {
+  BenchResult error = {0};
+  if (!IsaSupported(kMethodIsas[method])) {
+    fprintf(stderr, "Gather: this CPU cannot run %s\n", kMethodNames[method]);
+    return error;
+  }
+  size_t entries = span_bytes ? span_bytes / sizeof(uint64_t) : n / 2;
+  if (entries > n / 2) entries = n / 2;
+  if (entries == 0 || n - entries < 16) {
+    fprintf(stderr, "Gather: array too small for a %zu-byte table\n",
+            span_bytes);
+    return error;
+  }
+  uint64_t *idx = array + entries;
+  size_t count = n - entries;
+  if (count > MAX_LOOKUPS) count = MAX_LOOKUPS;
+  uint64_t expected = BuildLookups(array, entries, idx, count, pattern);
+
+  BenchTimer timer;
+  TimerStart(&timer);
+  uint64_t sum = kGathers[method](array, idx, count);
+  uint64_t ns = TimerStop(&timer);
+  Escape(&sum);
+
+  char table[32];
+  BenchLog("  %s, %s indices into a %s table\n", kMethodNames[method],
+           kPatternNames[pattern],
+           FormatBytes(entries * sizeof(uint64_t), table, sizeof(table)));
+  BenchLog("  Lookups: %.1f M/s\n", count * 1e3 / (double)ns);
+  if (sum != expected) {
+    fprintf(stderr, "Gather: %s returned a wrong sum\n",
+            kMethodNames[method]);
+    return error;
+  }
+
+  return (BenchResult){.name = "Gather", .iterations = count,
+                       .total_ns = ns, .ns_per_access = (double)ns / count};
+}
+
+BenchResult BenchGather(uint64_t *array, size_t n, const int64_t *params) {
+  return RunGather(array, n, (int)params[0], (int)params[1],
+                   (size_t)params[2]);
+}
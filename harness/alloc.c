@@ -0,0 +1,144 @@
+#define _GNU_SOURCE
+#include "harness/alloc.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
+
+#define SIZE_2M ((size_t)2 << 20)
+#define SIZE_1G ((size_t)1 << 30)
+
+static const char *kPolicyNames[] = {"default", "4k", "thp", "2m", "1g"};
+
+int ParsePagePolicy(const char *name, PagePolicy *out) {
+  for (size_t i = 0; i < sizeof(kPolicyNames) / sizeof(kPolicyNames[0]); i++) {
+    if (strcmp(name, kPolicyNames[i]) == 0) {
+      *out = (PagePolicy)i;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+const char *PagePolicyName(PagePolicy policy) { return kPolicyNames[policy]; }
+
+static size_t RoundUp(size_t bytes, size_t align) {
+  return (bytes + align - 1) & ~(align - 1);
+}
+
+// hugetlbfs mappings must be a multiple of their page size.
+static size_t MappingSize(size_t bytes, PagePolicy policy) {
+  switch (policy) {
+    case kPages2M: return RoundUp(bytes, SIZE_2M);
+    case kPages1G: return RoundUp(bytes, SIZE_1G);
+    default: return RoundUp(bytes, 4096);
+  }
+}
+
+// Anonymous mapping aligned to 2 MiB: over-map, then trim both ends.
+static void *MapAligned(size_t size) {
+  size_t padded = size + SIZE_2M;
+  uint8_t *raw = mmap(NULL, padded, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (raw == MAP_FAILED) return NULL;
+  uint8_t *aligned = (uint8_t *)RoundUp((uintptr_t)raw, SIZE_2M);
+  if (aligned > raw) munmap(raw, aligned - raw);
+  size_t tail = (raw + padded) - (aligned + size);
+  if (tail) munmap(aligned + size, tail);
+  return aligned;
+}
+
+void *AllocArray(size_t bytes, PagePolicy policy) {
+  size_t size = MappingSize(bytes, policy);
+  void *p;
+
+  if (policy == kPages2M || policy == kPages1G) {
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB |
+                (policy == kPages2M ? MAP_HUGE_2MB : MAP_HUGE_1GB);
+    p = mmap(NULL, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (p == MAP_FAILED) {
+      fprintf(stderr,
+              "Failed to map %zu bytes of %s hugetlbfs pages: %s\n"
+              "(reserve them via /sys/kernel/mm/hugepages/hugepages-%s/"
+              "nr_hugepages)\n",
+              size, policy == kPages2M ? "2 MiB" : "1 GiB", strerror(errno),
+              policy == kPages2M ? "2048kB" : "1048576kB");
+      return NULL;
+    }
+    return p;
+  }
+
+  p = MapAligned(size);
+  if (!p) {
+    fprintf(stderr, "Failed to map %zu bytes: %s\n", size, strerror(errno));
+    return NULL;
+  }
+  if (policy == kPages4K && madvise(p, size, MADV_NOHUGEPAGE) != 0) {
+    fprintf(stderr, "madvise(MADV_NOHUGEPAGE) failed: %s\n", strerror(errno));
+  }
+  if (policy == kPagesThp && madvise(p, size, MADV_HUGEPAGE) != 0) {
+    fprintf(stderr, "madvise(MADV_HUGEPAGE) failed: %s (THP disabled?)\n",
+            strerror(errno));
+  }
+  return p;
+}
+
+void FreeArray(void *array, size_t bytes, PagePolicy policy) {
+  if (array) munmap(array, MappingSize(bytes, policy));
+}
+
+int QueryPageBacking(const void *addr, PageBacking *out) {
+  memset(out, 0, sizeof(*out));
+  FILE *f = fopen("/proc/self/smaps", "r");
+  if (!f) return 0;
+
+  char line[256];
+  int in_mapping = 0, found = 0;
+  uintptr_t target = (uintptr_t)addr;
+  while (fgets(line, sizeof(line), f)) {
+    unsigned long start, end;
+    char perms[8];
+    // Mapping headers look like "7f12...-7f34... rw-p ..."; field lines
+    // ("Rss:   4 kB") never match the "hex-hex" prefix.
+    if (sscanf(line, "%lx-%lx %7s", &start, &end, perms) == 3) {
+      if (in_mapping) break;
+      in_mapping = (target >= start && target < end);
+      found |= in_mapping;
+      continue;
+    }
+    if (!in_mapping) continue;
+
+    char key[64];
+    unsigned long kb;
+    if (sscanf(line, "%63[^:]: %lu kB", key, &kb) != 2) continue;
+    size_t bytes = (size_t)kb << 10;
+    if (strcmp(key, "KernelPageSize") == 0) out->kernel_page_size = bytes;
+    if (strcmp(key, "Rss") == 0) out->rss_bytes = bytes;
+    if (strcmp(key, "AnonHugePages") == 0) out->thp_bytes = bytes;
+    if (strcmp(key, "Private_Hugetlb") == 0 ||
+        strcmp(key, "Shared_Hugetlb") == 0) {
+      out->hugetlb_bytes += bytes;
+    }
+  }
+  fclose(f);
+  return found;
+}
+
+double HugePageFraction(const PageBacking *backing) {
+  size_t huge = backing->thp_bytes + backing->hugetlb_bytes;
+  // hugetlbfs memory is not included in Rss.
+  size_t total = backing->rss_bytes + backing->hugetlb_bytes;
+  return total ? (double)huge / (double)total : 0.0;
+}
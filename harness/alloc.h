@@ -0,0 +1,39 @@
+#ifndef HARNESS_ALLOC_H_
+#define HARNESS_ALLOC_H_
+
+#include <stddef.h>
+
+// How the benchmark array is backed by pages.
+typedef enum {
+  kPagesDefault,  // Anonymous mapping; the host's THP policy decides
+  kPages4K,       // madvise(MADV_NOHUGEPAGE): base pages only
+  kPagesThp,      // madvise(MADV_HUGEPAGE): transparent huge pages
+  kPages2M,       // MAP_HUGETLB with 2 MiB pages from hugetlbfs
+  kPages1G,       // MAP_HUGETLB with 1 GiB pages from hugetlbfs
+} PagePolicy;
+
+// What actually backs a mapping, from /proc/self/smaps.
+typedef struct {
+  size_t kernel_page_size;  // KernelPageSize of the mapping
+  size_t rss_bytes;         // Resident base-page-accounted memory
+  size_t thp_bytes;         // AnonHugePages
+  size_t hugetlb_bytes;     // Private_Hugetlb + Shared_Hugetlb
+} PageBacking;
+
+// Accepts "default", "4k", "thp", "2m" or "1g". Returns 0 otherwise.
+int ParsePagePolicy(const char *name, PagePolicy *out);
+const char *PagePolicyName(PagePolicy policy);
+
+// Maps `bytes` (rounded up to the page size) with the given policy,
+// aligned to 2 MiB so THP can back the whole range. Prints why and returns
+// NULL on failure, e.g. when no hugetlbfs pages are reserved.
+void *AllocArray(size_t bytes, PagePolicy policy);
+void FreeArray(void *array, size_t bytes, PagePolicy policy);
+
+// Looks up the mapping containing `addr`. Returns 0 if smaps is unreadable.
+int QueryPageBacking(const void *addr, PageBacking *out);
+
+// Fraction of the resident mapping held in huge pages (THP or hugetlbfs).
+double HugePageFraction(const PageBacking *backing);
+
+#endif
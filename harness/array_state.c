@@ -0,0 +1,373 @@
+#include "harness/array_state.h"
+
+#include "harness/parallel.h"
+#include "harness/rng.h"
+#include "harness/units.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX_CACHE_ENTRIES 16
+
+// Random values are drawn per fixed-size block so the fill is the same for
+// any number of setup threads.
+#define FILL_BLOCK ((size_t)1 << 16)
+
+// Stream tag for the per-page layout draws of the sparse cycles, keeping
+// them apart from the FillRandom() streams.
+#define LAYOUT_STREAM ((uint64_t)1 << 62)
+
+typedef enum {
+  kCachedCycle,        // Linked cycle followed by MAX_CYCLE_MARKS start slots
+                       // (one entry per cycle state)
+  kCachedSorted,       // Sorted random values
+  kCachedPermutation,  // Shared AcquirePermutation() result
+} CacheKind;
+
+typedef struct {
+  int used;
+  CacheKind kind;
+  ArrayState state;  // Which cycle, for kCachedCycle
+  size_t n;
+  uint64_t seed;
+  void *data;
+  size_t bytes;
+  uint64_t last_use;
+  int refs;  // Outstanding AcquirePermutation() handles; pinned while > 0
+} CacheEntry;
+
+static CacheEntry g_cache[MAX_CACHE_ENTRIES];
+static size_t g_cache_bytes;
+static size_t g_budget;
+static int g_budget_set;
+static uint64_t g_clock;
+
+// What the benchmark array holds right now.
+static struct {
+  const uint64_t *array;
+  size_t n;
+  ArrayState state;
+  uint64_t seed;
+} g_current;
+static size_t g_marks[MAX_CYCLE_MARKS];
+
+static const char *kStateNames[] = {"any",          "identity",
+                                    "random cycle", "random values",
+                                    "sorted values", "scratch",
+                                    "line cycle",   "page cycle",
+                                    "in-page line cycle"};
+
+// MemAvailable from /proc/meminfo, or free pages if it is missing.
+static size_t AvailableMemory(void) {
+  FILE *f = fopen("/proc/meminfo", "r");
+  if (f) {
+    char line[256];
+    unsigned long long kb;
+    while (fgets(line, sizeof(line), f)) {
+      if (sscanf(line, "MemAvailable: %llu kB", &kb) == 1) {
+        fclose(f);
+        return (size_t)kb * 1024;
+      }
+    }
+    fclose(f);
+  }
+  long pages = sysconf(_SC_AVPHYS_PAGES);
+  long page_size = sysconf(_SC_PAGESIZE);
+  return pages > 0 && page_size > 0 ? (size_t)pages * page_size : 0;
+}
+
+void SetStateCacheBudget(size_t bytes) {
+  g_budget = bytes;
+  g_budget_set = 1;
+}
+
+static size_t Budget(void) {
+  if (!g_budget_set) SetStateCacheBudget(AvailableMemory() / 2);
+  return g_budget;
+}
+
+static CacheEntry *Lookup(CacheKind kind, ArrayState state, size_t n,
+                          uint64_t seed) {
+  for (int i = 0; i < MAX_CACHE_ENTRIES; i++) {
+    CacheEntry *e = &g_cache[i];
+    if (e->used && e->kind == kind && e->state == state && e->n == n &&
+        e->seed == seed) {
+      e->last_use = ++g_clock;
+      return e;
+    }
+  }
+  return NULL;
+}
+
+static void Evict(CacheEntry *e) {
+  free(e->data);
+  g_cache_bytes -= e->bytes;
+  memset(e, 0, sizeof(*e));
+}
+
+// Allocates a cache slot of `bytes`, evicting least recently used entries.
+// Returns NULL (caching nothing) when the budget cannot make room.
+static CacheEntry *Insert(CacheKind kind, ArrayState state, size_t n,
+                          uint64_t seed, size_t bytes) {
+  if (bytes > Budget()) return NULL;
+  for (;;) {
+    CacheEntry *free_slot = NULL;
+    CacheEntry *oldest = NULL;
+    for (int i = 0; i < MAX_CACHE_ENTRIES; i++) {
+      CacheEntry *e = &g_cache[i];
+      if (!e->used) {
+        if (!free_slot) free_slot = e;
+      } else if (e->refs == 0 &&
+                 (!oldest || e->last_use < oldest->last_use)) {
+        oldest = e;
+      }
+    }
+    if (free_slot && g_cache_bytes + bytes <= g_budget) {
+      void *data = malloc(bytes);
+      if (!data) return NULL;
+      *free_slot = (CacheEntry){.used = 1, .kind = kind, .state = state,
+                                .n = n, .seed = seed, .data = data,
+                                .bytes = bytes, .last_use = ++g_clock};
+      g_cache_bytes += bytes;
+      return free_slot;
+    }
+    if (!oldest) return NULL;
+    Evict(oldest);
+  }
+}
+
+static void FillRandom(size_t begin, size_t end, void *ctx) {
+  uint64_t *array = ctx;
+  for (size_t block = begin / FILL_BLOCK; block * FILL_BLOCK < end; block++) {
+    Rng rng;
+    RngSeed(&rng, BenchSeed(), block);
+    size_t lo = block * FILL_BLOCK;
+    size_t hi = lo + FILL_BLOCK;
+    for (size_t i = lo; i < hi; i++) {
+      uint64_t v = RngBounded(&rng, (uint64_t)RAND_MAX + 1);
+      if (i >= begin && i < end) array[i] = v;
+    }
+  }
+}
+
+// Returns "built", "restored" or NULL on failure.
+static const char *PrepareSorted(uint64_t *array, size_t n, uint64_t seed) {
+  CacheEntry *e = Lookup(kCachedSorted, kStateAny, n, seed);
+  if (e) {
+    ParallelCopy(array, e->data, n);
+    return "restored";
+  }
+  ParallelFor(n, FillRandom, array);
+  ParallelSortU64(array, n);
+  e = Insert(kCachedSorted, kStateAny, n, seed, n * sizeof(uint64_t));
+  if (e) ParallelCopy(e->data, array, n);
+  return "built";
+}
+
+size_t CycleNodes(size_t n, ArrayState state) {
+  const size_t lines_per_page = CYCLE_PAGE_SLOTS / CYCLE_LINE_SLOTS;
+  size_t pages = n / CYCLE_PAGE_SLOTS;
+  size_t nodes = n;
+  // Arrays below one page fall back to the line cycle.
+  if (state == kStatePageCycle && pages > 0) {
+    nodes = pages;
+  } else if (state == kStateInPageCycle && pages > 0) {
+    nodes = pages * lines_per_page;
+  } else if (state != kStateRandomCycle) {
+    nodes = n / CYCLE_LINE_SLOTS;
+  }
+  return nodes > 0 ? nodes : 1;
+}
+
+typedef struct {
+  size_t *order;
+  const size_t *pages;  // Random page order
+  uint64_t seed;
+  ArrayState state;
+} LayoutCtx;
+
+// Turns a permutation of page numbers into slot order: one random line per
+// page (kStatePageCycle) or all lines of each page shuffled
+// (kStateInPageCycle). Each page draws from its own stream.
+static void LayoutPages(size_t begin, size_t end, void *arg) {
+  LayoutCtx *c = arg;
+  const size_t lines = CYCLE_PAGE_SLOTS / CYCLE_LINE_SLOTS;
+  for (size_t k = begin; k < end; k++) {
+    size_t page = c->pages[k];
+    size_t base = page * CYCLE_PAGE_SLOTS;
+    Rng rng;
+    RngSeed(&rng, c->seed, LAYOUT_STREAM | page);
+    if (c->state == kStatePageCycle) {
+      c->order[k] = base + RngBounded(&rng, lines) * CYCLE_LINE_SLOTS;
+      continue;
+    }
+    size_t *out = c->order + k * lines;
+    for (size_t j = 0; j < lines; j++) out[j] = j;
+    for (size_t j = lines - 1; j > 0; j--) {
+      size_t r = RngBounded(&rng, j + 1);
+      size_t t = out[j];
+      out[j] = out[r];
+      out[r] = t;
+    }
+    for (size_t j = 0; j < lines; j++) {
+      out[j] = base + out[j] * CYCLE_LINE_SLOTS;
+    }
+  }
+}
+
+static void ScaleToLines(size_t begin, size_t end, void *arg) {
+  size_t *order = arg;
+  for (size_t i = begin; i < end; i++) order[i] *= CYCLE_LINE_SLOTS;
+}
+
+// Slots of `state`'s cycle in visiting order (CycleNodes() entries). Linking
+// a uniform random order into a ring gives the same single-cycle
+// distribution as Sattolo's algorithm, but can be built in parallel.
+static size_t *CycleOrder(size_t n, uint64_t seed, ArrayState state) {
+  size_t nodes = CycleNodes(n, state);
+  if (state == kStateLineCycle) {
+    size_t *order = RandomPermutation(nodes, seed);
+    if (order) ParallelFor(nodes, ScaleToLines, order);
+    return order;
+  }
+  if (state != kStatePageCycle && state != kStateInPageCycle) {
+    return RandomPermutation(nodes, seed);
+  }
+  if (n < CYCLE_PAGE_SLOTS) return CycleOrder(n, seed, kStateLineCycle);
+  size_t num_pages = n / CYCLE_PAGE_SLOTS;
+  size_t *pages = RandomPermutation(num_pages, seed);
+  size_t *order = malloc(nodes * sizeof(size_t));
+  if (!pages || !order) {
+    free(pages);
+    free(order);
+    return NULL;
+  }
+  LayoutCtx c = {.order = order, .pages = pages, .seed = seed,
+                 .state = state};
+  ParallelFor(num_pages, LayoutPages, &c);
+  free(pages);
+  return order;
+}
+
+static const char *PrepareCycle(uint64_t *array, size_t n, uint64_t seed,
+                                ArrayState state) {
+  CacheEntry *e = Lookup(kCachedCycle, state, n, seed);
+  if (e) {
+    ParallelCopy(array, e->data, n);
+    memcpy(g_marks, (uint64_t *)e->data + n, sizeof(g_marks));
+    return "restored";
+  }
+
+  // The dense cycle can reuse a shared permutation when one is cached.
+  size_t nodes = CycleNodes(n, state);
+  CacheEntry *perm_entry =
+      state == kStateRandomCycle
+          ? Lookup(kCachedPermutation, kStateAny, n, seed)
+          : NULL;
+  size_t *order = perm_entry ? perm_entry->data : CycleOrder(n, seed, state);
+  if (!order) return NULL;
+  LinkCycle(array, order, nodes);
+  for (size_t m = 0; m < MAX_CYCLE_MARKS; m++) {
+    g_marks[m] = order[m * nodes / MAX_CYCLE_MARKS];
+  }
+  if (!perm_entry) free(order);
+
+  e = Insert(kCachedCycle, state, n, seed,
+             n * sizeof(uint64_t) + sizeof(g_marks));
+  if (e) {
+    ParallelCopy(e->data, array, n);
+    memcpy((uint64_t *)e->data + n, g_marks, sizeof(g_marks));
+  }
+  return "built";
+}
+
+void PrepareArray(uint64_t *array, size_t n, ArrayState state) {
+  if (state == kStateAny) return;
+  if (state == kStateScratch) {
+    ForgetArrayState(array);
+    return;
+  }
+  uint64_t seed = BenchSeed();
+  if (g_current.array == array && g_current.n == n &&
+      g_current.state == state && g_current.seed == seed) {
+    return;
+  }
+
+  uint64_t start = NowNs();
+  const char *how = "built";
+  switch (state) {
+    case kStateIdentity: ParallelFillIdentity(array, n); break;
+    case kStateRandomValues: ParallelFor(n, FillRandom, array); break;
+    case kStateSorted: how = PrepareSorted(array, n, seed); break;
+    case kStateRandomCycle:
+    case kStateLineCycle:
+    case kStatePageCycle:
+    case kStateInPageCycle: how = PrepareCycle(array, n, seed, state); break;
+    default: break;
+  }
+  if (!how) {
+    // Leave the array marked unknown; the benchmark will see garbage, but
+    // the allocation failure has already been reported.
+    ForgetArrayState(array);
+    return;
+  }
+  g_current.array = array;
+  g_current.n = n;
+  g_current.state = state;
+  g_current.seed = seed;
+
+  char size[32];
+  BenchLog("  Input: %s (%s) %s in %.1f ms\n", kStateNames[state],
+           FormatBytes(n * sizeof(uint64_t), size, sizeof(size)), how,
+           (NowNs() - start) / 1e6);
+}
+
+void ForgetArrayState(const uint64_t *array) {
+  if (g_current.array == array) memset(&g_current, 0, sizeof(g_current));
+}
+
+size_t CycleStart(size_t chain, size_t num_chains) {
+  ArrayState s = g_current.state;
+  if (num_chains == 0 ||
+      (s != kStateRandomCycle && s != kStateLineCycle &&
+       s != kStatePageCycle && s != kStateInPageCycle)) {
+    return 0;
+  }
+  return g_marks[chain * MAX_CYCLE_MARKS / num_chains];
+}
+
+const size_t *AcquirePermutation(size_t n) {
+  uint64_t seed = BenchSeed();
+  CacheEntry *e = Lookup(kCachedPermutation, kStateAny, n, seed);
+  if (e) {
+    e->refs++;
+    return e->data;
+  }
+  e = Insert(kCachedPermutation, kStateAny, n, seed, n * sizeof(size_t));
+  if (!e) return RandomPermutation(n, seed);  // ReleasePermutation() frees
+  if (!BuildPermutation(e->data, n, seed)) {
+    Evict(e);
+    return NULL;
+  }
+  e->refs = 1;
+  return e->data;
+}
+
+void ReleasePermutation(const size_t *perm) {
+  for (int i = 0; i < MAX_CACHE_ENTRIES; i++) {
+    if (g_cache[i].used && g_cache[i].data == perm) {
+      g_cache[i].refs--;
+      return;
+    }
+  }
+  free((void *)perm);
+}
+
+void ArrayStateShutdown(void) {
+  for (int i = 0; i < MAX_CACHE_ENTRIES; i++) {
+    if (g_cache[i].used) Evict(&g_cache[i]);
+  }
+  memset(&g_current, 0, sizeof(g_current));
+}
@@ -0,0 +1,47 @@
+#ifndef HARNESS_ARRAY_STATE_H_
+#define HARNESS_ARRAY_STATE_H_
+
+#include "bench.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Prepares benchmark inputs. Cheap states (identity, random values) are
+// regenerated in parallel; expensive ones (cycles, sorted) are built
+// once per (size, seed) and kept as snapshots in spare memory, so switching
+// between them is a parallel copy. The array's current contents are
+// tracked, and preparing the state it already holds is free.
+
+// Snapshot memory limit; defaults to half of MemAvailable at first use.
+void SetStateCacheBudget(size_t bytes);
+
+// Makes array[0..n) hold `state` (a no-op if it already does).
+void PrepareArray(uint64_t *array, size_t n, ArrayState state);
+
+// Drops what is known about `array`'s contents, e.g. before freeing it.
+void ForgetArrayState(const uint64_t *array);
+
+// Slot spacing of the sparse cycles: kStateLineCycle and kStateInPageCycle
+// put nodes at multiples of CYCLE_LINE_SLOTS, kStatePageCycle one node at a
+// random line of each CYCLE_PAGE_SLOTS block. The rest of the array is left
+// as it was.
+#define CYCLE_LINE_SLOTS 8
+#define CYCLE_PAGE_SLOTS 512
+
+// Number of nodes in `state`'s cycle over n slots (n for kStateRandomCycle).
+size_t CycleNodes(size_t n, ArrayState state);
+
+// With one of the cycle states prepared: the slot where walker `chain` of
+// `num_chains` evenly spaced walkers starts (num_chains <= MAX_CYCLE_MARKS).
+#define MAX_CYCLE_MARKS 4096
+size_t CycleStart(size_t chain, size_t num_chains);
+
+// Random permutation of 0..n-1 for the current seed, shared between
+// benchmarks (and trials) while it fits the cache budget.
+const size_t *AcquirePermutation(size_t n);
+void ReleasePermutation(const size_t *perm);
+
+// Frees every snapshot.
+void ArrayStateShutdown(void);
+
+#endif
@@ -0,0 +1,172 @@
+#include "harness/assoc_scan.h"
+
+#include "bench.h"
+#include "harness/report.h"
+#include "harness/units.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static const ParamBenchEntry kScanEntry = {
+    "assocscan", "Associativity scan", NULL, kStateScratch,
+    {{"stride", "bytes between addresses", 4096, 64, (int64_t)1 << 30,
+      NULL}}};
+
+#define MIN_STRIDE ((size_t)4 << 10)
+#define MAX_STRIDE ((size_t)64 << 20)
+// Addresses per stride; enough for the 16- and 20-way levels.
+#define SCAN_WAYS 32
+#define MAX_PLATEAUS 4
+// A plateau ends when two addresses in a row take this much longer.
+#define STEP_UP 1.3
+
+typedef struct {
+  size_t stride;
+  double ns[SCAN_WAYS + 1];  // By address count
+  size_t ends[MAX_PLATEAUS];  // Last address count of each plateau
+  double level_ns[MAX_PLATEAUS];
+  size_t plateaus;
+} StrideScan;
+
+int AssocScanGridInit(ParamGrid *grid, size_t max_bytes) {
+  if (!ParamGridInit(grid, &kScanEntry)) return 0;
+  size_t limit = max_bytes / SCAN_WAYS;
+  if (limit > MAX_STRIDE) limit = MAX_STRIDE;
+  size_t count = 0;
+  for (size_t s = MIN_STRIDE; s <= limit; s *= 2) count++;
+  if (count == 0) return 1;
+  int64_t *strides = malloc(count * sizeof(int64_t));
+  if (!strides) return 0;
+  size_t v = 0;
+  for (size_t s = MIN_STRIDE; s <= limit; s *= 2) strides[v++] = s;
+  free(grid->values[0]);
+  grid->values[0] = strides;
+  grid->num_values[0] = count;
+  return 1;
+}
+
+// Splits the curve into plateaus. Each plateau's level is the mean of its
+// points; a single slow point is taken as noise.
+static void FindPlateaus(StrideScan *scan) {
+  double sum = scan->ns[1];
+  size_t points = 1;
+  scan->plateaus = 0;
+  for (size_t k = 2; k <= SCAN_WAYS; k++) {
+    double level = sum / points;
+    int up = scan->ns[k] > level * STEP_UP &&
+             (k == SCAN_WAYS || scan->ns[k + 1] > level * STEP_UP);
+    if (up && scan->plateaus + 1 < MAX_PLATEAUS) {
+      scan->level_ns[scan->plateaus] = level;
+      scan->ends[scan->plateaus++] = k - 1;
+      sum = 0;
+      points = 0;
+    }
+    sum += scan->ns[k];
+    points++;
+  }
+  scan->level_ns[scan->plateaus] = sum / points;
+  scan->ends[scan->plateaus++] = SCAN_WAYS;
+}
+
+static int Scan(uint64_t *array, size_t n, const TrialConfig *trials,
+                int text, StrideScan *scan) {
+  char size[32];
+  BenchLog("  %9s ", FormatBytes(scan->stride, size, sizeof(size)));
+  for (size_t k = 1; k <= SCAN_WAYS; k++) {
+    BenchCall call = {.param_func = BenchAssoc,
+                      .params = {(int64_t)k, (int64_t)scan->stride},
+                      .input = kStateScratch};
+    SetBenchLogQuiet(1);
+    BenchResult result = RunTrials(&call, array, n, trials);
+    SetBenchLogQuiet(0);
+    if (result.iterations == 0) return 0;
+    scan->ns[k] = result.ns_per_access;
+    if (!text) {
+      char params[64];
+      snprintf(params, sizeof(params), "ways=%zu,stride=%zu", k,
+               scan->stride);
+      ReportResult("assocscan", params, n * sizeof(uint64_t), &result);
+    }
+  }
+  FindPlateaus(scan);
+  size_t first = 1;
+  for (size_t p = 0; p < scan->plateaus; p++) {
+    BenchLog(" %s%2zu-%-2zu %6.2f ns", p ? "|" : "", first, scan->ends[p],
+             scan->level_ns[p]);
+    first = scan->ends[p] + 1;
+  }
+  BenchLog("\n");
+  return 1;
+}
+
+// Index of the plateau in `scan` that ends at `ways` addresses, or -1.
+static int EndsAt(const StrideScan *scan, size_t ways) {
+  for (size_t p = 0; p + 1 < scan->plateaus; p++) {
+    if (scan->ends[p] == ways) return (int)p;
+  }
+  return -1;
+}
+
+// A structure with W ways and a set span S ends a plateau at W addresses
+// for every stride from S up (and at W * S / stride below S). So each knee
+// that first appears at some stride and recurs at most larger strides is
+// one structure; knees that do not recur are noise. Caches and
+// set-associative TLBs both show up here.
+static void PrintLevels(const StrideScan *scans, size_t count) {
+  BenchLog("\n  %5s  %9s  %7s  %9s  %s\n", "ways", "set span", "sets",
+           "covers", "latency");
+  size_t found = 0;
+  int seen[SCAN_WAYS + 1] = {0};
+  for (size_t s = 0; s < count; s++) {
+    for (size_t p = 0; p + 1 < scans[s].plateaus; p++) {
+      size_t ways = scans[s].ends[p];
+      if (seen[ways]) continue;
+      size_t recur = 0;
+      for (size_t t = s + 1; t < count; t++) {
+        recur += EndsAt(&scans[t], ways) >= 0;
+      }
+      if (recur * 2 < count - s - 1) continue;
+      seen[ways] = 1;
+      char span[32], total[32];
+      BenchLog("  %5zu  %9s  %7zu  %9s  %.2f -> %.2f ns\n", ways,
+               FormatBytes(scans[s].stride, span, sizeof(span)),
+               scans[s].stride / 64,
+               FormatBytes(ways * scans[s].stride, total, sizeof(total)),
+               scans[s].level_ns[p], scans[s].level_ns[p + 1]);
+      found++;
+    }
+  }
+  if (found == 0) {
+    BenchLog("  No set conflicts within %d addresses\n", SCAN_WAYS);
+  }
+  BenchLog("  (set span: smallest stride showing the conflict, an upper "
+           "bound at the first stride;\n   hashed set indexing, as in most "
+           "L3s, shows no conflicts)\n");
+}
+
+int RunAssocScan(const ParamGrid *grid, uint64_t *array, size_t n,
+                 const TrialConfig *trials) {
+  size_t count = grid->num_values[0];
+  if (count == 0) {
+    fprintf(stderr, "Assoc scan: array too small for a %zu-byte stride\n",
+            MIN_STRIDE);
+    return 0;
+  }
+  StrideScan *scans = calloc(count, sizeof(StrideScan));
+  if (!scans) {
+    fprintf(stderr, "Failed to allocate %zu stride scans\n", count);
+    return 0;
+  }
+  int text = ReportFormat() == kFormatText;
+  BenchLog("\n=== Set conflicts: %d addresses per stride (addresses: "
+           "latency) ===\n",
+           SCAN_WAYS);
+  size_t done = 0;
+  for (; done < count; done++) {
+    scans[done].stride = (size_t)grid->values[0][done];
+    if (!Scan(array, n, trials, text, &scans[done])) break;
+  }
+  if (done) PrintLevels(scans, done);
+  free(scans);
+  return done == count;
+}
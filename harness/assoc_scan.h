@@ -0,0 +1,25 @@
+#ifndef HARNESS_ASSOC_SCAN_H_
+#define HARNESS_ASSOC_SCAN_H_
+
+#include "harness/params.h"
+#include "harness/runner.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Associativity scan: for every power-of-two stride, runs assoc with 1, 2,
+// ... addresses and splits the latency curve into plateaus. A plateau ends
+// where the addresses stop fitting the sets they share in one cache level;
+// the fewest addresses any stride fits gives that level's associativity,
+// and the smallest stride reaching it the level's set span (sets x line).
+
+// Grid of strides. Default: 4 KiB doubling up to 64 MiB or what the array
+// holds for the largest scan.
+int AssocScanGridInit(ParamGrid *grid, size_t max_bytes);
+
+// Scans every stride, then prints the levels found. Returns 0 if a
+// measurement failed.
+int RunAssocScan(const ParamGrid *grid, uint64_t *array, size_t n,
+                 const TrialConfig *trials);
+
+#endif
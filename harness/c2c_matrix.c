@@ -0,0 +1,179 @@
+#define _GNU_SOURCE
+#include "harness/c2c_matrix.h"
+
+#include "bench.h"
+#include "harness/numa.h"
+#include "harness/report.h"
+
+#include <float.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef enum {
+  kPairSmt,           // Hardware threads of one core
+  kPairSharedL3,      // Different cores behind one L3 (CCX, cluster)
+  kPairSamePackage,   // One socket, different L3
+  kPairCrossPackage,  // Different sockets
+  kNumPairKinds,
+} PairKind;
+
+static const char *const kPairNames[] = {"SMT siblings", "shared L3",
+                                         "same package", "cross package"};
+
+typedef struct {
+  int package;
+  int core;  // First CPU of the core's hardware threads
+  int l3;    // First CPU sharing the L3, -1 if unknown
+} CpuTopology;
+
+// First integer of a sysfs file (a number or a cpulist), or -1.
+static int ReadSysfsInt(const char *path) {
+  FILE *f = fopen(path, "r");
+  if (!f) return -1;
+  int value = -1;
+  if (fscanf(f, "%d", &value) != 1) value = -1;
+  fclose(f);
+  return value;
+}
+
+static void ReadTopology(int cpu, CpuTopology *topo) {
+  char path[128];
+  snprintf(path, sizeof(path),
+           "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu);
+  topo->package = ReadSysfsInt(path);
+  snprintf(path, sizeof(path),
+           "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list",
+           cpu);
+  topo->core = ReadSysfsInt(path);
+  topo->l3 = -1;
+  for (int index = 0; index < 8; index++) {
+    snprintf(path, sizeof(path),
+             "/sys/devices/system/cpu/cpu%d/cache/index%d/level", cpu, index);
+    int level = ReadSysfsInt(path);
+    if (level < 0) break;
+    if (level != 3) continue;
+    snprintf(path, sizeof(path),
+             "/sys/devices/system/cpu/cpu%d/cache/index%d/shared_cpu_list",
+             cpu, index);
+    topo->l3 = ReadSysfsInt(path);
+    break;
+  }
+}
+
+static PairKind ClassifyPair(const CpuTopology *a, const CpuTopology *b) {
+  if (a->package != b->package) return kPairCrossPackage;
+  if (a->core == b->core && a->core >= 0) return kPairSmt;
+  if (a->l3 == b->l3 && a->l3 >= 0) return kPairSharedL3;
+  return kPairSamePackage;
+}
+
+// CPUs to pair up: the --cpus list without repeats, else our affinity mask.
+static int MatrixCpus(int *cpus, int max) {
+  int list[MAX_CPUS];
+  int count = GetWorkerCpus(list, MAX_CPUS);
+  int num = 0;
+  if (count > 0) {
+    for (int i = 0; i < count && num < max; i++) {
+      int seen = 0;
+      for (int j = 0; j < num; j++) seen |= cpus[j] == list[i];
+      if (!seen) cpus[num++] = list[i];
+    }
+    return num;
+  }
+  cpu_set_t set;
+  if (sched_getaffinity(0, sizeof(set), &set) != 0) return 0;
+  for (int c = 0; c < CPU_SETSIZE && num < max; c++) {
+    if (CPU_ISSET(c, &set)) cpus[num++] = c;
+  }
+  return num;
+}
+
+static void PrintMatrix(const int *cpus, int num, const double *cells) {
+  BenchLog("\nRound-trip latency (ns), rows/columns = CPU\n");
+  BenchLog("%6s", "");
+  for (int j = 0; j < num; j++) BenchLog(" %6d", cpus[j]);
+  BenchLog("\n");
+  for (int i = 0; i < num; i++) {
+    BenchLog("%6d", cpus[i]);
+    for (int j = 0; j < num; j++) {
+      if (i == j) {
+        BenchLog(" %6s", "-");
+      } else {
+        BenchLog(" %6.0f", cells[i * num + j]);
+      }
+    }
+    BenchLog("\n");
+  }
+}
+
+static void PrintSummary(const int *cpus, int num, const double *cells) {
+  CpuTopology *topo = malloc(num * sizeof(CpuTopology));
+  if (!topo) return;
+  for (int i = 0; i < num; i++) ReadTopology(cpus[i], &topo[i]);
+
+  double sum[kNumPairKinds] = {0};
+  double lo[kNumPairKinds], hi[kNumPairKinds] = {0};
+  size_t pairs[kNumPairKinds] = {0};
+  for (int k = 0; k < kNumPairKinds; k++) lo[k] = DBL_MAX;
+  for (int i = 0; i < num; i++) {
+    for (int j = i + 1; j < num; j++) {
+      PairKind k = ClassifyPair(&topo[i], &topo[j]);
+      double ns = cells[i * num + j];
+      sum[k] += ns;
+      if (ns < lo[k]) lo[k] = ns;
+      if (ns > hi[k]) hi[k] = ns;
+      pairs[k]++;
+    }
+  }
+  free(topo);
+
+  BenchLog("\nBy topology (sysfs)       pairs    mean ns     min     max\n");
+  for (int k = 0; k < kNumPairKinds; k++) {
+    if (!pairs[k]) continue;
+    BenchLog("  %-22s %6zu %10.1f %7.0f %7.0f\n", kPairNames[k], pairs[k],
+             sum[k] / pairs[k], lo[k], hi[k]);
+  }
+}
+
+int RunCoreToCoreMatrix(const TrialConfig *trials) {
+  int cpus[MAX_CPUS];
+  int num = MatrixCpus(cpus, MAX_CPUS);
+  if (num < 2) {
+    fprintf(stderr, "Core-to-core matrix needs at least two CPUs\n");
+    return 0;
+  }
+  double *cells = calloc((size_t)num * num, sizeof(double));
+  if (!cells) {
+    fprintf(stderr, "Failed to allocate core-to-core matrix\n");
+    return 0;
+  }
+
+  BenchLog("\n=== Core-to-core matrix: %d CPUs, %d pairs ===\n", num,
+           num * (num - 1) / 2);
+  int text = ReportFormat() == kFormatText;
+  int ok = 1;
+  for (int i = 0; i < num && ok; i++) {
+    for (int j = i + 1; j < num && ok; j++) {
+      BenchCall call = {.param_func = BenchPingPong, .input = kStateAny};
+      call.params[0] = cpus[i];
+      call.params[1] = cpus[j];
+      BenchResult result = RunTrials(&call, NULL, 0, trials);
+      ok = result.iterations > 0;
+      cells[i * num + j] = cells[j * num + i] = result.ns_per_access;
+      if (ok && !text) {
+        char params[64];
+        snprintf(params, sizeof(params), "cpu_a=%d,cpu_b=%d", cpus[i],
+                 cpus[j]);
+        ReportResult("c2c", params, 0, &result);
+      }
+    }
+  }
+
+  if (ok) {
+    PrintMatrix(cpus, num, cells);
+    PrintSummary(cpus, num, cells);
+  }
+  free(cells);
+  return ok;
+}
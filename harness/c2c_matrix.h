@@ -0,0 +1,13 @@
+#ifndef HARNESS_C2C_MATRIX_H_
+#define HARNESS_C2C_MATRIX_H_
+
+#include "harness/runner.h"
+
+// Ping-pongs a cache line between every pair of CPUs (the --cpus list, or
+// every CPU we may run on) and prints the N x N round-trip matrix, followed
+// by the mean latency of SMT siblings, CPUs sharing an L3, CPUs in one
+// package and CPUs in different packages (from sysfs topology). Each pair
+// is measured once and mirrored. Returns 0 with fewer than two CPUs.
+int RunCoreToCoreMatrix(const TrialConfig *trials);
+
+#endif
@@ -0,0 +1,129 @@
+#include "harness/compare.h"
+
+#include "bench.h"
+#include "harness/json.h"
+#include "harness/report.h"
+#include "harness/stats.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef enum {
+  kVerdictSame,
+  kVerdictNoise,
+  kVerdictFaster,
+  kVerdictSlower,
+  kVerdictNew,
+} Verdict;
+
+static const char *kVerdictNames[] = {"ok", "noise", "faster", "REGRESSION",
+                                      "new"};
+
+// Rebuilds the "a=1,b=2" form of a result's "params" object.
+static void FormatBaselineParams(const JsonValue *result, char *buf,
+                                 size_t size) {
+  buf[0] = '\0';
+  const JsonValue *params = JsonGet(result, "params");
+  if (!params || params->type != kJsonObject) return;
+  size_t len = 0;
+  for (size_t i = 0; i < params->count && len < size; i++) {
+    const JsonValue *value = &params->items[i];
+    int written =
+        value->type == kJsonString
+            ? snprintf(buf + len, size - len, "%s%s=%s", i ? "," : "",
+                       params->keys[i], value->string)
+            : snprintf(buf + len, size - len, "%s%s=%lld", i ? "," : "",
+                       params->keys[i], (long long)value->number);
+    if (written < 0) break;
+    len += written;
+  }
+}
+
+static const JsonValue *FindBaseline(const JsonValue *results,
+                                     const ReportedResult *cur) {
+  char params[128];
+  for (size_t i = 0; i < results->count; i++) {
+    const char *base_id = JsonGetString(&results->items[i], "id");
+    if (!base_id || strcmp(base_id, cur->id) != 0) continue;
+    FormatBaselineParams(&results->items[i], params, sizeof(params));
+    if (strcmp(params, cur->params) == 0) return &results->items[i];
+  }
+  return NULL;
+}
+
+// Welch's t-test on the trial means. With a single trial on either side
+// there is no variance estimate and any change past the threshold counts.
+static int Significant(double m1, double s1, double n1, double m2, double s2,
+                       double n2) {
+  if (n1 < 2 || n2 < 2) return 1;
+  double v1 = s1 * s1 / n1;
+  double v2 = s2 * s2 / n2;
+  double se = sqrt(v1 + v2);
+  if (se == 0.0) return m1 != m2;
+  double df = (v1 + v2) * (v1 + v2) /
+              (v1 * v1 / (n1 - 1) + v2 * v2 / (n2 - 1));
+  return fabs(m2 - m1) / se > TCritical95(df < 1.0 ? 1 : (size_t)df);
+}
+
+int CompareWithBaseline(const char *baseline_path, double threshold) {
+  JsonValue *root = JsonParseFile(baseline_path);
+  if (!root) return -1;
+  const JsonValue *results = JsonGet(root, "results");
+  if (!results || results->type != kJsonArray) {
+    fprintf(stderr, "%s: no \"results\" array\n", baseline_path);
+    JsonFree(root);
+    return -1;
+  }
+
+  size_t count;
+  const ReportedResult *current = ReportedResults(&count);
+
+  BenchLog("\n=== Comparison vs %s (threshold %.1f%%) ===\n", baseline_path,
+           threshold * 100.0);
+  BenchLog("%-16s %12s %12s %9s  %s\n", "benchmark", "baseline", "current",
+           "change", "verdict");
+
+  int regressions = 0;
+  for (size_t i = 0; i < count; i++) {
+    const ReportedResult *cur = &current[i];
+    const BenchStats *s = &cur->result.stats;
+    const JsonValue *base = FindBaseline(results, cur);
+    char label[200];
+    snprintf(label, sizeof(label), "%s%s%s", cur->id, cur->params[0] ? " " : "",
+             cur->params);
+    if (!base) {
+      BenchLog("%-16s %12s %9.2f ns %9s  %s\n", label, "-", s->mean, "-",
+               kVerdictNames[kVerdictNew]);
+      continue;
+    }
+
+    double base_mean = JsonGetNumber(base, "mean", 0.0);
+    double base_sd = JsonGetNumber(base, "stddev", 0.0);
+    double base_n = JsonGetNumber(base, "trials", 1.0);
+    double change = base_mean > 0 ? (s->mean - base_mean) / base_mean : 0.0;
+    int significant = Significant(base_mean, base_sd, base_n, s->mean,
+                                  s->stddev, (double)s->trials);
+
+    Verdict verdict = kVerdictSame;
+    if (fabs(change) > threshold) {
+      if (!significant) {
+        verdict = kVerdictNoise;
+      } else {
+        verdict = change > 0 ? kVerdictSlower : kVerdictFaster;
+      }
+    }
+    if (verdict == kVerdictSlower) regressions++;
+
+    size_t base_bytes = (size_t)JsonGetNumber(base, "array_bytes", 0.0);
+    BenchLog("%-16s %9.2f ns %9.2f ns %+8.1f%%  %s%s\n", label, base_mean,
+             s->mean, change * 100.0, kVerdictNames[verdict],
+             base_bytes && base_bytes != cur->array_bytes
+                 ? " (array size differs)"
+                 : "");
+  }
+
+  BenchLog("%d regression%s\n", regressions, regressions == 1 ? "" : "s");
+  JsonFree(root);
+  return regressions;
+}
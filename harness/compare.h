@@ -0,0 +1,12 @@
+#ifndef HARNESS_COMPARE_H_
+#define HARNESS_COMPARE_H_
+
+// Compares every result reported so far against a JSON file written by an
+// earlier `--format=json` run. A benchmark regresses when its mean is more
+// than `threshold` (0.05 == 5%) slower than the baseline mean and Welch's
+// t-test says the difference is significant at 95%.
+//
+// Returns the number of regressions, or -1 if the baseline cannot be read.
+int CompareWithBaseline(const char *baseline_path, double threshold);
+
+#endif
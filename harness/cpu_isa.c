@@ -0,0 +1,77 @@
+#include "harness/cpu_isa.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#if ISA_X86
+#include <cpuid.h>
+#endif
+
+static const char *const kIsaNames[] = {"scalar", "sse2", "avx2", "avx512"};
+
+// -1 until first use: then the best supported ISA, or the --isa choice.
+static int g_active = -1;
+static int g_supported = -1;  // Bit per Isa
+
+int ParseIsa(const char *name, Isa *out) {
+  for (int i = 0; i < kNumIsas; i++) {
+    if (strcmp(name, kIsaNames[i]) == 0) {
+      *out = (Isa)i;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+const char *IsaName(Isa isa) { return kIsaNames[isa]; }
+
+#if ISA_X86
+static uint64_t ReadXcr0(void) {
+  uint32_t lo, hi;
+  __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+  return ((uint64_t)hi << 32) | lo;
+}
+
+static int DetectIsas(void) {
+  int mask = 1 << kIsaScalar;
+  unsigned eax, ebx, ecx, edx;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return mask;
+  if (edx & bit_SSE2) mask |= 1 << kIsaSse2;
+  if (!(ecx & bit_OSXSAVE) || !(ecx & bit_AVX)) return mask;
+
+  // XMM and YMM state (bits 1-2); opmask and both ZMM halves (bits 5-7).
+  uint64_t xcr0 = ReadXcr0();
+  int ymm = (xcr0 & 0x6) == 0x6;
+  int zmm = (xcr0 & 0xe6) == 0xe6;
+  if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return mask;
+  if (ymm && (ebx & bit_AVX2)) mask |= 1 << kIsaAvx2;
+  if (zmm && (ebx & bit_AVX512F)) mask |= 1 << kIsaAvx512;
+  return mask;
+}
+#else
+static int DetectIsas(void) { return 1 << kIsaScalar; }
+#endif
+
+int IsaSupported(Isa isa) {
+  if (g_supported < 0) g_supported = DetectIsas();
+  return (g_supported >> isa) & 1;
+}
+
+Isa ActiveIsa(void) {
+  if (g_active < 0) {
+    g_active = kIsaScalar;
+    for (int i = kNumIsas - 1; i > kIsaScalar; i--) {
+      if (IsaSupported((Isa)i)) {
+        g_active = i;
+        break;
+      }
+    }
+  }
+  return (Isa)g_active;
+}
+
+int SetActiveIsa(Isa isa) {
+  if (!IsaSupported(isa)) return 0;
+  g_active = isa;
+  return 1;
+}
@@ -0,0 +1,38 @@
+#ifndef HARNESS_CPU_ISA_H_
+#define HARNESS_CPU_ISA_H_
+
+// Vector instruction sets a kernel can be built for. The binary is compiled
+// for the baseline target; wider kernels carry their own target attribute
+// and are only called after CPUID says the CPU (and OS) support them.
+typedef enum {
+  kIsaScalar,
+  kIsaSse2,
+  kIsaAvx2,
+  kIsaAvx512,  // AVX-512F
+  kNumIsas,
+} Isa;
+
+#if defined(__x86_64__)
+#define ISA_X86 1
+#define ISA_TARGET_SSE2 __attribute__((target("sse2")))
+#define ISA_TARGET_AVX2 __attribute__((target("avx2")))
+#define ISA_TARGET_AVX512 __attribute__((target("avx512f")))
+#else
+#define ISA_X86 0
+#endif
+
+// Accepts "scalar", "sse2", "avx2" or "avx512". Returns 0 otherwise.
+int ParseIsa(const char *name, Isa *out);
+const char *IsaName(Isa isa);
+
+// Whether this CPU can run `isa` kernels: the CPUID feature bit, plus
+// XGETBV confirming the OS saves the wider registers.
+int IsaSupported(Isa isa);
+
+// The widest supported ISA, unless --isa forced another one.
+Isa ActiveIsa(void);
+
+// Forces ActiveIsa(). Returns 0 if the CPU cannot run `isa`.
+int SetActiveIsa(Isa isa);
+
+#endif
@@ -0,0 +1,250 @@
+#include "harness/json.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+  const char *p;
+  const char *end;
+  const char *error;
+} Parser;
+
+static void SkipSpace(Parser *ps) {
+  while (ps->p < ps->end && isspace((unsigned char)*ps->p)) ps->p++;
+}
+
+static int Consume(Parser *ps, char c) {
+  SkipSpace(ps);
+  if (ps->p < ps->end && *ps->p == c) {
+    ps->p++;
+    return 1;
+  }
+  return 0;
+}
+
+static int ParseValue(Parser *ps, JsonValue *out);
+
+static void FreeChildren(JsonValue *v) {
+  free(v->string);
+  for (size_t i = 0; i < v->count; i++) {
+    if (v->keys) free(v->keys[i]);
+    FreeChildren(&v->items[i]);
+  }
+  free(v->keys);
+  free(v->items);
+}
+
+// Matches `word` at the cursor without reading past the end of the input.
+static int ConsumeLiteral(Parser *ps, const char *word) {
+  size_t len = strlen(word);
+  if ((size_t)(ps->end - ps->p) < len || memcmp(ps->p, word, len) != 0) {
+    return 0;
+  }
+  ps->p += len;
+  return 1;
+}
+
+static char *ParseString(Parser *ps) {
+  if (!Consume(ps, '"')) {
+    ps->error = "expected string";
+    return NULL;
+  }
+  size_t cap = 16, len = 0;
+  char *s = malloc(cap);
+  if (!s) return NULL;
+  while (ps->p < ps->end && *ps->p != '"') {
+    char c = *ps->p++;
+    if (c == '\\' && ps->p < ps->end) {
+      char e = *ps->p++;
+      switch (e) {
+        case 'n': c = '\n'; break;
+        case 't': c = '\t'; break;
+        case 'r': c = '\r'; break;
+        case 'b': c = '\b'; break;
+        case 'f': c = '\f'; break;
+        case 'u':
+          // Non-ASCII never appears in our own output; keep a placeholder.
+          ps->p += (ps->end - ps->p >= 4) ? 4 : ps->end - ps->p;
+          c = '?';
+          break;
+        default: c = e; break;
+      }
+    }
+    if (len + 2 > cap) {
+      cap *= 2;
+      char *grown = realloc(s, cap);
+      if (!grown) {
+        free(s);
+        return NULL;
+      }
+      s = grown;
+    }
+    s[len++] = c;
+  }
+  if (ps->p >= ps->end) {
+    ps->error = "unterminated string";
+    free(s);
+    return NULL;
+  }
+  ps->p++;
+  s[len] = '\0';
+  return s;
+}
+
+static int Append(JsonValue *out, size_t *cap, char *key, JsonValue *item) {
+  if (out->count == *cap) {
+    *cap = *cap ? *cap * 2 : 8;
+    JsonValue *items = realloc(out->items, *cap * sizeof(JsonValue));
+    if (!items) return 0;
+    out->items = items;
+    if (out->type == kJsonObject) {
+      char **keys = realloc(out->keys, *cap * sizeof(char *));
+      if (!keys) return 0;
+      out->keys = keys;
+    }
+  }
+  if (out->type == kJsonObject) out->keys[out->count] = key;
+  out->items[out->count++] = *item;
+  return 1;
+}
+
+static int ParseContainer(Parser *ps, JsonValue *out, char close) {
+  size_t cap = 0;
+  if (Consume(ps, close)) return 1;
+  do {
+    char *key = NULL;
+    if (out->type == kJsonObject) {
+      SkipSpace(ps);
+      key = ParseString(ps);
+      if (!key) return 0;
+      if (!Consume(ps, ':')) {
+        ps->error = "expected ':'";
+        free(key);
+        return 0;
+      }
+    }
+    JsonValue item = {0};
+    if (!ParseValue(ps, &item) || !Append(out, &cap, key, &item)) {
+      free(key);
+      FreeChildren(&item);
+      if (!ps->error) ps->error = "out of memory";
+      return 0;
+    }
+  } while (Consume(ps, ','));
+  if (!Consume(ps, close)) {
+    ps->error = "expected ',' or closing bracket";
+    return 0;
+  }
+  return 1;
+}
+
+static int ParseValue(Parser *ps, JsonValue *out) {
+  SkipSpace(ps);
+  if (ps->p >= ps->end) {
+    ps->error = "unexpected end of input";
+    return 0;
+  }
+  char c = *ps->p;
+  if (c == '{') {
+    ps->p++;
+    out->type = kJsonObject;
+    return ParseContainer(ps, out, '}');
+  }
+  if (c == '[') {
+    ps->p++;
+    out->type = kJsonArray;
+    return ParseContainer(ps, out, ']');
+  }
+  if (c == '"') {
+    out->type = kJsonString;
+    out->string = ParseString(ps);
+    return out->string != NULL;
+  }
+  if (ConsumeLiteral(ps, "true") || ConsumeLiteral(ps, "false")) {
+    out->type = kJsonBool;
+    out->number = (c == 't');
+    return 1;
+  }
+  if (ConsumeLiteral(ps, "null")) {
+    out->type = kJsonNull;
+    return 1;
+  }
+  // The buffer is NUL-terminated, so strtod stops at the end of the input.
+  char *num_end;
+  out->type = kJsonNumber;
+  out->number = strtod(ps->p, &num_end);
+  if (num_end == ps->p) {
+    ps->error = "unexpected character";
+    return 0;
+  }
+  ps->p = num_end;
+  return 1;
+}
+
+void JsonFree(JsonValue *value) {
+  if (!value) return;
+  FreeChildren(value);
+  free(value);
+}
+
+JsonValue *JsonParseFile(const char *path) {
+  FILE *f = fopen(path, "rb");
+  if (!f) {
+    fprintf(stderr, "Failed to open %s\n", path);
+    return NULL;
+  }
+  long size = -1;
+  if (fseek(f, 0, SEEK_END) == 0) size = ftell(f);
+  if (size < 0 || fseek(f, 0, SEEK_SET) != 0) {
+    fprintf(stderr, "Failed to read %s: not a regular file\n", path);
+    fclose(f);
+    return NULL;
+  }
+  char *buf = malloc((size_t)size + 1);
+  if (!buf || fread(buf, 1, size, f) != (size_t)size) {
+    fprintf(stderr, "Failed to read %s\n", path);
+    free(buf);
+    fclose(f);
+    return NULL;
+  }
+  fclose(f);
+  buf[size] = '\0';
+
+  Parser ps = {buf, buf + size, NULL};
+  JsonValue *root = calloc(1, sizeof(JsonValue));
+  if (root && ParseValue(&ps, root)) {
+    SkipSpace(&ps);
+    if (ps.p != ps.end) ps.error = "trailing data";
+  } else if (!ps.error) {
+    ps.error = "out of memory";
+  }
+
+  if (ps.error) {
+    fprintf(stderr, "%s: JSON error at byte %ld: %s\n", path,
+            (long)(ps.p - buf), ps.error);
+    JsonFree(root);
+    root = NULL;
+  }
+  free(buf);
+  return root;
+}
+
+const JsonValue *JsonGet(const JsonValue *obj, const char *key) {
+  if (!obj || obj->type != kJsonObject) return NULL;
+  for (size_t i = 0; i < obj->count; i++) {
+    if (strcmp(obj->keys[i], key) == 0) return &obj->items[i];
+  }
+  return NULL;
+}
+
+double JsonGetNumber(const JsonValue *obj, const char *key, double fallback) {
+  const JsonValue *v = JsonGet(obj, key);
+  return (v && v->type == kJsonNumber) ? v->number : fallback;
+}
+
+const char *JsonGetString(const JsonValue *obj, const char *key) {
+  const JsonValue *v = JsonGet(obj, key);
+  return (v && v->type == kJsonString) ? v->string : NULL;
+}
@@ -0,0 +1,38 @@
+#ifndef HARNESS_JSON_H_
+#define HARNESS_JSON_H_
+
+#include <stddef.h>
+
+// Minimal JSON reader, just enough to load result files written by
+// harness/report.c back in for --compare.
+
+typedef enum {
+  kJsonNull,
+  kJsonBool,
+  kJsonNumber,
+  kJsonString,
+  kJsonArray,
+  kJsonObject,
+} JsonType;
+
+typedef struct JsonValue JsonValue;
+
+struct JsonValue {
+  JsonType type;
+  double number;      // kJsonNumber, kJsonBool (0/1)
+  char *string;       // kJsonString
+  size_t count;       // kJsonArray, kJsonObject
+  char **keys;        // kJsonObject: count keys
+  JsonValue *items;   // kJsonArray, kJsonObject: count values
+};
+
+// Parses the whole file. Returns NULL (and prints why) on failure.
+JsonValue *JsonParseFile(const char *path);
+void JsonFree(JsonValue *value);
+
+// Object member lookup; NULL if `obj` is not an object or has no such key.
+const JsonValue *JsonGet(const JsonValue *obj, const char *key);
+double JsonGetNumber(const JsonValue *obj, const char *key, double fallback);
+const char *JsonGetString(const JsonValue *obj, const char *key);
+
+#endif
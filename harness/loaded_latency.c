@@ -0,0 +1,247 @@
+#define _GNU_SOURCE
+#include "harness/loaded_latency.h"
+
+#include "bench.h"
+#include "harness/array_state.h"
+#include "harness/numa.h"
+#include "harness/report.h"
+#include "harness/units.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+enum { kTrafficRead, kTrafficWrite };
+
+static const char *const kTrafficNames[] = {"read", "write", NULL};
+
+static const ParamBenchEntry kLoadedEntry = {
+    "loaded", "Pointer chase under injected bandwidth", NULL, kStateAny,
+    {{"injectors", "bandwidth threads", 1, 1, MAX_CPUS, NULL},
+     {"traffic", "injected accesses", kTrafficRead, kTrafficRead,
+      kTrafficWrite, kTrafficNames},
+     {"delay", "spin iterations after each line", 0, 0, (int64_t)1 << 24,
+      NULL}}};
+
+static const int64_t kDefaultDelays[] = {20000, 10000, 5000, 2000, 1000, 500,
+                                         200,   100,   50,   20,   0};
+
+// Lines an injector touches between updates of its shared counter.
+#define PUBLISH_LINES 256
+#define LINE_SLOTS 8
+
+typedef struct {
+  pthread_t thread;
+  int cpu;  // -1: not pinned
+  uint64_t *begin;
+  size_t lines;
+  int write;
+  int64_t delay;
+  atomic_uint_fast64_t lines_done;
+  atomic_int *stop;
+  uint64_t sum;
+} Injector;
+
+static void *InjectorMain(void *arg) {
+  Injector *inj = arg;
+  if (inj->cpu >= 0) PinCurrentThread(inj->cpu);
+  uint64_t sum = 0;
+  while (!atomic_load_explicit(inj->stop, memory_order_relaxed)) {
+    for (size_t line = 0; line < inj->lines; line += PUBLISH_LINES) {
+      size_t end = line + PUBLISH_LINES;
+      if (end > inj->lines) end = inj->lines;
+      for (size_t l = line; l < end; l++) {
+        uint64_t *p = inj->begin + l * LINE_SLOTS;
+        if (inj->write) {
+          *p = l;
+        } else {
+          sum += *p;
+        }
+        for (int64_t d = 0; d < inj->delay; d++) __asm__ volatile("");
+      }
+      atomic_fetch_add_explicit(&inj->lines_done, end - line,
+                                memory_order_relaxed);
+      if (atomic_load_explicit(inj->stop, memory_order_relaxed)) break;
+    }
+  }
+  inj->sum = sum;
+  return NULL;
+}
+
+static uint64_t LinesDone(Injector *injectors, size_t count) {
+  uint64_t lines = 0;
+  for (size_t i = 0; i < count; i++) {
+    lines += atomic_load_explicit(&injectors[i].lines_done,
+                                  memory_order_relaxed);
+  }
+  return lines;
+}
+
+// The chase CPU and the CPUs left for injectors: the --cpus list if given
+// (first entry chases), else the CPU we run on and the rest of our mask.
+static int PlanCpus(int *chase_cpu, int *others, int max) {
+  int cpus[MAX_CPUS];
+  int count = GetWorkerCpus(cpus, MAX_CPUS);
+  int num_others = 0;
+  if (count > 0) {
+    *chase_cpu = cpus[0];
+    for (int i = 1; i < count && num_others < max; i++) {
+      if (cpus[i] != cpus[0]) others[num_others++] = cpus[i];
+    }
+    return num_others;
+  }
+  *chase_cpu = sched_getcpu();
+  cpu_set_t set;
+  if (sched_getaffinity(0, sizeof(set), &set) != 0) return 0;
+  for (int c = 0; c < CPU_SETSIZE && num_others < max; c++) {
+    if (CPU_ISSET(c, &set) && c != *chase_cpu) others[num_others++] = c;
+  }
+  return num_others;
+}
+
+int LoadedLatencyGridInit(ParamGrid *grid) {
+  if (!ParamGridInit(grid, &kLoadedEntry)) return 0;
+  int chase_cpu, others[MAX_CPUS];
+  int spare = PlanCpus(&chase_cpu, others, MAX_CPUS);
+  grid->values[0][0] = spare > 0 ? spare : 1;
+
+  size_t count = sizeof(kDefaultDelays) / sizeof(kDefaultDelays[0]);
+  int64_t *delays = malloc(sizeof(kDefaultDelays));
+  if (!delays) return 0;
+  for (size_t i = 0; i < count; i++) delays[i] = kDefaultDelays[i];
+  free(grid->values[2]);
+  grid->values[2] = delays;
+  grid->num_values[2] = count;
+  return 1;
+}
+
+// Runs the chase trials while `count` injectors (0 for idle) load memory.
+// Returns 0 if a thread could not be started or the chase failed.
+static int MeasurePoint(uint64_t *array, size_t n, const TrialConfig *trials,
+                        Injector *injectors, size_t count,
+                        BenchResult *result) {
+  atomic_int stop = 0;
+  size_t started = 0;
+  for (; started < count; started++) {
+    Injector *inj = &injectors[started];
+    atomic_store(&inj->lines_done, 0);
+    inj->stop = &stop;
+    if (pthread_create(&inj->thread, NULL, InjectorMain, inj) != 0) break;
+  }
+  int ok = started == count;
+  if (ok) {
+    // Let the injectors reach their steady rate before sampling.
+    struct timespec settle = {.tv_sec = 0, .tv_nsec = 10 * 1000 * 1000};
+    if (count) nanosleep(&settle, NULL);
+    uint64_t start_lines = LinesDone(injectors, count);
+    uint64_t start = NowNs();
+    BenchCall chase = {.func = BenchPointerChase, .input = kStateRandomCycle};
+    *result = RunTrials(&chase, array, n, trials);
+    ok = result->iterations > 0;
+    uint64_t ns = NowNs() - start;
+    uint64_t lines = LinesDone(injectors, count) - start_lines;
+    // A written line is read for ownership and later written back.
+    size_t line_bytes = count && injectors[0].write ? 128 : 64;
+    result->gbps = (double)(lines * line_bytes) / (double)ns;
+  } else {
+    fprintf(stderr, "Failed to start injector thread %zu\n", started);
+  }
+  atomic_store(&stop, 1);
+  for (size_t i = 0; i < started; i++) {
+    pthread_join(injectors[i].thread, NULL);
+  }
+  return ok;
+}
+
+int RunLoadedLatency(const ParamGrid *grid, uint64_t *array, size_t n,
+                     const TrialConfig *trials) {
+  int chase_cpu, others[MAX_CPUS];
+  int spare = PlanCpus(&chase_cpu, others, MAX_CPUS);
+  if (spare == 0) {
+    BenchLog("Warning: no CPU to spare; injectors share the chase CPU\n");
+  }
+
+  size_t chase_n = n / 2;
+  uint64_t *inject = array + chase_n;
+  size_t inject_lines = (n - chase_n) / LINE_SLOTS;
+
+  size_t max_injectors = 0;
+  for (size_t v = 0; v < grid->num_values[0]; v++) {
+    if ((size_t)grid->values[0][v] > max_injectors) {
+      max_injectors = grid->values[0][v];
+    }
+  }
+  if (inject_lines < max_injectors) {
+    fprintf(stderr, "Array too small for %zu injectors\n", max_injectors);
+    return 0;
+  }
+  Injector *injectors = calloc(max_injectors, sizeof(Injector));
+  if (!injectors) {
+    fprintf(stderr, "Failed to allocate %zu injectors\n", max_injectors);
+    return 0;
+  }
+
+  cpu_set_t saved_affinity;
+  sched_getaffinity(0, sizeof(saved_affinity), &saved_affinity);
+  PinCurrentThread(chase_cpu);
+
+  char chase_size[32], inject_size[32];
+  BenchLog("\n=== Loaded latency: chase on CPU %d (%s), injectors on %d "
+           "other CPU(s) (%s) ===\n",
+           chase_cpu,
+           FormatBytes(chase_n * sizeof(uint64_t), chase_size,
+                       sizeof(chase_size)),
+           spare,
+           FormatBytes(inject_lines * LINE_SLOTS * sizeof(uint64_t),
+                       inject_size, sizeof(inject_size)));
+
+  // The cycle is built before any injector runs; the trials then find it
+  // in place.
+  PrepareArray(array, chase_n, kStateRandomCycle);
+  int text = ReportFormat() == kFormatText;
+  size_t bytes = n * sizeof(uint64_t);
+
+  BenchResult idle;
+  int ok = MeasurePoint(array, chase_n, trials, injectors, 0, &idle);
+  if (ok && !text) ReportResult("loaded", "injectors=0", bytes, &idle);
+
+  size_t points = ParamGridSize(grid);
+  size_t curve_len = grid->num_values[2];
+  int64_t params[MAX_BENCH_PARAMS];
+  for (size_t i = 0; i < points && ok; i++) {
+    ParamGridPoint(grid, i, params);
+    size_t count = (size_t)params[0];
+    if (i % curve_len == 0) {
+      BenchLog("\n%zu %s injector(s)\n", count, kTrafficNames[params[1]]);
+      BenchLog("  %10s  %13s  %10s\n", "delay", "injected GB/s", "latency ns");
+      BenchLog("  %10s  %13.2f  %10.2f\n", "idle", 0.0, idle.ns_per_access);
+    }
+    size_t lines = inject_lines / count;
+    for (size_t t = 0; t < count; t++) {
+      injectors[t] = (Injector){
+          .cpu = spare > 0 ? others[t % spare] : -1,
+          .begin = inject + t * lines * LINE_SLOTS,
+          .lines = lines,
+          .write = params[1] == kTrafficWrite,
+          .delay = params[2],
+      };
+    }
+    BenchResult result;
+    ok = MeasurePoint(array, chase_n, trials, injectors, count, &result);
+    if (!ok) break;
+    BenchLog("  %10lld  %13.2f  %10.2f\n", (long long)params[2], result.gbps,
+             result.ns_per_access);
+    if (!text) {
+      char text_params[128];
+      FormatParams(grid->entry, params, text_params, sizeof(text_params));
+      ReportResult("loaded", text_params, bytes, &result);
+    }
+  }
+
+  sched_setaffinity(0, sizeof(saved_affinity), &saved_affinity);
+  free(injectors);
+  return ok;
+}
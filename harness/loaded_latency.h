@@ -0,0 +1,27 @@
+#ifndef HARNESS_LOADED_LATENCY_H_
+#define HARNESS_LOADED_LATENCY_H_
+
+#include "harness/params.h"
+#include "harness/runner.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Loaded latency: the pointer chase runs on one pinned CPU while injector
+// threads on the other CPUs stream through their own part of the array,
+// waiting `delay` spin iterations (about a cycle each) after every cache
+// line. Lowering the delay raises the injected bandwidth, tracing latency
+// against achieved bandwidth the way Intel MLC's --loaded_latency does.
+
+// Grid of injectors x traffic (read, write) x delay. Defaults: one injector
+// per remaining CPU, reads, and delays from 20000 down to 0.
+int LoadedLatencyGridInit(ParamGrid *grid);
+
+// Chases a random cycle over the first half of the array and injects into
+// the second half, first without injectors, then for every grid point.
+// Prints one latency-vs-bandwidth table per (injectors, traffic) pair.
+// Returns 0 if the injector threads could not be started.
+int RunLoadedLatency(const ParamGrid *grid, uint64_t *array, size_t n,
+                     const TrialConfig *trials);
+
+#endif
@@ -0,0 +1,146 @@
+#include "harness/mlp_search.h"
+
+#include "bench.h"
+#include "harness/array_state.h"
+#include "harness/parallel.h"
+#include "harness/report.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static const ParamBenchEntry kSearchEntry = {
+    "mlpsat", "MLP saturation search", NULL, kStateRandomCycle,
+    {{"threads", "chasing threads", 1, 1, 1024, NULL}}};
+
+// Chains per thread, dense where the knee usually is.
+static const size_t kLadder[] = {1,  2,  3,  4,  5,  6,  7,  8,
+                                 10, 12, 14, 16, 20, 24, 28, 32,
+                                 40, 48, 56, 64, 80, 96, 112, 128};
+#define LADDER_LEN (sizeof(kLadder) / sizeof(kLadder[0]))
+
+// A step must beat the best rate by this much to count as progress; after
+// PLATEAU_STEPS steps without progress the search stops.
+#define PROGRESS 1.03
+#define PLATEAU_STEPS 3
+// The saturation point is the fewest chains within this of the peak rate.
+#define NEAR_PEAK 0.95
+
+typedef struct {
+  size_t threads;
+  double latency_ns;  // One chain per thread: ns per hop
+  double peak_rate;   // Accesses per ns, all threads
+  size_t peak_chains;
+  size_t knee_chains;
+  double knee_rate;
+} Saturation;
+
+int MlpSearchGridInit(ParamGrid *grid) {
+  if (!ParamGridInit(grid, &kSearchEntry)) return 0;
+  size_t workers = SetupWorkers();
+  size_t count = 1;
+  for (size_t t = 2; t <= workers; t *= 2) count++;
+  int64_t *threads = malloc((count + 1) * sizeof(int64_t));
+  if (!threads) return 0;
+  size_t v = 0;
+  for (size_t t = 1; t <= workers; t *= 2) threads[v++] = t;
+  if ((size_t)threads[v - 1] != workers) threads[v++] = workers;
+  free(grid->values[0]);
+  grid->values[0] = threads;
+  grid->num_values[0] = v;
+  return 1;
+}
+
+// Returns 0 if a measurement failed.
+static int Search(uint64_t *array, size_t n, const TrialConfig *trials,
+                  size_t threads, int text, Saturation *sat) {
+  double rates[LADDER_LEN];
+  size_t measured = 0, stale = 0;
+  sat->threads = threads;
+  sat->peak_rate = 0;
+  BenchLog("  %6s  %10s  %8s  %8s\n", "chains", "ns/access", "M/s",
+           "MLP");
+  for (size_t i = 0; i < LADDER_LEN && stale < PLATEAU_STEPS; i++) {
+    size_t chains = kLadder[i];
+    if (chains * threads > MAX_CYCLE_MARKS || chains * threads > n) break;
+    BenchCall call = {.param_func = BenchChaseChains,
+                      .params = {(int64_t)chains, (int64_t)threads},
+                      .input = kStateRandomCycle};
+    SetBenchLogQuiet(1);
+    BenchResult result = RunTrials(&call, array, n, trials);
+    SetBenchLogQuiet(0);
+    if (result.iterations == 0) return 0;
+
+    double rate = 1.0 / result.ns_per_access;
+    if (i == 0) sat->latency_ns = result.ns_per_access * threads;
+    rates[measured++] = rate;
+    if (rate > sat->peak_rate * PROGRESS) {
+      stale = 0;
+    } else {
+      stale++;
+    }
+    if (rate > sat->peak_rate) {
+      sat->peak_rate = rate;
+      sat->peak_chains = chains;
+    }
+    BenchLog("  %6zu  %10.2f  %8.1f  %8.1f\n", chains, result.ns_per_access,
+             rate * 1e3, rate * sat->latency_ns / threads);
+    if (!text) {
+      char params[64];
+      snprintf(params, sizeof(params), "chains=%zu,threads=%zu", chains,
+               threads);
+      ReportResult("mlpsat", params, n * sizeof(uint64_t), &result);
+    }
+  }
+  sat->knee_chains = 0;
+  for (size_t i = 0; i < measured; i++) {
+    if (rates[i] >= sat->peak_rate * NEAR_PEAK) {
+      sat->knee_chains = kLadder[i];
+      sat->knee_rate = rates[i];
+      break;
+    }
+  }
+  return 1;
+}
+
+int RunMlpSearch(const ParamGrid *grid, uint64_t *array, size_t n,
+                 const TrialConfig *trials) {
+  size_t points = ParamGridSize(grid);
+  Saturation *sats = calloc(points, sizeof(Saturation));
+  if (!sats) {
+    fprintf(stderr, "Failed to allocate %zu search points\n", points);
+    return 0;
+  }
+  int text = ReportFormat() == kFormatText;
+  size_t done = 0;
+  for (size_t i = 0; i < points; i++) {
+    int64_t params[MAX_BENCH_PARAMS];
+    ParamGridPoint(grid, i, params);
+    size_t threads = (size_t)params[0];
+    BenchLog("\n=== MLP saturation: %zu thread%s ===\n", threads,
+             threads == 1 ? "" : "s");
+    if (!Search(array, n, trials, threads, text, &sats[done]) ||
+        sats[done].knee_chains == 0) {
+      break;
+    }
+    done++;
+  }
+
+  if (done) {
+    BenchLog("\n=== MLP saturation summary ===\n");
+    BenchLog("  %7s  %10s  %10s  %7s  %10s  %10s  %8s\n", "threads",
+             "latency ns", "peak M/s", "GB/s", "saturates", "MLP/thread",
+             "MLP all");
+    for (size_t i = 0; i < done; i++) {
+      const Saturation *s = &sats[i];
+      double mlp = s->peak_rate * s->latency_ns / s->threads;
+      BenchLog("  %7zu  %10.2f  %10.1f  %7.2f  %7zu ch  %10.1f  %8.1f\n",
+               s->threads, s->latency_ns, s->peak_rate * 1e3,
+               s->peak_rate * 64, s->knee_chains, mlp, mlp * s->threads);
+    }
+    BenchLog("  (saturates: fewest chains per thread within %.0f%% of the "
+             "peak; GB/s counts one 64-byte line per access)\n",
+             100 * (1 - NEAR_PEAK));
+  }
+  free(sats);
+  return done == points;
+}
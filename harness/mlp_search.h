@@ -0,0 +1,27 @@
+#ifndef HARNESS_MLP_SEARCH_H_
+#define HARNESS_MLP_SEARCH_H_
+
+#include "harness/params.h"
+#include "harness/runner.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Memory-level parallelism saturation search. For every thread count it
+// runs the interleaved chase (`mlp`) with a growing number of chains per
+// thread until throughput stops improving, and reports where it saturated.
+// By Little's law, throughput over the one-chain rate is the number of
+// misses a thread keeps in flight; the plateau estimates the line fill
+// buffers (miss handling registers) each thread can use, and how that
+// budget holds up as more threads share the memory system.
+
+// Grid of thread counts. Default: 1, 2, 4, ... up to the setup workers
+// (the --cpus list, else every online CPU), and that count itself.
+int MlpSearchGridInit(ParamGrid *grid);
+
+// Searches every thread count over the whole array. Returns 0 if a
+// measurement failed.
+int RunMlpSearch(const ParamGrid *grid, uint64_t *array, size_t n,
+                 const TrialConfig *trials);
+
+#endif
@@ -0,0 +1,188 @@
+#define _GNU_SOURCE
+#include "harness/numa.h"
+
+#include <errno.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// From <linux/mempolicy.h>; spelled out so libnuma headers are not needed.
+#define MPOL_BIND 2
+#define MPOL_MF_STRICT (1 << 0)
+#define MPOL_MF_MOVE (1 << 1)
+#define MPOL_F_NODE (1 << 0)
+#define MPOL_F_ADDR (1 << 1)
+
+#define BITS_PER_LONG (8 * sizeof(unsigned long))
+#define MASK_LONGS ((MAX_NUMA_NODES + BITS_PER_LONG - 1) / BITS_PER_LONG)
+
+static int g_worker_cpus[MAX_CPUS];
+static int g_num_worker_cpus;
+// CPUs the process was started on (e.g. under taskset), in order.
+static int g_launch_cpus[MAX_CPUS];
+static int g_num_launch_cpus;
+
+int ParseCpuList(const char *text, int *cpus, int max) {
+  int count = 0;
+  const char *p = text;
+  while (*p && *p != '\n') {
+    char *end;
+    long lo = strtol(p, &end, 10);
+    if (end == p || lo < 0) return -1;
+    long hi = lo;
+    p = end;
+    if (*p == '-') {
+      hi = strtol(p + 1, &end, 10);
+      if (end == p + 1 || hi < lo) return -1;
+      p = end;
+    }
+    for (long c = lo; c <= hi; c++) {
+      if (count == max) return -1;
+      cpus[count++] = (int)c;
+    }
+    if (*p == ',') {
+      p++;
+    } else if (*p && *p != '\n') {
+      return -1;
+    }
+  }
+  return count;
+}
+
+// Reads a sysfs list file into `out`. Returns the count or -1.
+static int ReadListFile(const char *path, int *out, int max) {
+  FILE *f = fopen(path, "r");
+  if (!f) return -1;
+  char line[4096];
+  int count = -1;
+  if (fgets(line, sizeof(line), f)) count = ParseCpuList(line, out, max);
+  fclose(f);
+  return count;
+}
+
+int NumaNodeCount(void) {
+  int nodes[MAX_NUMA_NODES];
+  int count = ReadListFile("/sys/devices/system/node/online", nodes,
+                           MAX_NUMA_NODES);
+  if (count <= 0) return 1;
+  return nodes[count - 1] + 1;
+}
+
+int NumaNodeCpus(int node, int *cpus, int max) {
+  char path[64];
+  snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist",
+           node);
+  int count = ReadListFile(path, cpus, max);
+  if (count >= 0) return count;
+  // No sysfs node directory: a non-NUMA kernel owns every CPU as "node 0".
+  if (node != 0) return 0;
+  long online = sysconf(_SC_NPROCESSORS_ONLN);
+  count = 0;
+  for (long c = 0; c < online && count < max; c++) cpus[count++] = (int)c;
+  return count;
+}
+
+int NumaNodeHasMemory(int node) {
+  int nodes[MAX_NUMA_NODES];
+  int count = ReadListFile("/sys/devices/system/node/has_memory", nodes,
+                           MAX_NUMA_NODES);
+  if (count < 0) return node == 0;
+  for (int i = 0; i < count; i++) {
+    if (nodes[i] == node) return 1;
+  }
+  return 0;
+}
+
+static void NodeMask(int node, unsigned long *mask) {
+  memset(mask, 0, MASK_LONGS * sizeof(unsigned long));
+  mask[node / BITS_PER_LONG] |= 1UL << (node % BITS_PER_LONG);
+}
+
+int NumaBindMemory(void *addr, size_t bytes, int node) {
+  if (node < 0 || node >= MAX_NUMA_NODES) return 0;
+  unsigned long mask[MASK_LONGS];
+  NodeMask(node, mask);
+  // The kernel reads maxnode - 1 bits.
+  if (syscall(SYS_mbind, addr, bytes, MPOL_BIND, mask, MAX_NUMA_NODES + 1,
+              MPOL_MF_STRICT | MPOL_MF_MOVE) != 0) {
+    fprintf(stderr, "mbind to node %d failed: %s\n", node, strerror(errno));
+    return 0;
+  }
+  return 1;
+}
+
+int NumaSetThreadPolicy(int node) {
+  if (node < 0 || node >= MAX_NUMA_NODES) return 0;
+  unsigned long mask[MASK_LONGS];
+  NodeMask(node, mask);
+  if (syscall(SYS_set_mempolicy, MPOL_BIND, mask, MAX_NUMA_NODES + 1) != 0) {
+    fprintf(stderr, "set_mempolicy to node %d failed: %s\n", node,
+            strerror(errno));
+    return 0;
+  }
+  return 1;
+}
+
+int NumaNodeOfAddress(const void *addr) {
+  int node = -1;
+  if (syscall(SYS_get_mempolicy, &node, NULL, 0, addr,
+              MPOL_F_NODE | MPOL_F_ADDR) != 0) {
+    return -1;
+  }
+  return node;
+}
+
+int PinCurrentThread(int cpu) {
+  if (cpu < 0 || cpu >= CPU_SETSIZE) return 0;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+void SaveLaunchAffinity(void) {
+  cpu_set_t set;
+  g_num_launch_cpus = 0;
+  if (sched_getaffinity(0, sizeof(set), &set) != 0) return;
+  for (int cpu = 0; cpu < CPU_SETSIZE && g_num_launch_cpus < MAX_CPUS;
+       cpu++) {
+    if (CPU_ISSET(cpu, &set)) g_launch_cpus[g_num_launch_cpus++] = cpu;
+  }
+}
+
+int GetLaunchCpus(int *cpus, int max) {
+  int count = g_num_launch_cpus < max ? g_num_launch_cpus : max;
+  memcpy(cpus, g_launch_cpus, count * sizeof(int));
+  return count;
+}
+
+void SetWorkerCpus(const int *cpus, int count) {
+  if (count > MAX_CPUS) count = MAX_CPUS;
+  memcpy(g_worker_cpus, cpus, count * sizeof(int));
+  g_num_worker_cpus = count;
+}
+
+int GetWorkerCpus(int *cpus, int max) {
+  int count = g_num_worker_cpus < max ? g_num_worker_cpus : max;
+  memcpy(cpus, g_worker_cpus, count * sizeof(int));
+  return count;
+}
+
+int PinWorker(size_t index) {
+  // Only a changed CPU costs a syscall, so repeated runs pin for free.
+  static _Thread_local int pinned_cpu = -1;
+  const int *cpus = g_num_worker_cpus > 0 ? g_worker_cpus : g_launch_cpus;
+  int count = g_num_worker_cpus > 0 ? g_num_worker_cpus : g_num_launch_cpus;
+  if (count == 0) return 1;
+  int cpu = cpus[index % count];
+  if (cpu == pinned_cpu) return 1;
+  if (!PinCurrentThread(cpu)) {
+    fprintf(stderr, "Cannot pin worker %zu to CPU %d\n", index, cpu);
+    return 0;
+  }
+  pinned_cpu = cpu;
+  return 1;
+}
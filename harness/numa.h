@@ -0,0 +1,53 @@
+#ifndef HARNESS_NUMA_H_
+#define HARNESS_NUMA_H_
+
+#include <stddef.h>
+
+#define MAX_NUMA_NODES 64
+#define MAX_CPUS 1024
+
+// Number of NUMA nodes (highest online node + 1). Returns 1 on kernels
+// without NUMA support, so callers can always treat node 0 as present.
+int NumaNodeCount(void);
+
+// CPUs of `node` from sysfs. Returns the count, 0 for memory-only nodes.
+int NumaNodeCpus(int node, int *cpus, int max);
+
+// Whether `node` has memory that can be bound to.
+int NumaNodeHasMemory(int node);
+
+// Parses a Linux cpulist such as "0-3,8,10-11". Returns the number of
+// entries, or -1 if the list is malformed or has more than `max` entries.
+int ParseCpuList(const char *text, int *cpus, int max);
+
+// Binds [addr, addr + bytes) to `node` with mbind(MPOL_BIND), migrating
+// pages that are already resident. Returns 1 on success.
+int NumaBindMemory(void *addr, size_t bytes, int node);
+
+// Restricts future allocations of the calling thread (and threads it
+// creates afterwards) to `node` with set_mempolicy(MPOL_BIND).
+int NumaSetThreadPolicy(int node);
+
+// Node holding the page at `addr`, or -1 if unknown or not yet faulted in.
+int NumaNodeOfAddress(const void *addr);
+
+// Pins the calling thread to a single CPU. Returns 1 on success.
+int PinCurrentThread(int cpu);
+
+// Records the calling thread's affinity as the CPUs the process may use.
+// Call once at startup, before any thread is pinned.
+void SaveLaunchAffinity(void);
+// The CPUs recorded by SaveLaunchAffinity(), ascending. Returns the count.
+int GetLaunchCpus(int *cpus, int max);
+
+// CPUs PinWorker() hands out round-robin; count 0 falls back to the launch
+// CPUs.
+void SetWorkerCpus(const int *cpus, int count);
+int GetWorkerCpus(int *cpus, int max);
+
+// Pins the calling pool worker to the index-th CPU (round-robin) of the
+// worker list, or of the launch CPUs if the list is empty. Returns 0 if
+// the CPU cannot be used.
+int PinWorker(size_t index);
+
+#endif
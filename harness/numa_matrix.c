@@ -0,0 +1,161 @@
+#define _GNU_SOURCE
+#include "harness/numa_matrix.h"
+
+#include "bench.h"
+#include "harness/array_state.h"
+#include "harness/numa.h"
+#include "harness/parallel.h"
+#include "harness/report.h"
+#include "harness/units.h"
+
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct {
+  int cpu_nodes[MAX_NUMA_NODES];
+  int num_cpu_nodes;
+  int mem_nodes[MAX_NUMA_NODES];
+  int num_mem_nodes;
+} NodeLayout;
+
+static void GetNodeLayout(NodeLayout *layout) {
+  int cpus[MAX_CPUS];
+  int nodes = NumaNodeCount();
+  layout->num_cpu_nodes = 0;
+  layout->num_mem_nodes = 0;
+  for (int node = 0; node < nodes && node < MAX_NUMA_NODES; node++) {
+    if (NumaNodeCpus(node, cpus, MAX_CPUS) > 0) {
+      layout->cpu_nodes[layout->num_cpu_nodes++] = node;
+    }
+    if (NumaNodeHasMemory(node)) {
+      layout->mem_nodes[layout->num_mem_nodes++] = node;
+    }
+  }
+}
+
+// Measures one cell. Returns 0 if the array could not be placed or a
+// measurement failed.
+static int RunCell(int cpu_node, int mem_node, size_t bytes, PagePolicy pages,
+                   const TrialConfig *trials, double *ns, double *gbps) {
+  uint64_t *array = AllocArray(bytes, pages);
+  if (!array) return 0;
+  if (!NumaBindMemory(array, bytes, mem_node)) {
+    FreeArray(array, bytes, pages);
+    return 0;
+  }
+  size_t n = bytes / sizeof(uint64_t);
+  ParallelFillIdentity(array, n);
+  int actual = NumaNodeOfAddress(array);
+  if (actual >= 0 && actual != mem_node) {
+    fprintf(stderr, "Warning: array landed on node %d, not %d\n", actual,
+            mem_node);
+  }
+
+  char params[64];
+  snprintf(params, sizeof(params), "cpu_node=%d,mem_node=%d", cpu_node,
+           mem_node);
+  int text = ReportFormat() == kFormatText;
+
+  BenchCall chase = {.func = BenchPointerChase, .input = kStateRandomCycle};
+  BenchResult result = RunTrials(&chase, array, n, trials);
+  int ok = result.iterations > 0;
+  *ns = result.ns_per_access;
+  if (ok && !text) ReportResult("numa_chase", params, bytes, &result);
+
+  if (ok) {
+    int cpus[MAX_CPUS];
+    BenchCall bw = {.param_func = BenchBwThreads, .input = kStateIdentity};
+    bw.params[0] = GetWorkerCpus(cpus, MAX_CPUS);
+    result = RunTrials(&bw, array, n, trials);
+    ok = result.iterations > 0;
+    *gbps = ok ? sizeof(uint64_t) / result.ns_per_access : 0;
+    if (ok && !text) ReportResult("numa_bw", params, bytes, &result);
+  }
+
+  ForgetArrayState(array);
+  FreeArray(array, bytes, pages);
+  return ok;
+}
+
+static void PrintMatrix(const char *title, const char *unit,
+                        const NodeLayout *layout, const double *cells) {
+  BenchLog("\n%s (%s), rows = CPU node, columns = memory node\n", title, unit);
+  BenchLog("%8s", "");
+  for (int m = 0; m < layout->num_mem_nodes; m++) {
+    char label[16];
+    snprintf(label, sizeof(label), "node%d", layout->mem_nodes[m]);
+    BenchLog(" %11s", label);
+  }
+  BenchLog("\n");
+  for (int c = 0; c < layout->num_cpu_nodes; c++) {
+    BenchLog("  node%-2d", layout->cpu_nodes[c]);
+    for (int m = 0; m < layout->num_mem_nodes; m++) {
+      BenchLog(" %11.2f", cells[c * layout->num_mem_nodes + m]);
+    }
+    BenchLog("\n");
+  }
+}
+
+int RunNumaMatrix(size_t bytes, PagePolicy pages, const TrialConfig *trials) {
+  NodeLayout layout;
+  GetNodeLayout(&layout);
+  if (layout.num_cpu_nodes == 0 || layout.num_mem_nodes == 0) {
+    fprintf(stderr, "No NUMA topology found in sysfs\n");
+    return 0;
+  }
+
+  char buf[32];
+  BenchLog("\n=== NUMA matrix: %d CPU node(s) x %d memory node(s), %s ===\n",
+           layout.num_cpu_nodes, layout.num_mem_nodes,
+           FormatBytes(bytes, buf, sizeof(buf)));
+  if (layout.num_cpu_nodes == 1 && layout.num_mem_nodes == 1) {
+    BenchLog("Single NUMA node: only local latency and bandwidth can be "
+             "measured\n");
+  }
+
+  size_t cells = (size_t)layout.num_cpu_nodes * layout.num_mem_nodes;
+  double *latency = calloc(cells, sizeof(double));
+  double *bandwidth = calloc(cells, sizeof(double));
+  if (!latency || !bandwidth) {
+    fprintf(stderr, "Failed to allocate NUMA matrix\n");
+    free(latency);
+    free(bandwidth);
+    return 0;
+  }
+
+  // The matrix drives placement itself; --cpus is restored afterwards.
+  cpu_set_t saved_affinity;
+  sched_getaffinity(0, sizeof(saved_affinity), &saved_affinity);
+  int saved_cpus[MAX_CPUS];
+  int num_saved = GetWorkerCpus(saved_cpus, MAX_CPUS);
+
+  int ok = 1;
+  for (int c = 0; c < layout.num_cpu_nodes && ok; c++) {
+    int cpus[MAX_CPUS];
+    int num_cpus = NumaNodeCpus(layout.cpu_nodes[c], cpus, MAX_CPUS);
+    PinCurrentThread(cpus[0]);
+    SetWorkerCpus(cpus, num_cpus);
+    for (int m = 0; m < layout.num_mem_nodes && ok; m++) {
+      size_t cell = (size_t)c * layout.num_mem_nodes + m;
+      ok = RunCell(layout.cpu_nodes[c], layout.mem_nodes[m], bytes, pages,
+                   trials, &latency[cell], &bandwidth[cell]);
+      if (ok) {
+        BenchLog("  cpu node %d -> memory node %d: %.2f ns, %.1f GB/s\n",
+                 layout.cpu_nodes[c], layout.mem_nodes[m], latency[cell],
+                 bandwidth[cell]);
+      }
+    }
+  }
+
+  sched_setaffinity(0, sizeof(saved_affinity), &saved_affinity);
+  SetWorkerCpus(saved_cpus, num_saved);
+
+  if (ok) {
+    PrintMatrix("Pointer-chase latency", "ns", &layout, latency);
+    PrintMatrix("Read bandwidth", "GB/s", &layout, bandwidth);
+  }
+  free(latency);
+  free(bandwidth);
+  return ok;
+}
@@ -0,0 +1,16 @@
+#ifndef HARNESS_NUMA_MATRIX_H_
+#define HARNESS_NUMA_MATRIX_H_
+
+#include "harness/alloc.h"
+#include "harness/runner.h"
+
+#include <stddef.h>
+
+// For every (CPU node, memory node) pair: binds a fresh `bytes` array to the
+// memory node, runs the pointer chase from a CPU of the CPU node and the
+// read-bandwidth kernel with one thread per CPU of that node, then prints
+// node x node latency and bandwidth matrices. On a single-node machine this
+// is one local measurement. Returns 0 if no array could be set up.
+int RunNumaMatrix(size_t bytes, PagePolicy pages, const TrialConfig *trials);
+
+#endif
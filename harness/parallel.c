@@ -0,0 +1,182 @@
+#include "harness/parallel.h"
+
+#include "harness/numa.h"
+#include "harness/pool.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Below this many elements the pool round-trip costs more than it saves.
+#define MIN_PARALLEL_ELEMENTS ((size_t)1 << 16)
+#define MAX_SETUP_WORKERS 256
+
+typedef struct {
+  size_t begin;
+  size_t end;
+  RangeFunc func;
+  void *ctx;
+} RangeArg;
+
+static void RunRange(void *arg) {
+  RangeArg *ra = arg;
+  ra->func(ra->begin, ra->end, ra->ctx);
+}
+
+size_t SetupWorkers(void) {
+  int cpus[MAX_CPUS];
+  size_t workers = GetWorkerCpus(cpus, MAX_CPUS);
+  if (workers == 0) workers = GetLaunchCpus(cpus, MAX_CPUS);
+  if (workers == 0) {
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    workers = online > 0 ? (size_t)online : 1;
+  }
+  return workers < MAX_SETUP_WORKERS ? workers : MAX_SETUP_WORKERS;
+}
+
+// Splits [0, n) into `workers` contiguous chunks; returns the chunk count.
+static size_t SplitRange(size_t n, size_t workers, RangeFunc func, void *ctx,
+                         RangeArg *args) {
+  if (workers > n) workers = n ? n : 1;
+  size_t chunk = n / workers;
+  size_t remainder = n % workers;
+  size_t offset = 0;
+  for (size_t w = 0; w < workers; w++) {
+    args[w].begin = offset;
+    offset += chunk + (w < remainder ? 1 : 0);
+    args[w].end = offset;
+    args[w].func = func;
+    args[w].ctx = ctx;
+  }
+  return workers;
+}
+
+static void RunSplit(size_t n, size_t min_parallel, RangeFunc func,
+                     void *ctx) {
+  size_t workers = SetupWorkers();
+  if (n < min_parallel || workers == 1) {
+    func(0, n, ctx);
+    return;
+  }
+  RangeArg args[MAX_SETUP_WORKERS];
+  workers = SplitRange(n, workers, func, ctx, args);
+  if (!PoolRun(workers, RunRange, args, sizeof(RangeArg), NULL)) {
+    func(0, n, ctx);
+  }
+}
+
+void ParallelFor(size_t n, RangeFunc func, void *ctx) {
+  RunSplit(n, MIN_PARALLEL_ELEMENTS, func, ctx);
+}
+
+void ParallelForEach(size_t count, RangeFunc func, void *ctx) {
+  RunSplit(count, 2, func, ctx);
+}
+
+static void FillIdentity(size_t begin, size_t end, void *ctx) {
+  uint64_t *array = ctx;
+  for (size_t i = begin; i < end; i++) {
+    array[i] = i;
+  }
+}
+
+void ParallelFillIdentity(uint64_t *array, size_t n) {
+  ParallelFor(n, FillIdentity, array);
+}
+
+typedef struct {
+  uint64_t *dst;
+  const uint64_t *src;
+} CopyCtx;
+
+static void CopyRange(size_t begin, size_t end, void *ctx) {
+  CopyCtx *c = ctx;
+  memcpy(c->dst + begin, c->src + begin, (end - begin) * sizeof(uint64_t));
+}
+
+void ParallelCopy(uint64_t *dst, const uint64_t *src, size_t n) {
+  CopyCtx copy = {.dst = dst, .src = src};
+  ParallelFor(n, CopyRange, &copy);
+}
+
+static int CompareU64(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *)a;
+  uint64_t y = *(const uint64_t *)b;
+  return (x > y) - (x < y);
+}
+
+typedef struct {
+  uint64_t *src;
+  uint64_t *dst;
+  const size_t *bounds;  // Chunk boundaries, num_runs + 1 entries
+  size_t num_runs;
+} SortCtx;
+
+typedef struct {
+  const SortCtx *ctx;
+  size_t run;  // First of the two runs to merge
+} MergeArg;
+
+static void SortChunk(void *arg) {
+  RangeArg *ra = arg;
+  uint64_t *array = ra->ctx;
+  qsort(array + ra->begin, ra->end - ra->begin, sizeof(uint64_t), CompareU64);
+}
+
+// Merges runs `run` and `run + 1` of src into dst (or copies a lone run).
+static void MergeRuns(void *arg) {
+  MergeArg *ma = arg;
+  const SortCtx *c = ma->ctx;
+  size_t lo = c->bounds[ma->run];
+  size_t mid = c->bounds[ma->run + 1];
+  size_t hi = ma->run + 2 <= c->num_runs ? c->bounds[ma->run + 2] : mid;
+  size_t i = lo, j = mid, k = lo;
+  while (i < mid && j < hi) {
+    c->dst[k++] = c->src[j] < c->src[i] ? c->src[j++] : c->src[i++];
+  }
+  memcpy(c->dst + k, c->src + i, (mid - i) * sizeof(uint64_t));
+  k += mid - i;
+  memcpy(c->dst + k, c->src + j, (hi - j) * sizeof(uint64_t));
+}
+
+void ParallelSortU64(uint64_t *array, size_t n) {
+  size_t workers = SetupWorkers();
+  uint64_t *scratch = NULL;
+  if (n >= MIN_PARALLEL_ELEMENTS && workers > 1) {
+    scratch = malloc(n * sizeof(uint64_t));
+  }
+  if (!scratch) {
+    qsort(array, n, sizeof(uint64_t), CompareU64);
+    return;
+  }
+
+  RangeArg chunks[MAX_SETUP_WORKERS];
+  size_t num_runs = SplitRange(n, workers, NULL, array, chunks);
+  PoolRun(num_runs, SortChunk, chunks, sizeof(RangeArg), NULL);
+
+  size_t bounds[MAX_SETUP_WORKERS + 1];
+  for (size_t r = 0; r < num_runs; r++) bounds[r] = chunks[r].begin;
+  bounds[num_runs] = n;
+
+  // Each round halves the number of runs, ping-ponging between buffers.
+  SortCtx ctx = {.src = array, .dst = scratch, .bounds = bounds,
+                 .num_runs = num_runs};
+  MergeArg merges[MAX_SETUP_WORKERS];
+  while (ctx.num_runs > 1) {
+    size_t pairs = (ctx.num_runs + 1) / 2;
+    for (size_t p = 0; p < pairs; p++) {
+      merges[p].ctx = &ctx;
+      merges[p].run = 2 * p;
+    }
+    PoolRun(pairs, MergeRuns, merges, sizeof(MergeArg), NULL);
+    for (size_t p = 0; p <= pairs; p++) {
+      bounds[p] = p < pairs ? bounds[2 * p] : n;
+    }
+    ctx.num_runs = pairs;
+    uint64_t *tmp = ctx.src;
+    ctx.src = ctx.dst;
+    ctx.dst = tmp;
+  }
+  if (ctx.src != array) ParallelCopy(array, ctx.src, n);
+  free(scratch);
+}
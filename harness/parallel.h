@@ -0,0 +1,40 @@
+#ifndef HARNESS_PARALLEL_H_
+#define HARNESS_PARALLEL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Data-parallel helpers for untimed setup work, built on the worker pool.
+// Ranges are split into SetupWorkers() contiguous chunks, one per worker in
+// worker order. Pool workers are pinned (see pool.h), so each page is first
+// touched on the node of the CPU whose worker's chunk holds it. A benchmark that later reads with the same number
+// of pool workers and a static split finds its share local. With any other
+// thread count (bw_1..bw_8, or threads= on bw, stream and mlp), shares only
+// partly line up with the setup chunks, and placement is only as good as
+// that overlap.
+
+// Handles elements [begin, end) of a ParallelFor range.
+typedef void (*RangeFunc)(size_t begin, size_t end, void *ctx);
+
+// Workers used for setup: the --cpus list if given, else the CPUs the
+// process was launched on.
+size_t SetupWorkers(void);
+
+// Runs func over [0, n) on SetupWorkers() workers (inline for small n).
+void ParallelFor(size_t n, RangeFunc func, void *ctx);
+
+// Like ParallelFor, but for `count` coarse work items (blocks, buckets):
+// always fans out, with at most one worker per item.
+void ParallelForEach(size_t count, RangeFunc func, void *ctx);
+
+// array[i] = i, first-touched in parallel.
+void ParallelFillIdentity(uint64_t *array, size_t n);
+
+// dst[i] = src[i] in parallel.
+void ParallelCopy(uint64_t *dst, const uint64_t *src, size_t n);
+
+// Sorts ascending: parallel chunk sorts, then pairwise parallel merges
+// through a scratch buffer (falls back to qsort if that cannot be had).
+void ParallelSortU64(uint64_t *array, size_t n);
+
+#endif
@@ -0,0 +1,211 @@
+#include "harness/params.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int ParamGridInit(ParamGrid *grid, const ParamBenchEntry *entry) {
+  memset(grid, 0, sizeof(*grid));
+  grid->entry = entry;
+  while (grid->num_params < MAX_BENCH_PARAMS &&
+         entry->params[grid->num_params].name) {
+    size_t p = grid->num_params++;
+    grid->values[p] = malloc(sizeof(int64_t));
+    if (!grid->values[p]) return 0;
+    grid->values[p][0] = entry->params[p].def;
+    grid->num_values[p] = 1;
+  }
+  return 1;
+}
+
+void ParamGridFree(ParamGrid *grid) {
+  for (size_t p = 0; p < grid->num_params; p++) free(grid->values[p]);
+  memset(grid, 0, sizeof(*grid));
+}
+
+// Number with an optional binary K/M/G suffix. Advances *text. On
+// overflow (or a negative size) sets *error and returns 0.
+static int ParseNumber(const char **text, int64_t *out, const char **error) {
+  char *end;
+  errno = 0;
+  long long v = strtoll(*text, &end, 10);
+  if (end == *text) return 0;
+  if (errno == ERANGE) {
+    *error = "value too large";
+    return 0;
+  }
+  int shift = 0;
+  switch (toupper((unsigned char)*end)) {
+    case 'K': shift = 10; end++; break;
+    case 'M': shift = 20; end++; break;
+    case 'G': shift = 30; end++; break;
+    default: break;
+  }
+  if (shift && v < 0) {
+    *error = "negative size";
+    return 0;
+  }
+  if (__builtin_mul_overflow(v, 1LL << shift, &v)) {
+    *error = "value too large";
+    return 0;
+  }
+  *out = v;
+  *text = end;
+  return 1;
+}
+
+static int Push(int64_t **values, size_t *count, size_t *cap, int64_t v) {
+  if (*count == *cap) {
+    *cap = *cap ? *cap * 2 : 8;
+    int64_t *grown = realloc(*values, *cap * sizeof(int64_t));
+    if (!grown) return 0;
+    *values = grown;
+  }
+  (*values)[(*count)++] = v;
+  return 1;
+}
+
+// Expands one comma-separated item into `values`. *error may receive a
+// reason for the failure.
+static int ParseItem(const BenchParam *param, const char *item,
+                     int64_t **values, size_t *count, size_t *cap,
+                     const char **error) {
+  for (size_t v = 0; param->names && param->names[v]; v++) {
+    if (strcmp(item, param->names[v]) == 0) {
+      return Push(values, count, cap, (int64_t)v);
+    }
+  }
+  const char *p = item;
+  int64_t lo, hi, step = 1;
+  if (!ParseNumber(&p, &lo, error)) return 0;
+  if (*p == '\0') return Push(values, count, cap, lo);
+  if (strncmp(p, "..", 2) != 0) return 0;
+  p += 2;
+  if (!ParseNumber(&p, &hi, error) || hi < lo) return 0;
+
+  int geometric = 0;
+  if (*p == ':' || *p == '*') {
+    geometric = (*p == '*');
+    p++;
+    if (!ParseNumber(&p, &step, error)) return 0;
+  }
+  if (*p != '\0') return 0;
+  if (geometric ? (step < 2 || lo < 1) : step < 1) return 0;
+
+  // v <= hi throughout, so the unsigned distance cannot wrap, and the next
+  // value is only formed when it stays within [lo, hi].
+  for (int64_t v = lo;; v = geometric ? v * step : v + step) {
+    if (*count >= MAX_GRID_POINTS) return 0;
+    if (!Push(values, count, cap, v)) return 0;
+    int last = geometric ? v > hi / step
+                         : (uint64_t)hi - (uint64_t)v < (uint64_t)step;
+    if (last) break;
+  }
+  return 1;
+}
+
+int ParamGridSet(ParamGrid *grid, const char *assignment) {
+  const char *eq = strchr(assignment, '=');
+  size_t key_len = eq ? (size_t)(eq - assignment) : 0;
+  size_t p = 0;
+  while (p < grid->num_params &&
+         (strlen(grid->entry->params[p].name) != key_len ||
+          strncmp(grid->entry->params[p].name, assignment, key_len) != 0)) {
+    p++;
+  }
+  if (!eq || p == grid->num_params) {
+    fprintf(stderr, "Error: '%s' has no parameter '%.*s'\n",
+            grid->entry->cli_name, (int)key_len, assignment);
+    return 0;
+  }
+
+  const BenchParam *param = &grid->entry->params[p];
+  int64_t *values = NULL;
+  size_t count = 0, cap = 0;
+  size_t list_len = strlen(eq + 1);
+  char *list = malloc(list_len + 1);
+  if (!list) {
+    fprintf(stderr, "Error: Out of memory parsing %s\n", param->name);
+    return 0;
+  }
+  memcpy(list, eq + 1, list_len + 1);
+  int ok = 1;
+  for (char *save, *item = strtok_r(list, ",", &save); item && ok;
+       item = strtok_r(NULL, ",", &save)) {
+    size_t before = count;
+    const char *error = NULL;
+    ok = ParseItem(param, item, &values, &count, &cap, &error);
+    if (!ok) {
+      fprintf(stderr, "Error: Bad value '%s' for %s%s%s\n", item, param->name,
+              error ? ": " : "", error ? error : "");
+    }
+    for (size_t i = before; ok && i < count; i++) {
+      if (values[i] < param->min || values[i] > param->max) {
+        fprintf(stderr,
+                "Error: %s=%lld out of range [%lld, %lld]\n", param->name,
+                (long long)values[i], (long long)param->min,
+                (long long)param->max);
+        ok = 0;
+      }
+    }
+  }
+  free(list);
+  if (!ok || count == 0) {
+    if (ok) fprintf(stderr, "Error: No values for %s\n", param->name);
+    free(values);
+    return 0;
+  }
+
+  free(grid->values[p]);
+  grid->values[p] = values;
+  grid->num_values[p] = count;
+  if (ParamGridSize(grid) > MAX_GRID_POINTS) {
+    fprintf(stderr, "Error: More than %d parameter combinations\n",
+            MAX_GRID_POINTS);
+    return 0;
+  }
+  return 1;
+}
+
+size_t ParamGridSize(const ParamGrid *grid) {
+  size_t size = 1;
+  for (size_t p = 0; p < grid->num_params; p++) {
+    size *= grid->num_values[p];
+    if (size > MAX_GRID_POINTS) return MAX_GRID_POINTS + 1;
+  }
+  return size;
+}
+
+void ParamGridPoint(const ParamGrid *grid, size_t index, int64_t *out) {
+  for (size_t p = grid->num_params; p-- > 0;) {
+    out[p] = grid->values[p][index % grid->num_values[p]];
+    index /= grid->num_values[p];
+  }
+}
+
+const char *FormatParamValue(const BenchParam *param, int64_t value,
+                             char *buf, size_t size) {
+  if (param->names && value >= param->min && value <= param->max) {
+    snprintf(buf, size, "%s", param->names[value]);
+  } else {
+    snprintf(buf, size, "%lld", (long long)value);
+  }
+  return buf;
+}
+
+const char *FormatParams(const ParamBenchEntry *entry, const int64_t *values,
+                         char *buf, size_t size) {
+  size_t len = 0;
+  buf[0] = '\0';
+  for (size_t p = 0; p < MAX_BENCH_PARAMS && entry->params[p].name; p++) {
+    char value[32];
+    int written = snprintf(
+        buf + len, size - len, "%s%s=%s", p ? "," : "", entry->params[p].name,
+        FormatParamValue(&entry->params[p], values[p], value, sizeof(value)));
+    if (written < 0 || (size_t)written >= size - len) break;
+    len += written;
+  }
+  return buf;
+}
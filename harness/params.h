@@ -0,0 +1,49 @@
+#ifndef HARNESS_PARAMS_H_
+#define HARNESS_PARAMS_H_
+
+#include "bench.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Value lists for every parameter of a ParamBenchEntry. Running the grid
+// visits the cartesian product, first parameter varying slowest.
+typedef struct {
+  const ParamBenchEntry *entry;
+  size_t num_params;
+  size_t num_values[MAX_BENCH_PARAMS];
+  int64_t *values[MAX_BENCH_PARAMS];
+} ParamGrid;
+
+// Upper bound on the number of grid points a command line may request.
+#define MAX_GRID_POINTS 100000
+
+// Starts with every parameter at its default. Returns 0 on allocation
+// failure.
+int ParamGridInit(ParamGrid *grid, const ParamBenchEntry *entry);
+void ParamGridFree(ParamGrid *grid);
+
+// Applies one command line assignment. Values are comma-separated items,
+// each either a number (with optional K/M/G suffix), a value name of a
+// parameter with `names`, or a range:
+//   a..b      every integer from a to b
+//   a..b:s    from a to b in steps of s
+//   a..b*f    a, a*f, a*f*f, ... up to b
+// Prints the problem and returns 0 on a bad key, value or range.
+int ParamGridSet(ParamGrid *grid, const char *assignment);
+
+size_t ParamGridSize(const ParamGrid *grid);
+
+// Writes the parameter values of grid point `index` to `out`.
+void ParamGridPoint(const ParamGrid *grid, size_t index, int64_t *out);
+
+// `value` as written on the command line: its name if the parameter has
+// names, else the number. Returns `buf`.
+const char *FormatParamValue(const BenchParam *param, int64_t value,
+                             char *buf, size_t size);
+
+// "stride=4096,threads=2" for the given values. Returns `buf`.
+const char *FormatParams(const ParamBenchEntry *entry, const int64_t *values,
+                         char *buf, size_t size);
+
+#endif
@@ -0,0 +1,135 @@
+#define _GNU_SOURCE
+#include "harness/perf_counters.h"
+
+#include <linux/perf_event.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define CACHE_EVENT(cache, op, result) \
+  ((cache) | ((op) << 8) | ((result) << 16))
+
+typedef struct {
+  const char *label;
+  const char *key;
+  uint32_t type;
+  uint64_t config;
+} CounterSpec;
+
+// Indexed by the kCounter* enum in bench.h. The cycle counter leads the
+// group so every member is scheduled onto the PMU together.
+static const CounterSpec kCounterSpecs[kNumCounters] = {
+    {"cycles", "cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"instructions", "instructions", PERF_TYPE_HARDWARE,
+     PERF_COUNT_HW_INSTRUCTIONS},
+    {"LLC miss", "llc_misses", PERF_TYPE_HW_CACHE,
+     CACHE_EVENT(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ,
+                 PERF_COUNT_HW_CACHE_RESULT_MISS)},
+    {"dTLB miss", "dtlb_misses", PERF_TYPE_HW_CACHE,
+     CACHE_EVENT(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ,
+                 PERF_COUNT_HW_CACHE_RESULT_MISS)},
+    {"br miss", "branch_misses", PERF_TYPE_HARDWARE,
+     PERF_COUNT_HW_BRANCH_MISSES},
+    // The kernel maps L1D read misses to L1D.REPLACEMENT on Intel cores.
+    {"L1D repl", "l1d_replacements", PERF_TYPE_HW_CACHE,
+     CACHE_EVENT(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ,
+                 PERF_COUNT_HW_CACHE_RESULT_MISS)},
+};
+
+typedef struct {
+  uint64_t value;
+  uint64_t time_enabled;
+  uint64_t time_running;
+} CounterReading;
+
+static int g_fds[kNumCounters] = {-1, -1, -1, -1, -1, -1};
+static int g_leader = -1;
+static CounterReading g_begin[kNumCounters];
+static CounterReading g_end[kNumCounters];
+static int g_region_done = 0;
+
+static int OpenCounter(const CounterSpec *spec, int group_fd) {
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = spec->type;
+  attr.config = spec->config;
+  attr.disabled = (group_fd == -1);
+  attr.inherit = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format =
+      PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+
+int PerfCountersOpen(void) {
+  int opened = 0;
+  for (int i = 0; i < kNumCounters; i++) {
+    g_fds[i] = OpenCounter(&kCounterSpecs[i], g_leader);
+    if (g_fds[i] < 0) continue;
+    if (g_leader < 0) g_leader = g_fds[i];
+    opened++;
+  }
+  if (opened == 0) {
+    fprintf(stderr, "Hardware counters unavailable (perf_event_open "
+                    "refused; check perf_event_paranoid)\n");
+  }
+  return opened;
+}
+
+void PerfCountersClose(void) {
+  for (int i = 0; i < kNumCounters; i++) {
+    if (g_fds[i] >= 0) close(g_fds[i]);
+    g_fds[i] = -1;
+  }
+  g_leader = -1;
+}
+
+static void ReadAll(CounterReading *out) {
+  for (int i = 0; i < kNumCounters; i++) {
+    if (g_fds[i] < 0 ||
+        read(g_fds[i], &out[i], sizeof(out[i])) != sizeof(out[i])) {
+      memset(&out[i], 0, sizeof(out[i]));
+    }
+  }
+}
+
+void PerfRegionBegin(void) {
+  if (g_leader < 0) return;
+  g_region_done = 0;
+  ReadAll(g_begin);
+  ioctl(g_leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+void PerfRegionEnd(void) {
+  if (g_leader < 0) return;
+  ioctl(g_leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+  ReadAll(g_end);
+  g_region_done = 1;
+}
+
+void PerfCountersAccumulate(BenchCounters *acc, uint64_t accesses) {
+  if (g_leader < 0 || !g_region_done) return;
+  g_region_done = 0;
+  unsigned available = 0;
+  uint64_t deltas[kNumCounters] = {0};
+  for (int i = 0; i < kNumCounters; i++) {
+    uint64_t enabled = g_end[i].time_enabled - g_begin[i].time_enabled;
+    uint64_t running = g_end[i].time_running - g_begin[i].time_running;
+    if (g_fds[i] < 0 || running == 0) continue;
+    double scale = (double)enabled / (double)running;
+    deltas[i] = (uint64_t)((g_end[i].value - g_begin[i].value) * scale);
+    available |= 1u << i;
+  }
+  // Only keep counters that were measured in every trial.
+  acc->available = acc->accesses ? (acc->available & available) : available;
+  acc->accesses += accesses;
+  for (int i = 0; i < kNumCounters; i++) acc->values[i] += deltas[i];
+}
+
+const char *CounterLabel(int id) { return kCounterSpecs[id].label; }
+
+const char *CounterKey(int id) { return kCounterSpecs[id].key; }
@@ -0,0 +1,24 @@
+#ifndef HARNESS_PERF_COUNTERS_H_
+#define HARNESS_PERF_COUNTERS_H_
+
+#include "bench.h"
+
+// In-process hardware counters (perf_event_open) covering only the region
+// between TimerStart() and TimerStop() of each benchmark.
+//
+// The counters are opened with `inherit`, so threads created after
+// PerfCountersOpen() are counted too; open them before spawning workers.
+// Counters the CPU, kernel or perf_event_paranoid setting refuse are
+// skipped. Returns how many counters could be opened (0 disables them).
+int PerfCountersOpen(void);
+void PerfCountersClose(void);
+
+// Adds the counts of the most recent region to `acc`, covering `accesses`
+// accesses. Counts are scaled if the kernel had to multiplex the group.
+void PerfCountersAccumulate(BenchCounters *acc, uint64_t accesses);
+
+// Short label ("LLC miss") and JSON key ("llc_misses") for counter `id`.
+const char *CounterLabel(int id);
+const char *CounterKey(int id);
+
+#endif
@@ -0,0 +1,171 @@
+#define _GNU_SOURCE
+#include "harness/pool.h"
+
+#include "bench.h"
+#include "harness/numa.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+
+#define MAX_POOL_WORKERS 1024
+
+typedef struct {
+  pthread_t thread;
+  size_t index;
+  uint64_t start_ns;
+  uint64_t end_ns;
+} Worker;
+
+static Worker g_workers[MAX_POOL_WORKERS];
+static size_t g_spawned;
+
+// Dispatch state, protected by g_lock. A new generation wakes the workers.
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_wake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t g_done = PTHREAD_COND_INITIALIZER;
+static uint64_t g_generation;
+static int g_shutdown;
+static size_t g_active;
+static size_t g_finished;
+static PoolTask g_task;
+static char *g_args;
+static size_t g_arg_size;
+
+// Start barrier: workers check in, then spin until the release flag flips.
+// If any worker could not be pinned, none of them runs the task.
+static atomic_size_t g_ready;
+static atomic_int g_go;
+static atomic_int g_pin_failed;
+
+// Spins, yielding now and then so oversubscribed runs still make progress.
+static void SpinUntilGo(void) {
+  for (unsigned spins = 1; !atomic_load_explicit(&g_go, memory_order_acquire);
+       spins++) {
+    if (spins % 64 == 0) sched_yield();
+  }
+}
+
+static void *WorkerMain(void *arg) {
+  Worker *w = arg;
+  uint64_t seen = 0;
+  for (;;) {
+    pthread_mutex_lock(&g_lock);
+    while (g_generation == seen && !g_shutdown) {
+      pthread_cond_wait(&g_wake, &g_lock);
+    }
+    if (g_shutdown) {
+      pthread_mutex_unlock(&g_lock);
+      return NULL;
+    }
+    seen = g_generation;
+    int active = w->index < g_active;
+    PoolTask task = g_task;
+    void *task_arg = g_args + w->index * g_arg_size;
+    pthread_mutex_unlock(&g_lock);
+    if (!active) continue;
+
+    // The CPU list may change between runs (see the numa matrix).
+    if (!PinWorker(w->index)) atomic_store(&g_pin_failed, 1);
+    atomic_fetch_add_explicit(&g_ready, 1, memory_order_acq_rel);
+    SpinUntilGo();
+
+    w->start_ns = NowNs();
+    if (!atomic_load(&g_pin_failed)) task(task_arg);
+    w->end_ns = NowNs();
+
+    pthread_mutex_lock(&g_lock);
+    if (++g_finished == g_active) pthread_cond_signal(&g_done);
+    pthread_mutex_unlock(&g_lock);
+  }
+}
+
+int PoolReserve(size_t count) {
+  if (count == 0 || count > MAX_POOL_WORKERS) {
+    fprintf(stderr, "Thread pool supports 1..%d workers, not %zu\n",
+            MAX_POOL_WORKERS, count);
+    return 0;
+  }
+  pthread_mutex_lock(&g_lock);
+  while (g_spawned < count) {
+    Worker *w = &g_workers[g_spawned];
+    w->index = g_spawned;
+    if (pthread_create(&w->thread, NULL, WorkerMain, w) != 0) {
+      pthread_mutex_unlock(&g_lock);
+      fprintf(stderr, "Failed to spawn worker %zu\n", g_spawned);
+      return 0;
+    }
+    g_spawned++;
+  }
+  pthread_mutex_unlock(&g_lock);
+  return 1;
+}
+
+int PoolRun(size_t count, PoolTask task, void *args, size_t arg_size,
+            PoolTiming *timing) {
+  if (!PoolReserve(count)) return 0;
+
+  pthread_mutex_lock(&g_lock);
+  g_task = task;
+  g_args = args;
+  g_arg_size = arg_size;
+  g_active = count;
+  g_finished = 0;
+  atomic_store(&g_ready, 0);
+  atomic_store(&g_go, 0);
+  atomic_store(&g_pin_failed, 0);
+  g_generation++;
+  pthread_cond_broadcast(&g_wake);
+  pthread_mutex_unlock(&g_lock);
+
+  for (unsigned spins = 1; atomic_load(&g_ready) < count; spins++) {
+    if (spins % 64 == 0) sched_yield();
+  }
+  atomic_store_explicit(&g_go, 1, memory_order_release);
+
+  pthread_mutex_lock(&g_lock);
+  while (g_finished < count) pthread_cond_wait(&g_done, &g_lock);
+  pthread_mutex_unlock(&g_lock);
+  if (atomic_load(&g_pin_failed)) return 0;
+
+  if (timing) {
+    uint64_t first_start = g_workers[0].start_ns;
+    uint64_t last_start = first_start;
+    uint64_t first_end = g_workers[0].end_ns;
+    uint64_t last_end = first_end;
+    for (size_t w = 1; w < count; w++) {
+      const Worker *wk = &g_workers[w];
+      if (wk->start_ns < first_start) first_start = wk->start_ns;
+      if (wk->start_ns > last_start) last_start = wk->start_ns;
+      if (wk->end_ns < first_end) first_end = wk->end_ns;
+      if (wk->end_ns > last_end) last_end = wk->end_ns;
+    }
+    timing->span_ns = last_end - first_start;
+    timing->overlap_ns = first_end > last_start ? first_end - last_start : 0;
+    timing->skew_ns = last_start - first_start;
+  }
+  return 1;
+}
+
+void PoolWorkerWindow(size_t worker, uint64_t *start_ns, uint64_t *end_ns) {
+  *start_ns = g_workers[worker].start_ns;
+  *end_ns = g_workers[worker].end_ns;
+}
+
+double PoolOverlap(const PoolTiming *timing) {
+  if (timing->span_ns == 0) return 1.0;
+  return (double)timing->overlap_ns / (double)timing->span_ns;
+}
+
+void PoolShutdown(void) {
+  pthread_mutex_lock(&g_lock);
+  g_shutdown = 1;
+  pthread_cond_broadcast(&g_wake);
+  pthread_mutex_unlock(&g_lock);
+  for (size_t w = 0; w < g_spawned; w++) {
+    pthread_join(g_workers[w].thread, NULL);
+  }
+  g_spawned = 0;
+  g_shutdown = 0;
+}
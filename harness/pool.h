@@ -0,0 +1,45 @@
+#ifndef HARNESS_POOL_H_
+#define HARNESS_POOL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Persistent worker pool for the multi-threaded benchmarks. Workers are
+// spawned once and kept; worker i is pinned to the i-th CPU of the --cpus
+// list, or of the launch affinity, round-robin. They are released together
+// from a spin barrier, so joining and wake-up latency stay outside the
+// measurement. Timed benchmarks call PoolReserve() before starting their
+// timer, so thread creation never lands in a measured region.
+
+// Work for one worker; `arg` points at that worker's slot in the args array.
+typedef void (*PoolTask)(void *arg);
+
+typedef struct {
+  uint64_t span_ns;     // First worker start to last worker end
+  uint64_t overlap_ns;  // Last worker start to first worker end (0 if none)
+  uint64_t skew_ns;     // Last worker start minus first worker start
+} PoolTiming;
+
+// Spawns workers until at least `count` exist. Returns 0 if they could not
+// be spawned.
+int PoolReserve(size_t count);
+
+// Runs task(args + w * arg_size) on workers 0..count-1 and waits for all of
+// them, reserving them first if needed. Each worker timestamps its own
+// task; `timing` (optional) receives the combined window. Returns 0 if the
+// workers could not be spawned or pinned; the task then runs on none of
+// them.
+int PoolRun(size_t count, PoolTask task, void *args, size_t arg_size,
+            PoolTiming *timing);
+
+// Worker `worker`'s own task window in the last PoolRun, as CLOCK_MONOTONIC
+// nanoseconds.
+void PoolWorkerWindow(size_t worker, uint64_t *start_ns, uint64_t *end_ns);
+
+// Fraction of the span during which every worker was running.
+double PoolOverlap(const PoolTiming *timing);
+
+// Joins all workers. Safe to call when the pool was never used.
+void PoolShutdown(void);
+
+#endif
@@ -0,0 +1,279 @@
+#include "harness/prefetch_tuner.h"
+
+#include "bench.h"
+#include "harness/report.h"
+#include "harness/units.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Slots of BenchPrefetchTune's parameters.
+enum { kArgPattern, kArgOp, kArgDist, kArgHint, kArgIntent, kArgLines,
+       kArgStride };
+enum { kPatternRandom, kPatternChase, kPatternStrided };
+
+static const char *const kPatternNames[] = {"random", "chase", "strided",
+                                            NULL};
+static const char *const kOpNames[] = {"load", "update", NULL};
+static const char *const kHintNames[] = {"nta", "t2", "t1", "t0"};
+static const char *const kIntentNames[] = {"read", "write"};
+
+static const ParamBenchEntry kTunerEntry = {
+    "pftune", "Software prefetch tuner", NULL, kStateScratch,
+    {{"pattern", "access pattern", kPatternRandom, kPatternRandom,
+      kPatternStrided, kPatternNames},
+     {"op", "what each access does", 0, 0, 1, kOpNames},
+     {"size", "working set bytes", 32 << 10, 4096, (int64_t)1 << 40, NULL},
+     {"stride", "bytes between strided accesses", 4096, 8, (int64_t)1 << 30,
+      NULL}}};
+
+#define SMALLEST_SET ((size_t)32 << 10)
+// Chase nodes carry this many jump pointers (see bench_prefetch.c).
+#define CHASE_MAX_BATCH 6
+
+static const int64_t kDistances[] = {1,  2,  3,   4,   6,   8,   12,
+                                     16, 24, 32,  48,  64,  96,  128,
+                                     192, 256, 384, 512, 768, 1024};
+static const int64_t kBatches[] = {1, 2, 4, 6, 8};
+
+typedef struct {
+  int64_t args[MAX_BENCH_PARAMS];  // BenchPrefetchTune parameters
+  BenchResult result;
+  double ns;  // Median time per access
+} Setting;
+
+typedef struct {
+  uint64_t *array;
+  size_t n;  // Working set in elements
+  const TrialConfig *trials;
+  Setting best;
+  int ok;
+  size_t printed;  // Values on the current stage line
+} Search;
+
+typedef struct {
+  int64_t point[MAX_BENCH_PARAMS];  // Grid values
+  size_t bytes;
+  Setting none;
+  Setting best;
+} Tuned;
+
+int PrefetchTunerGridInit(ParamGrid *grid, size_t max_bytes) {
+  if (!ParamGridInit(grid, &kTunerEntry)) return 0;
+  int64_t *patterns = malloc(3 * sizeof(int64_t));
+  size_t count = 1;
+  for (size_t b = SMALLEST_SET; b * 4 <= max_bytes; b *= 4) count++;
+  int64_t *sizes = malloc(count * sizeof(int64_t));
+  if (!patterns || !sizes) {
+    free(patterns);
+    free(sizes);
+    return 0;
+  }
+  for (int p = 0; p < 3; p++) patterns[p] = p;
+  free(grid->values[0]);
+  grid->values[0] = patterns;
+  grid->num_values[0] = 3;
+
+  size_t b = SMALLEST_SET;
+  for (size_t i = 0; i < count; i++, b *= 4) sizes[i] = b;
+  if (sizes[0] > (int64_t)max_bytes) sizes[0] = max_bytes;
+  free(grid->values[2]);
+  grid->values[2] = sizes;
+  grid->num_values[2] = count;
+  return 1;
+}
+
+// Accesses one pass of the pattern makes over n elements.
+static size_t PassAccesses(const int64_t *args, size_t n) {
+  switch (args[kArgPattern]) {
+    case kPatternChase: return n / 8;
+    case kPatternStrided: {
+      size_t stride = (size_t)args[kArgStride] / sizeof(uint64_t);
+      return n / (stride ? stride : 1);
+    }
+    default: return n;
+  }
+}
+
+static void Measure(Search *s, Setting *setting) {
+  BenchCall call = {.param_func = BenchPrefetchTune, .input = kStateScratch};
+  for (size_t p = 0; p < MAX_BENCH_PARAMS; p++) {
+    call.params[p] = setting->args[p];
+  }
+  SetBenchLogQuiet(1);
+  setting->result = RunTrials(&call, s->array, s->n, s->trials);
+  SetBenchLogQuiet(0);
+  setting->ns = setting->result.ns_per_access;
+  if (setting->result.iterations == 0) s->ok = 0;
+}
+
+static void BeginStage(Search *s, const char *stage) {
+  BenchLog("  %-7s", stage);
+  s->printed = 0;
+}
+
+// Measures the best setting with one knob changed; keeps it if faster.
+static void Try(Search *s, int slot, int64_t value, const char *label) {
+  if (!s->ok) return;
+  Setting candidate = s->best;
+  candidate.args[slot] = value;
+  Measure(s, &candidate);
+  if (s->printed && s->printed % 6 == 0) BenchLog("\n  %-7s", "");
+  BenchLog(" %6s %7.2f", label, candidate.ns);
+  s->printed++;
+  if (s->ok && candidate.ns < s->best.ns) s->best = candidate;
+}
+
+static void TryNumber(Search *s, int slot, int64_t value) {
+  char label[24];
+  snprintf(label, sizeof(label), "%lld", (long long)value);
+  Try(s, slot, value, label);
+}
+
+// Coordinate search from (dist 0, t0, read, batch 1).
+static int Tune(Search *s, const int64_t *point, Tuned *out) {
+  Setting *best = &s->best;
+  for (size_t p = 0; p < MAX_BENCH_PARAMS; p++) best->args[p] = 0;
+  best->args[kArgPattern] = point[0];
+  best->args[kArgOp] = point[1];
+  best->args[kArgHint] = 3;
+  best->args[kArgLines] = 1;
+  best->args[kArgStride] = point[3];
+  size_t accesses = PassAccesses(best->args, s->n);
+
+  Measure(s, best);
+  out->none = *best;
+  BenchLog("  %-7s %7.2f ns\n", "none:", best->ns);
+
+  // Starting from "no prefetch", the first distance always wins the slot.
+  BeginStage(s, "dist:");
+  best->ns = 1e300;
+  for (size_t i = 0; i < sizeof(kDistances) / sizeof(kDistances[0]); i++) {
+    if ((size_t)kDistances[i] * 2 > accesses) break;
+    TryNumber(s, kArgDist, kDistances[i]);
+  }
+  BenchLog("\n");
+  if (best->ns == 1e300) *best = out->none;
+
+  if (best->args[kArgDist] > 0) {
+    BeginStage(s, "hint:");
+    for (int h = 0; h < 4; h++) {
+      if (h != best->args[kArgHint]) Try(s, kArgHint, h, kHintNames[h]);
+    }
+    BenchLog("\n");
+
+    BeginStage(s, "intent:");
+    Try(s, kArgIntent, 1, kIntentNames[1]);
+    BenchLog("\n");
+
+    BeginStage(s, "batch:");
+    int64_t max_batch =
+        point[0] == kPatternChase ? CHASE_MAX_BATCH : (int64_t)1 << 30;
+    for (size_t i = 1; i < sizeof(kBatches) / sizeof(kBatches[0]); i++) {
+      if (kBatches[i] <= max_batch) TryNumber(s, kArgLines, kBatches[i]);
+    }
+    BenchLog("\n");
+
+    // Distances between the coarse steps around the winner.
+    BeginStage(s, "refine:");
+    int64_t d = best->args[kArgDist];
+    int64_t around[] = {d * 3 / 4, d * 7 / 8, d * 9 / 8, d * 5 / 4};
+    for (size_t i = 0; i < 4; i++) {
+      if (around[i] > 0 && around[i] != d &&
+          (size_t)around[i] * 2 <= accesses) {
+        TryNumber(s, kArgDist, around[i]);
+      }
+    }
+    BenchLog("\n");
+  }
+  out->best = *best;
+  return s->ok;
+}
+
+static void FormatCall(const Setting *best, char *buf, size_t size) {
+  if (best->args[kArgDist] == 0) {
+    snprintf(buf, size, "(no prefetch)");
+  } else {
+    snprintf(buf, size, "__builtin_prefetch(p, %lld, %lld)",
+             (long long)best->args[kArgIntent],
+             (long long)best->args[kArgHint]);
+  }
+}
+
+static void ReportSetting(const Tuned *t, const Setting *setting) {
+  char params[192];
+  snprintf(params, sizeof(params),
+           "pattern=%s,op=%s,size=%zu,stride=%lld,dist=%lld,hint=%s,"
+           "intent=%s,lines=%lld",
+           kPatternNames[t->point[0]], kOpNames[t->point[1]], t->bytes,
+           (long long)t->point[3], (long long)setting->args[kArgDist],
+           kHintNames[setting->args[kArgHint]],
+           kIntentNames[setting->args[kArgIntent]],
+           (long long)setting->args[kArgLines]);
+  ReportResult("pftune", params, t->bytes, &setting->result);
+}
+
+static void PrintSummary(const Tuned *tuned, size_t count) {
+  BenchLog("\n=== Prefetch tuning summary (ns per access) ===\n");
+  BenchLog("  %-8s %-6s %11s %8s %8s %8s %6s %5s  %s\n", "pattern", "op",
+           "working set", "none", "best", "speedup", "dist", "batch",
+           "call");
+  for (size_t i = 0; i < count; i++) {
+    const Tuned *t = &tuned[i];
+    char size[32], call[64];
+    FormatBytes(t->bytes, size, sizeof(size));
+    FormatCall(&t->best, call, sizeof(call));
+    double speedup = t->none.ns / t->best.ns;
+    BenchLog("  %-8s %-6s %11s %8.2f %8.2f %7.2fx %6lld %5lld  %s%s\n",
+             kPatternNames[t->point[0]], kOpNames[t->point[1]], size,
+             t->none.ns, t->best.ns, speedup,
+             (long long)t->best.args[kArgDist],
+             (long long)t->best.args[kArgLines], call,
+             speedup < 1.02 ? "  (not worth it)" : "");
+  }
+}
+
+int RunPrefetchTuner(const ParamGrid *grid, uint64_t *array, size_t n,
+                     const TrialConfig *trials) {
+  size_t points = ParamGridSize(grid);
+  Tuned *tuned = calloc(points, sizeof(Tuned));
+  if (!tuned) {
+    fprintf(stderr, "Failed to allocate %zu tuning points\n", points);
+    return 0;
+  }
+  int text = ReportFormat() == kFormatText;
+  int ok = 1;
+  size_t done = 0;
+  for (size_t i = 0; i < points && ok; i++) {
+    Tuned *t = &tuned[done];
+    ParamGridPoint(grid, i, t->point);
+    t->bytes = (size_t)t->point[2];
+    if (t->bytes > n * sizeof(uint64_t)) {
+      fprintf(stderr, "Working set %zu does not fit the array; pass a "
+                      "larger array size\n", t->bytes);
+      ok = 0;
+      break;
+    }
+    char size[32];
+    BenchLog("\n=== Prefetch tuning: %s %s, %s", kPatternNames[t->point[0]],
+             kOpNames[t->point[1]],
+             FormatBytes(t->bytes, size, sizeof(size)));
+    if (t->point[0] == kPatternStrided) {
+      BenchLog(", stride %lld", (long long)t->point[3]);
+    }
+    BenchLog(" ===\n");
+
+    Search search = {.array = array, .n = t->bytes / sizeof(uint64_t),
+                     .trials = trials, .ok = 1};
+    ok = Tune(&search, t->point, t);
+    if (!ok) break;
+    if (!text) {
+      ReportSetting(t, &t->none);
+      ReportSetting(t, &t->best);
+    }
+    done++;
+  }
+  if (done) PrintSummary(tuned, done);
+  free(tuned);
+  return ok;
+}
@@ -0,0 +1,27 @@
+#ifndef HARNESS_PREFETCH_TUNER_H_
+#define HARNESS_PREFETCH_TUNER_H_
+
+#include "harness/params.h"
+#include "harness/runner.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Software prefetch tuner. For every access pattern and working set it
+// searches the pf_tune knobs one at a time: distance over a dense
+// geometric series, then the locality hint, read vs write intent, the
+// prefetch batch size, and finally distances around the best one. It
+// prints the winning settings per working set next to the no-prefetch
+// time, as values that can be pasted into __builtin_prefetch calls.
+
+// Grid of pattern (random, chase, strided) x op (load, update) x working
+// set x stride. Defaults: all three patterns, loads, working sets from
+// 32 KiB growing 4x up to `max_bytes`, and a 4 KiB stride.
+int PrefetchTunerGridInit(ParamGrid *grid, size_t max_bytes);
+
+// Tunes every grid point on the start of `array` (n elements). Returns 0
+// if a working set does not fit or a measurement failed.
+int RunPrefetchTuner(const ParamGrid *grid, uint64_t *array, size_t n,
+                     const TrialConfig *trials);
+
+#endif
@@ -0,0 +1,421 @@
+#include "harness/report.h"
+
+#include "harness/perf_counters.h"
+#include "harness/rng.h"
+#include "harness/units.h"
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+static OutputFormat g_format = kFormatText;
+static FILE *g_log = NULL;
+static int g_log_muted = 0;
+static int g_log_quiet = 0;
+static HostInfo g_host;
+static RunInfo g_run;
+static ReportedResult *g_results = NULL;
+static size_t g_num_results = 0;
+static size_t g_cap_results = 0;
+
+void BenchLog(const char *fmt, ...) {
+  if (g_log_muted || g_log_quiet) return;
+  va_list ap;
+  va_start(ap, fmt);
+  vfprintf(g_log ? g_log : stdout, fmt, ap);
+  va_end(ap);
+}
+
+void SetBenchLogMuted(int muted) { g_log_muted = muted; }
+
+void SetBenchLogQuiet(int quiet) { g_log_quiet = quiet; }
+
+int ParseOutputFormat(const char *name, OutputFormat *out) {
+  if (strcmp(name, "text") == 0) {
+    *out = kFormatText;
+  } else if (strcmp(name, "json") == 0) {
+    *out = kFormatJson;
+  } else if (strcmp(name, "csv") == 0) {
+    *out = kFormatCsv;
+  } else {
+    return 0;
+  }
+  return 1;
+}
+
+static void ReadFirstLine(const char *path, char *buf, size_t size) {
+  FILE *f = fopen(path, "r");
+  if (!f || !fgets(buf, size, f)) {
+    snprintf(buf, size, "unknown");
+  }
+  if (f) fclose(f);
+  buf[strcspn(buf, "\n")] = '\0';
+}
+
+static void ReadCpuModel(char *buf, size_t size) {
+  snprintf(buf, size, "unknown");
+  FILE *f = fopen("/proc/cpuinfo", "r");
+  if (!f) return;
+  char line[256];
+  while (fgets(line, sizeof(line), f)) {
+    if (strncmp(line, "model name", 10) == 0) {
+      char *colon = strchr(line, ':');
+      if (colon) {
+        colon += strspn(colon + 1, " \t") + 1;
+        size_t len = strcspn(colon, "\n");
+        if (len >= size) len = size - 1;
+        memcpy(buf, colon, len);
+        buf[len] = '\0';
+      }
+      break;
+    }
+  }
+  fclose(f);
+}
+
+void GetHostInfo(HostInfo *info) {
+  memset(info, 0, sizeof(*info));
+  struct utsname uts;
+  if (uname(&uts) == 0) {
+    snprintf(info->hostname, sizeof(info->hostname), "%s", uts.nodename);
+    snprintf(info->kernel, sizeof(info->kernel), "%s", uts.release);
+  } else {
+    snprintf(info->hostname, sizeof(info->hostname), "unknown");
+    snprintf(info->kernel, sizeof(info->kernel), "unknown");
+  }
+  ReadCpuModel(info->cpu_model, sizeof(info->cpu_model));
+  ReadFirstLine("/sys/devices/system/cpu/cpu0/cpufreq/scaling_governor",
+                info->governor, sizeof(info->governor));
+  info->online_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+}
+
+static void PrintJsonString(const char *s) {
+  putchar('"');
+  for (; *s; s++) {
+    unsigned char c = (unsigned char)*s;
+    if (c == '"' || c == '\\') {
+      printf("\\%c", c);
+    } else if (c < 0x20) {
+      printf("\\u%04x", c);
+    } else {
+      putchar(c);
+    }
+  }
+  putchar('"');
+}
+
+static void PrintCsvString(const char *s) {
+  putchar('"');
+  for (; *s; s++) {
+    if (*s == '"') putchar('"');
+    putchar(*s);
+  }
+  putchar('"');
+}
+
+// `sep"key": value`; JSON has no NaN or infinity, so those become null.
+static void PrintJsonNumber(const char *sep, const char *key, double value,
+                            int digits) {
+  printf("%s\"%s\": ", sep, key);
+  if (isfinite(value)) {
+    printf("%.*f", digits, value);
+  } else {
+    printf("null");
+  }
+}
+
+// A CSV field; non-finite values are left empty, like unmeasured counters.
+static void PrintCsvNumber(double value, int digits) {
+  putchar(',');
+  if (isfinite(value)) printf("%.*f", digits, value);
+}
+
+static int HasCounter(const BenchCounters *c, int id) {
+  return c->accesses > 0 && (c->available & (1u << id));
+}
+
+static double PerAccess(const BenchCounters *c, int id) {
+  return (double)c->values[id] / (double)c->accesses;
+}
+
+static int HasIpc(const BenchCounters *c) {
+  return HasCounter(c, kCounterCycles) && HasCounter(c, kCounterInstructions) &&
+         c->values[kCounterCycles] > 0;
+}
+
+static double Ipc(const BenchCounters *c) {
+  return (double)c->values[kCounterInstructions] /
+         (double)c->values[kCounterCycles];
+}
+
+static void PrintTextCounters(const BenchCounters *c) {
+  if (!c->accesses || !c->available) return;
+  if (HasIpc(c)) printf("IPC:            %.2f\n", Ipc(c));
+  printf("Per access:    ");
+  const char *sep = " ";
+  for (int i = 0; i < kNumCounters; i++) {
+    if (!HasCounter(c, i)) continue;
+    printf("%s%.3f %s", sep, PerAccess(c, i), CounterLabel(i));
+    sep = ", ";
+  }
+  printf("\n");
+}
+
+static void PrintText(const char *params, const BenchResult *result) {
+  const BenchStats *s = &result->stats;
+  if (params[0]) {
+    printf("\n=== %s (%s) ===\n", result->name, params);
+  } else {
+    printf("\n=== %s ===\n", result->name);
+  }
+  printf("Iterations:     %zu\n", result->iterations);
+  printf("Total time:     %.2f ms\n", result->total_ns / 1e6);
+  printf("Time per access: %.2f ns\n", result->ns_per_access);
+  printf("Setup time:     %.2f ms (untimed, per trial)\n",
+         result->setup_ns / 1e6);
+  if (result->gbps > 0) {
+    printf("Bandwidth:      %.2f GB/s\n", result->gbps);
+  }
+  if (s->trials > 1) {
+    double half = (s->ci_high - s->ci_low) / 2.0;
+    printf("Trials:         %zu (+%zu warmup)\n", s->trials, s->warmup);
+    printf("Min / median:   %.2f / %.2f ns\n", s->min, s->median);
+    printf("Mean +/- sd:    %.2f +/- %.2f ns\n", s->mean, s->stddev);
+    printf("p90 / p99:      %.2f / %.2f ns\n", s->p90, s->p99);
+    printf("95%% CI:         [%.2f, %.2f] ns (+/-%.1f%%)\n", s->ci_low,
+           s->ci_high, s->mean > 0 ? 100.0 * half / s->mean : 0.0);
+  }
+  PrintTextCounters(&result->counters);
+  printf("\n");
+}
+
+// "a=1,b=2" -> {"a": 1, "b": 2}
+static void PrintJsonParams(const char *params) {
+  printf("{");
+  const char *p = params;
+  while (*p) {
+    size_t key_len = strcspn(p, "=");
+    if (!p[key_len]) break;
+    printf("%s\"%.*s\": ", p == params ? "" : ", ", (int)key_len, p);
+    p += key_len + 1;
+    size_t value_len = strcspn(p, ",");
+    // Named values (kernel=triad) become strings, numbers stay numbers.
+    char *end;
+    strtoll(p, &end, 10);
+    int numeric = value_len > 0 && end == p + value_len;
+    printf(numeric ? "%.*s" : "\"%.*s\"", (int)value_len, p);
+    p += value_len;
+    if (*p == ',') p++;
+  }
+  printf("}");
+}
+
+static void PrintJson(const char *id, const char *params, size_t array_bytes,
+                      const BenchResult *result) {
+  const BenchStats *s = &result->stats;
+  printf("%s\n    {\"id\": ", g_num_results > 1 ? "," : "");
+  PrintJsonString(id);
+  printf(", \"name\": ");
+  PrintJsonString(result->name ? result->name : id);
+  printf(", \"params\": ");
+  PrintJsonParams(params);
+  printf(", \"array_bytes\": %zu, \"iterations\": %zu", array_bytes,
+         result->iterations);
+  printf(", \"trials\": %zu, \"warmup\": %zu", s->trials, s->warmup);
+  PrintJsonNumber(", ", "ns_per_access", result->ns_per_access, 4);
+  PrintJsonNumber(", ", "min", s->min, 4);
+  PrintJsonNumber(", ", "max", s->max, 4);
+  PrintJsonNumber(", ", "median", s->median, 4);
+  PrintJsonNumber(", ", "mean", s->mean, 4);
+  PrintJsonNumber(", ", "p90", s->p90, 4);
+  PrintJsonNumber(", ", "p99", s->p99, 4);
+  PrintJsonNumber(", ", "stddev", s->stddev, 4);
+  PrintJsonNumber(", ", "ci_low", s->ci_low, 4);
+  PrintJsonNumber(", ", "ci_high", s->ci_high, 4);
+  printf(", \"setup_ns\": %" PRIu64, result->setup_ns);
+  PrintJsonNumber(", ", "gbps", result->gbps, 4);
+
+  // Counter values are per access, averaged over all timed trials.
+  const BenchCounters *c = &result->counters;
+  if (c->accesses && c->available) {
+    printf(", \"counters\": {");
+    const char *sep = "";
+    if (HasIpc(c)) {
+      PrintJsonNumber(sep, "ipc", Ipc(c), 4);
+      sep = ", ";
+    }
+    for (int i = 0; i < kNumCounters; i++) {
+      if (!HasCounter(c, i)) continue;
+      char key[64];
+      snprintf(key, sizeof(key), "%s_per_access", CounterKey(i));
+      PrintJsonNumber(sep, key, PerAccess(c, i), 6);
+      sep = ", ";
+    }
+    printf("}");
+  }
+  printf("}");
+}
+
+static void PrintCsv(const char *id, const char *params, size_t array_bytes,
+                     const BenchResult *result) {
+  const BenchStats *s = &result->stats;
+  PrintCsvString(id);
+  putchar(',');
+  PrintCsvString(result->name ? result->name : id);
+  putchar(',');
+  PrintCsvString(params);
+  printf(",%zu,%zu,%zu,%zu", array_bytes, result->iterations, s->trials,
+         s->warmup);
+  const double stats[] = {result->ns_per_access, s->min, s->max, s->median,
+                          s->mean, s->p90, s->p99, s->stddev, s->ci_low,
+                          s->ci_high};
+  for (size_t i = 0; i < sizeof(stats) / sizeof(stats[0]); i++) {
+    PrintCsvNumber(stats[i], 4);
+  }
+  printf(",%" PRIu64, result->setup_ns);
+  PrintCsvNumber(result->gbps, 4);
+  putchar(',');
+  PrintCsvString(g_host.hostname);
+  putchar(',');
+  PrintCsvString(g_host.cpu_model);
+  putchar(',');
+  PrintCsvString(g_host.kernel);
+  putchar(',');
+  PrintCsvString(g_host.governor);
+  putchar(',');
+  PrintCsvString(g_run.page_policy);
+  printf(",%.4f", HugePageFraction(&g_run.pages));
+
+  // Unmeasured counters are left empty.
+  const BenchCounters *c = &result->counters;
+  if (HasIpc(c)) {
+    PrintCsvNumber(Ipc(c), 4);
+  } else {
+    putchar(',');
+  }
+  for (int i = 0; i < kNumCounters; i++) {
+    if (HasCounter(c, i)) {
+      PrintCsvNumber(PerAccess(c, i), 6);
+    } else {
+      putchar(',');
+    }
+  }
+  putchar('\n');
+}
+
+void ReportBegin(OutputFormat format) {
+  g_format = format;
+  g_log = (format == kFormatText) ? stdout : stderr;
+  GetHostInfo(&g_host);
+}
+
+void ReportHeader(const RunInfo *info) {
+  g_run = *info;
+  const TrialConfig *cfg = info->trials;
+  char size_buf[32];
+  char page_buf[32];
+
+  if (g_format == kFormatText) {
+    // Modes that allocate their own arrays have no single backing to show.
+    if (info->pages.kernel_page_size == 0) return;
+    BenchLog("Pages: %s, %.0f%% of %s resident in huge pages "
+             "(kernel page size %s)\n",
+             info->page_policy, 100.0 * HugePageFraction(&info->pages),
+             FormatBytes(info->array_bytes, size_buf, sizeof(size_buf)),
+             FormatBytes(info->pages.kernel_page_size, page_buf,
+                         sizeof(page_buf)));
+  } else if (g_format == kFormatJson) {
+    printf("{\n  \"host\": {\"hostname\": ");
+    PrintJsonString(g_host.hostname);
+    printf(", \"cpu_model\": ");
+    PrintJsonString(g_host.cpu_model);
+    printf(", \"kernel\": ");
+    PrintJsonString(g_host.kernel);
+    printf(", \"governor\": ");
+    PrintJsonString(g_host.governor);
+    printf(", \"online_cpus\": %ld},\n", g_host.online_cpus);
+    printf("  \"config\": {\"array_bytes\": %zu, \"warmup\": %zu",
+           info->array_bytes, cfg->warmup);
+    printf(", \"min_trials\": %zu, \"max_trials\": %zu", cfg->min_trials,
+           cfg->max_trials);
+    printf(", \"ci_target\": %.4f, \"budget_sec\": %.1f", cfg->ci_target,
+           cfg->budget_sec);
+    printf(", \"pages\": ");
+    PrintJsonString(info->page_policy);
+    printf(", \"kernel_page_size\": %zu, \"thp_bytes\": %zu"
+           ", \"hugetlb_bytes\": %zu, \"huge_page_fraction\": %.4f",
+           info->pages.kernel_page_size, info->pages.thp_bytes,
+           info->pages.hugetlb_bytes, HugePageFraction(&info->pages));
+    printf(", \"init_ns\": %" PRIu64 ", \"seed\": %" PRIu64 "},\n",
+           info->init_ns, BenchSeed());
+    printf("  \"results\": [");
+  } else if (g_format == kFormatCsv) {
+    printf("id,name,params,array_bytes,iterations,trials,warmup,ns_per_access,min,"
+           "max,median,mean,p90,p99,stddev,ci_low,ci_high,setup_ns,gbps,hostname,"
+           "cpu_model,"
+           "kernel,governor,pages,huge_page_fraction,ipc");
+    for (int i = 0; i < kNumCounters; i++) {
+      printf(",%s_per_access", CounterKey(i));
+    }
+    printf("\n");
+  }
+  fflush(stdout);
+}
+
+static void Record(const char *id, const char *params, size_t array_bytes,
+                   const BenchResult *result) {
+  if (g_num_results == g_cap_results) {
+    size_t cap = g_cap_results ? g_cap_results * 2 : 64;
+    ReportedResult *grown = realloc(g_results, cap * sizeof(ReportedResult));
+    if (grown) {
+      g_results = grown;
+      g_cap_results = cap;
+    }
+  }
+  if (g_num_results < g_cap_results) {
+    ReportedResult *r = &g_results[g_num_results++];
+    snprintf(r->id, sizeof(r->id), "%s", id);
+    snprintf(r->params, sizeof(r->params), "%s", params);
+    r->array_bytes = array_bytes;
+    r->result = *result;
+  }
+}
+
+void ReportResult(const char *id, const char *params, size_t array_bytes,
+                  const BenchResult *result) {
+  Record(id, params, array_bytes, result);
+  switch (g_format) {
+    case kFormatText: PrintText(params, result); break;
+    case kFormatJson: PrintJson(id, params, array_bytes, result); break;
+    case kFormatCsv: PrintCsv(id, params, array_bytes, result); break;
+  }
+  fflush(stdout);
+}
+
+void ReportPoint(const char *id, const char *params, size_t array_bytes,
+                 const BenchResult *result) {
+  if (g_format == kFormatText) {
+    Record(id, params, array_bytes, result);
+  } else {
+    ReportResult(id, params, array_bytes, result);
+  }
+}
+
+void ReportEnd(void) {
+  if (g_format == kFormatJson) {
+    printf("\n  ]\n}\n");
+  }
+  fflush(stdout);
+}
+
+OutputFormat ReportFormat(void) { return g_format; }
+
+const ReportedResult *ReportedResults(size_t *count) {
+  *count = g_num_results;
+  return g_results;
+}
@@ -0,0 +1,71 @@
+#ifndef HARNESS_REPORT_H_
+#define HARNESS_REPORT_H_
+
+#include "bench.h"
+#include "harness/alloc.h"
+#include "harness/runner.h"
+
+#include <stddef.h>
+
+typedef enum {
+  kFormatText,
+  kFormatJson,
+  kFormatCsv,
+} OutputFormat;
+
+typedef struct {
+  char hostname[128];
+  char cpu_model[128];
+  char kernel[128];
+  char governor[32];
+  long online_cpus;
+} HostInfo;
+
+// Run-wide settings written once into the report header.
+typedef struct {
+  size_t array_bytes;
+  const TrialConfig *trials;
+  const char *page_policy;  // PagePolicyName() of the array
+  PageBacking pages;        // What backs the array after initialization
+  uint64_t init_ns;         // Allocating and first-touching the array
+} RunInfo;
+
+// One finished benchmark as handed to ReportResult().
+typedef struct {
+  char id[64];       // CLI name, e.g. "chase"
+  char params[128];  // "stride=4096,threads=2"; empty for fixed benchmarks
+  size_t array_bytes;
+  BenchResult result;
+} ReportedResult;
+
+// Accepts "text", "json" or "csv". Returns 0 on an unknown name.
+int ParseOutputFormat(const char *name, OutputFormat *out);
+
+void GetHostInfo(HostInfo *info);
+
+// Silences BenchLog() so repeated trials print their chatter only once.
+void SetBenchLogMuted(int muted);
+// Silences BenchLog() until cleared, independently of the per-trial muting
+// above; for drivers that summarize many RunTrials() calls themselves.
+void SetBenchLogQuiet(int quiet);
+
+// Machine-readable formats own stdout; BenchLog() output and harness
+// progress messages are moved to stderr so the report stays parseable.
+void ReportBegin(OutputFormat format);
+// Writes the JSON/CSV header (or a page summary line for text). Must be
+// called once before the first ReportResult().
+void ReportHeader(const RunInfo *info);
+void ReportResult(const char *id, const char *params, size_t array_bytes,
+                  const BenchResult *result);
+// Like ReportResult(), for drivers that print their own text table: the
+// result is recorded (and written as JSON/CSV) but not printed as text.
+void ReportPoint(const char *id, const char *params, size_t array_bytes,
+                 const BenchResult *result);
+void ReportEnd(void);
+
+OutputFormat ReportFormat(void);
+
+// Everything reported so far, in order.
+const ReportedResult *ReportedResults(size_t *count);
+
+#endif
@@ -0,0 +1,168 @@
+#include "harness/rng.h"
+
+#include "harness/parallel.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Scatter blocks and target bucket sizes for RandomPermutation. The layout
+// depends only on n, which keeps the permutation independent of the thread
+// count; the caps bound the blocks x buckets count table to 8 MiB.
+#define MIN_BLOCK_ELEMENTS ((size_t)1 << 16)
+#define MAX_BLOCKS 256
+#define BUCKET_ELEMENTS ((size_t)1 << 18)
+#define MAX_BUCKETS 4096
+
+// Keeps bucket-shuffle streams apart from the scatter streams.
+#define SHUFFLE_STREAM_BASE (1ULL << 63)
+
+static uint64_t g_seed = 42;
+
+void SetBenchSeed(uint64_t seed) { g_seed = seed; }
+
+uint64_t BenchSeed(void) { return g_seed; }
+
+static uint64_t SplitMix64(uint64_t *state) {
+  uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+void RngSeed(Rng *rng, uint64_t seed, uint64_t stream) {
+  uint64_t state = seed;
+  uint64_t mixed = SplitMix64(&state) ^ (stream * 0xd1342543de82ef95ULL);
+  state = mixed;
+  for (int i = 0; i < 4; i++) {
+    rng->s[i] = SplitMix64(&state);
+  }
+}
+
+typedef struct {
+  size_t *out;
+  size_t n;
+  uint64_t seed;
+  size_t block_size;
+  size_t num_blocks;
+  size_t num_buckets;
+  size_t *counts;        // [block][bucket] sizes, then write cursors
+  size_t *bucket_start;  // num_buckets + 1 offsets into out
+} PermCtx;
+
+static void CountBuckets(size_t begin, size_t end, void *arg) {
+  PermCtx *c = arg;
+  for (size_t block = begin; block < end; block++) {
+    size_t *counts = c->counts + block * c->num_buckets;
+    size_t lo = block * c->block_size;
+    size_t hi = lo + c->block_size < c->n ? lo + c->block_size : c->n;
+    Rng rng;
+    RngSeed(&rng, c->seed, block);
+    for (size_t i = lo; i < hi; i++) {
+      counts[RngBounded(&rng, c->num_buckets)]++;
+    }
+  }
+}
+
+// Replays the block's stream, so every element goes where it was counted.
+static void ScatterBlocks(size_t begin, size_t end, void *arg) {
+  PermCtx *c = arg;
+  for (size_t block = begin; block < end; block++) {
+    size_t *cursor = c->counts + block * c->num_buckets;
+    size_t lo = block * c->block_size;
+    size_t hi = lo + c->block_size < c->n ? lo + c->block_size : c->n;
+    Rng rng;
+    RngSeed(&rng, c->seed, block);
+    for (size_t i = lo; i < hi; i++) {
+      c->out[cursor[RngBounded(&rng, c->num_buckets)]++] = i;
+    }
+  }
+}
+
+static void ShuffleBuckets(size_t begin, size_t end, void *arg) {
+  PermCtx *c = arg;
+  for (size_t b = begin; b < end; b++) {
+    size_t *bucket = c->out + c->bucket_start[b];
+    size_t len = c->bucket_start[b + 1] - c->bucket_start[b];
+    Rng rng;
+    RngSeed(&rng, c->seed, SHUFFLE_STREAM_BASE + b);
+    for (size_t i = len; i > 1; i--) {
+      size_t j = RngBounded(&rng, i);
+      size_t tmp = bucket[i - 1];
+      bucket[i - 1] = bucket[j];
+      bucket[j] = tmp;
+    }
+  }
+}
+
+size_t *RandomPermutation(size_t n, uint64_t seed) {
+  size_t *out = malloc((n ? n : 1) * sizeof(size_t));
+  if (!out) {
+    fprintf(stderr, "Failed to allocate %zu-entry permutation\n", n);
+    return NULL;
+  }
+  if (!BuildPermutation(out, n, seed)) {
+    free(out);
+    return NULL;
+  }
+  return out;
+}
+
+int BuildPermutation(size_t *out, size_t n, uint64_t seed) {
+  PermCtx c = {.out = out, .n = n, .seed = seed};
+  c.block_size = (n + MAX_BLOCKS - 1) / MAX_BLOCKS;
+  if (c.block_size < MIN_BLOCK_ELEMENTS) c.block_size = MIN_BLOCK_ELEMENTS;
+  c.num_blocks = (n + c.block_size - 1) / c.block_size;
+  c.num_buckets = (n + BUCKET_ELEMENTS - 1) / BUCKET_ELEMENTS;
+  if (c.num_buckets > MAX_BUCKETS) c.num_buckets = MAX_BUCKETS;
+  if (c.num_buckets == 0) c.num_buckets = 1;
+
+  c.counts = calloc(c.num_blocks * c.num_buckets, sizeof(size_t));
+  c.bucket_start = malloc((c.num_buckets + 1) * sizeof(size_t));
+  if (!c.counts || !c.bucket_start) {
+    fprintf(stderr, "Failed to allocate permutation buckets\n");
+    free(c.counts);
+    free(c.bucket_start);
+    return 0;
+  }
+
+  ParallelForEach(c.num_blocks, CountBuckets, &c);
+
+  // Bucket-major prefix sum: counts become each block's write cursor.
+  size_t offset = 0;
+  for (size_t b = 0; b < c.num_buckets; b++) {
+    c.bucket_start[b] = offset;
+    for (size_t block = 0; block < c.num_blocks; block++) {
+      size_t *count = &c.counts[block * c.num_buckets + b];
+      size_t size = *count;
+      *count = offset;
+      offset += size;
+    }
+  }
+  c.bucket_start[c.num_buckets] = offset;
+
+  ParallelForEach(c.num_blocks, ScatterBlocks, &c);
+  ParallelForEach(c.num_buckets, ShuffleBuckets, &c);
+
+  free(c.counts);
+  free(c.bucket_start);
+  return 1;
+}
+
+typedef struct {
+  uint64_t *next;
+  const size_t *order;
+  size_t n;
+} LinkCtx;
+
+static void LinkRange(size_t begin, size_t end, void *arg) {
+  LinkCtx *c = arg;
+  for (size_t i = begin; i < end; i++) {
+    size_t to = i + 1 < c->n ? c->order[i + 1] : c->order[0];
+    c->next[c->order[i]] = to;
+  }
+}
+
+void LinkCycle(uint64_t *next, const size_t *order, size_t n) {
+  LinkCtx c = {.next = next, .order = order, .n = n};
+  ParallelFor(n, LinkRange, &c);
+}
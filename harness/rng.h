@@ -0,0 +1,66 @@
+#ifndef HARNESS_RNG_H_
+#define HARNESS_RNG_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// xoshiro256** (Blackman & Vigna): fast, 64-bit output, 2^256 - 1 period.
+// Every random input in the benchmarks comes from here so that one --seed
+// reproduces a whole run.
+typedef struct {
+  uint64_t s[4];
+} Rng;
+
+// Seed given by --seed (default 42).
+void SetBenchSeed(uint64_t seed);
+uint64_t BenchSeed(void);
+
+// Independent generator for (seed, stream); streams let parallel setup
+// code produce the same values no matter how work is split across threads.
+void RngSeed(Rng *rng, uint64_t seed, uint64_t stream);
+
+static inline uint64_t RngRotl(uint64_t x, int k) {
+  return (x << k) | (x >> (64 - k));
+}
+
+static inline uint64_t RngNext(Rng *rng) {
+  uint64_t *s = rng->s;
+  uint64_t result = RngRotl(s[1] * 5, 7) * 9;
+  uint64_t t = s[1] << 17;
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = RngRotl(s[3], 45);
+  return result;
+}
+
+// Uniform in [0, bound) without modulo bias (Lemire's multiply-shift with
+// rejection). bound must be nonzero.
+static inline uint64_t RngBounded(Rng *rng, uint64_t bound) {
+  __uint128_t m = (__uint128_t)RngNext(rng) * bound;
+  uint64_t low = (uint64_t)m;
+  if (low < bound) {
+    uint64_t threshold = -bound % bound;
+    while (low < threshold) {
+      m = (__uint128_t)RngNext(rng) * bound;
+      low = (uint64_t)m;
+    }
+  }
+  return (uint64_t)(m >> 64);
+}
+
+// Uniformly random permutation of 0..n-1, built in parallel: elements are
+// scattered to random buckets, then each bucket is Fisher-Yates shuffled.
+// The result depends only on n and seed. Returns NULL if out of memory.
+size_t *RandomPermutation(size_t n, uint64_t seed);
+// Same, into a caller-provided buffer of n entries. Returns 0 if out of
+// memory for the bucket tables.
+int BuildPermutation(size_t *out, size_t n, uint64_t seed);
+
+// next[order[i]] = order[i + 1], closing the cycle back to order[0], so
+// following `next` from any slot visits all n slots.
+void LinkCycle(uint64_t *next, const size_t *order, size_t n);
+
+#endif
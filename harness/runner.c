@@ -0,0 +1,82 @@
+#include "harness/runner.h"
+
+#include "harness/array_state.h"
+#include "harness/perf_counters.h"
+#include "harness/report.h"
+#include "harness/stats.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+BenchResult RunTrials(const BenchCall *call, uint64_t *array, size_t n,
+                      const TrialConfig *cfg) {
+  // Input preparation is logged once, then free unless a call clobbers it.
+  // Building it does not count against the time budget.
+  PrepareArray(array, n, call->input);
+  uint64_t begin = NowNs();
+  uint64_t budget_ns = (uint64_t)(cfg->budget_sec * 1e9);
+  SetBenchLogMuted(1);
+  for (size_t w = 0; w < cfg->warmup; w++) {
+    PrepareArray(array, n, call->input);
+    if (CallBench(call, array, n).iterations == 0) {
+      SetBenchLogMuted(0);
+      BenchResult error = {0};
+      return error;
+    }
+  }
+  SetBenchLogMuted(0);
+
+  size_t max_trials = cfg->max_trials > 0 ? cfg->max_trials : 1;
+  double *samples = malloc(max_trials * sizeof(double));
+  if (!samples) {
+    fprintf(stderr, "Failed to allocate trial samples\n");
+    BenchResult error = {0};
+    return error;
+  }
+
+  BenchResult last = {0};
+  BenchStats stats = {0};
+  BenchCounters counters = {0};
+  size_t trials = 0;
+  uint64_t untimed_ns = 0;
+  while (trials < max_trials) {
+    PrepareArray(array, n, call->input);
+    uint64_t call_start = NowNs();
+    last = CallBench(call, array, n);
+    if (last.iterations == 0) {
+      // The benchmark said why; a failed call is not a sample.
+      SetBenchLogMuted(0);
+      free(samples);
+      BenchResult error = {0};
+      return error;
+    }
+    uint64_t call_ns = NowNs() - call_start;
+    untimed_ns += call_ns > last.total_ns ? call_ns - last.total_ns : 0;
+    PerfCountersAccumulate(&counters, last.iterations);
+    samples[trials++] = last.ns_per_access;
+    SetBenchLogMuted(1);
+    ComputeStats(samples, trials, &stats);
+
+    if (trials >= cfg->min_trials &&
+        RelativeCiHalfWidth(&stats) <= cfg->ci_target) {
+      break;
+    }
+    if (NowNs() - begin >= budget_ns) break;
+  }
+  SetBenchLogMuted(0);
+  free(samples);
+
+  BenchResult result = last;
+  result.stats = stats;
+  result.counters = counters;
+  result.stats.warmup = cfg->warmup;
+  result.setup_ns = trials ? untimed_ns / trials : 0;
+  // Bandwidth of the median trial, so it describes the same run as the
+  // latency: the bytes each access moves over the median time per access.
+  if (last.ns_per_access > 0) {
+    result.gbps = last.gbps * last.ns_per_access / stats.median;
+  }
+  result.ns_per_access = stats.median;
+  result.total_ns = (uint64_t)(stats.median * (double)last.iterations);
+  return result;
+}
@@ -0,0 +1,45 @@
+#ifndef HARNESS_RUNNER_H_
+#define HARNESS_RUNNER_H_
+
+#include "bench.h"
+
+#include <stddef.h>
+
+typedef struct {
+  size_t warmup;      // Untimed passes before sampling starts
+  size_t min_trials;  // Always take at least this many samples
+  size_t max_trials;  // Never take more than this many samples
+  double ci_target;   // Stop once the 95% CI half-width / mean drops below
+  double budget_sec;  // Stop adding trials once this much time has passed
+} TrialConfig;
+
+#define TRIAL_CONFIG_DEFAULT                                                \
+  {.warmup = 1, .min_trials = 3, .max_trials = 30, .ci_target = 0.01,      \
+   .budget_sec = 10.0}
+
+// One runnable benchmark: either a fixed BenchFunc or a parameterized
+// function together with its parameter values.
+typedef struct {
+  BenchFunc func;
+  BenchParamFunc param_func;
+  int64_t params[MAX_BENCH_PARAMS];
+  ArrayState input;  // Prepared by RunTrials before every call
+} BenchCall;
+
+static inline BenchResult CallBench(const BenchCall *call, uint64_t *array,
+                                    size_t n) {
+  return call->func ? call->func(array, n)
+                    : call->param_func(array, n, call->params);
+}
+
+// Prepares call->input, runs the benchmark cfg->warmup times, then keeps
+// sampling until the confidence interval is tight enough, max_trials is
+// hit, or the time budget runs out (the first timed trial always runs).
+// The returned result reports the median ns/access and carries the full
+// distribution in `stats`. If any call fails (returns zero iterations),
+// sampling stops and the result has zero iterations too; callers must not
+// report it.
+BenchResult RunTrials(const BenchCall *call, uint64_t *array, size_t n,
+                      const TrialConfig *cfg);
+
+#endif
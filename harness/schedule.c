@@ -0,0 +1,209 @@
+#include "harness/schedule.h"
+
+#include "bench.h"
+#include "harness/pool.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CACHE_LINE 64
+
+// A worker's remaining chunks [head, tail), packed into one word so that
+// the owner's pop from the front and a thief's cut from the back are each
+// a single CAS.
+typedef struct {
+  _Alignas(CACHE_LINE) atomic_uint_fast64_t range;
+} ChunkRun;
+
+typedef struct {
+  size_t n;
+  size_t chunk;
+  size_t threads;
+  Schedule schedule;
+  ChunkFunc func;
+  void *ctx;
+  ChunkRun *runs;
+} Job;
+
+typedef struct {
+  _Alignas(CACHE_LINE) Job *job;
+  size_t worker;
+  size_t elements;
+  size_t chunks;
+  size_t steals;
+  uint64_t rng;
+} WorkerArg;
+
+static inline uint64_t PackRun(uint64_t head, uint64_t tail) {
+  return head << 32 | tail;
+}
+
+static int PopChunk(ChunkRun *run, size_t *chunk) {
+  uint64_t r = atomic_load_explicit(&run->range, memory_order_relaxed);
+  for (;;) {
+    uint64_t head = r >> 32, tail = r & 0xffffffffu;
+    if (head >= tail) return 0;
+    if (atomic_compare_exchange_weak_explicit(&run->range, &r,
+                                              PackRun(head + 1, tail),
+                                              memory_order_acq_rel,
+                                              memory_order_relaxed)) {
+      *chunk = head;
+      return 1;
+    }
+  }
+}
+
+// Cuts the back half (at least one chunk) off the victim's run.
+static int StealHalf(ChunkRun *victim, uint64_t *begin, uint64_t *end) {
+  uint64_t r = atomic_load_explicit(&victim->range, memory_order_relaxed);
+  for (;;) {
+    uint64_t head = r >> 32, tail = r & 0xffffffffu;
+    if (head >= tail) return 0;
+    uint64_t cut = tail - (tail - head + 1) / 2;
+    if (atomic_compare_exchange_weak_explicit(&victim->range, &r,
+                                              PackRun(head, cut),
+                                              memory_order_acq_rel,
+                                              memory_order_relaxed)) {
+      *begin = cut;
+      *end = tail;
+      return 1;
+    }
+  }
+}
+
+// Visits every other worker once, starting at a random one, and moves the
+// first half-run it can steal into our own (empty) run. Work only ever
+// moves between runs, so a full pass that finds nothing means we are done.
+static int StealWork(WorkerArg *arg) {
+  Job *job = arg->job;
+  arg->rng ^= arg->rng << 13;
+  arg->rng ^= arg->rng >> 7;
+  arg->rng ^= arg->rng << 17;
+  size_t start = arg->rng % job->threads;
+  for (size_t i = 0; i < job->threads; i++) {
+    size_t victim = (start + i) % job->threads;
+    if (victim == arg->worker) continue;
+    uint64_t begin, end;
+    if (StealHalf(&job->runs[victim], &begin, &end)) {
+      atomic_store_explicit(&job->runs[arg->worker].range,
+                            PackRun(begin, end), memory_order_release);
+      arg->steals++;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static void RunWorker(void *p) {
+  WorkerArg *arg = p;
+  Job *job = arg->job;
+  if (job->schedule == kScheduleStatic) {
+    size_t share = job->n / job->threads, extra = job->n % job->threads;
+    size_t w = arg->worker;
+    size_t begin = w * share + (w < extra ? w : extra);
+    size_t end = begin + share + (w < extra ? 1 : 0);
+    if (begin < end) job->func(begin, end, w, job->ctx);
+    arg->elements = end - begin;
+    arg->chunks = begin < end;
+    return;
+  }
+  ChunkRun *own = &job->runs[arg->worker];
+  do {
+    size_t c;
+    while (PopChunk(own, &c)) {
+      size_t begin = c * job->chunk;
+      size_t end = begin + job->chunk < job->n ? begin + job->chunk : job->n;
+      job->func(begin, end, arg->worker, job->ctx);
+      arg->elements += end - begin;
+      arg->chunks++;
+    }
+  } while (StealWork(arg));
+}
+
+int ScheduleRun(size_t n, size_t threads, Schedule schedule, size_t chunk,
+                ChunkFunc func, void *ctx, ScheduleStats *stats) {
+  if (chunk == 0) chunk = SCHEDULE_DEFAULT_CHUNK;
+  // Chunk indices must fit the 32-bit halves of a run.
+  while (n / chunk >= 0xffffffffu) chunk *= 2;
+  size_t num_chunks = (n + chunk - 1) / chunk;
+
+  ChunkRun *runs = aligned_alloc(CACHE_LINE, threads * sizeof(ChunkRun));
+  WorkerArg *args = aligned_alloc(CACHE_LINE, threads * sizeof(WorkerArg));
+  if (!runs || !args) {
+    fprintf(stderr, "Failed to allocate scheduler state for %zu threads\n",
+            threads);
+    free(runs);
+    free(args);
+    return 0;
+  }
+  Job job = {.n = n, .chunk = chunk, .threads = threads,
+             .schedule = schedule, .func = func, .ctx = ctx, .runs = runs};
+  for (size_t w = 0; w < threads; w++) {
+    atomic_init(&runs[w].range, PackRun(w * num_chunks / threads,
+                                        (w + 1) * num_chunks / threads));
+    memset(&args[w], 0, sizeof(args[w]));
+    args[w].job = &job;
+    args[w].worker = w;
+    args[w].rng = 0x9e3779b97f4a7c15ULL * (w + 1);
+  }
+
+  PoolTiming timing;
+  int ok = PoolRun(threads, RunWorker, args, sizeof(WorkerArg), &timing);
+  if (ok && stats) {
+    stats->span_ns = timing.span_ns;
+    stats->threads = threads;
+    stats->chunk = schedule == kScheduleDynamic ? chunk : 0;
+    stats->schedule = schedule;
+    for (size_t w = 0; w < threads; w++) {
+      uint64_t start, end;
+      PoolWorkerWindow(w, &start, &end);
+      ScheduleWorker *sw = &stats->workers[w];
+      sw->elements = args[w].elements;
+      sw->chunks = args[w].chunks;
+      sw->steals = args[w].steals;
+      sw->busy_ns = end - start;
+      sw->idle_ns = timing.span_ns > sw->busy_ns ? timing.span_ns - sw->busy_ns
+                                                 : 0;
+    }
+  }
+  free(runs);
+  free(args);
+  return ok;
+}
+
+void LogScheduleStats(const ScheduleStats *stats, int per_thread) {
+  const ScheduleWorker *w = stats->workers;
+  if (stats->schedule == kScheduleDynamic) {
+    BenchLog("  Schedule: dynamic, %zu thread%s, %zu-element chunks\n",
+             stats->threads, stats->threads == 1 ? "" : "s", stats->chunk);
+  } else {
+    BenchLog("  Schedule: static, %zu thread%s\n", stats->threads,
+             stats->threads == 1 ? "" : "s");
+  }
+  if (per_thread) {
+    BenchLog("  %6s  %12s  %8s  %6s  %9s  %6s\n", "thread", "elements",
+             "chunks", "steals", "busy ms", "idle %");
+    for (size_t t = 0; t < stats->threads; t++) {
+      BenchLog("  %6zu  %12zu  %8zu  %6zu  %9.3f  %6.1f\n", t, w[t].elements,
+               w[t].chunks, w[t].steals, w[t].busy_ns / 1e6,
+               100.0 * w[t].idle_ns / stats->span_ns);
+    }
+  }
+  uint64_t min_busy = w[0].busy_ns, max_busy = w[0].busy_ns;
+  uint64_t idle = 0, max_idle = 0;
+  size_t steals = 0;
+  for (size_t t = 0; t < stats->threads; t++) {
+    if (w[t].busy_ns < min_busy) min_busy = w[t].busy_ns;
+    if (w[t].busy_ns > max_busy) max_busy = w[t].busy_ns;
+    if (w[t].idle_ns > max_idle) max_idle = w[t].idle_ns;
+    idle += w[t].idle_ns;
+    steals += w[t].steals;
+  }
+  BenchLog("  Busy: %.3f..%.3f ms; idle: %.1f%% mean, %.1f%% max of %.3f ms; "
+           "%zu steals\n",
+           min_busy / 1e6, max_busy / 1e6,
+           100.0 * idle / stats->threads / stats->span_ns,
+           100.0 * max_idle / stats->span_ns, stats->span_ns / 1e6, steals);
+}
@@ -0,0 +1,57 @@
+#ifndef HARNESS_SCHEDULE_H_
+#define HARNESS_SCHEDULE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Chunked scheduling of a timed [0, n) range over pool workers.
+//
+// Static: worker w gets the w-th contiguous share up front, as the fixed
+// threaded benchmarks always did; the slowest worker sets the time.
+// Dynamic: the range is cut into chunks, each worker starts on its own
+// contiguous run of chunks and takes them front to back, and a worker that
+// runs dry steals the back half of a random victim's remaining run. Chunks
+// stay contiguous within a run, so hardware prefetchers keep streaming.
+
+typedef enum {
+  kScheduleStatic,
+  kScheduleDynamic,
+} Schedule;
+
+// Handles elements [begin, end) on pool worker `worker`.
+typedef void (*ChunkFunc)(size_t begin, size_t end, size_t worker,
+                          void *ctx);
+
+// What one worker did during a ScheduleRun.
+typedef struct {
+  size_t elements;
+  size_t chunks;
+  size_t steals;     // Successful steals (dynamic only)
+  uint64_t busy_ns;  // Own task window
+  uint64_t idle_ns;  // Rest of the run's span: started late or ran dry
+} ScheduleWorker;
+
+typedef struct {
+  uint64_t span_ns;  // First worker start to last worker end
+  Schedule schedule;
+  size_t threads;
+  size_t chunk;      // Elements per chunk (dynamic only)
+  ScheduleWorker *workers;  // One per thread, owned by the caller
+} ScheduleStats;
+
+// Elements per dynamic chunk unless the caller picks one: 64 KiB of
+// uint64_t, small enough to balance and large enough to amortize a CAS.
+#define SCHEDULE_DEFAULT_CHUNK ((size_t)8192)
+
+// Runs func over [0, n) on `threads` pool workers. `stats` is optional;
+// its `workers` array must hold `threads` entries. Returns 0 if the
+// workers could not be started.
+int ScheduleRun(size_t n, size_t threads, Schedule schedule, size_t chunk,
+                ChunkFunc func, void *ctx, ScheduleStats *stats);
+
+// Logs the spread between the busiest and the idlest worker, preceded by a
+// per-thread table (elements, chunks, steals, busy ms, idle %) if
+// `per_thread` is set.
+void LogScheduleStats(const ScheduleStats *stats, int per_thread);
+
+#endif
@@ -0,0 +1,76 @@
+#include "harness/stats.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Two-sided 95% Student t critical values for 1..30 degrees of freedom.
+static const double kT95[] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201,  2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080,  2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042,
+};
+
+double TCritical95(size_t df) {
+  if (df == 0) return 0.0;
+  if (df <= sizeof(kT95) / sizeof(kT95[0])) return kT95[df - 1];
+  if (df <= 60) return 2.000;
+  if (df <= 120) return 1.980;
+  return 1.960;
+}
+
+static int CmpDouble(const void *a, const void *b) {
+  double x = *(const double *)a;
+  double y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+// Linear interpolation between closest ranks on sorted data.
+static double Percentile(const double *sorted, size_t n, double p) {
+  if (n == 1) return sorted[0];
+  double rank = p * (double)(n - 1);
+  size_t lo = (size_t)rank;
+  if (lo + 1 >= n) return sorted[n - 1];
+  double frac = rank - (double)lo;
+  return sorted[lo] + (sorted[lo + 1] - sorted[lo]) * frac;
+}
+
+void ComputeStats(const double *samples, size_t n, BenchStats *out) {
+  memset(out, 0, sizeof(*out));
+  out->trials = n;
+  if (n == 0) return;
+
+  double *sorted = malloc(n * sizeof(double));
+  if (!sorted) return;
+  memcpy(sorted, samples, n * sizeof(double));
+  qsort(sorted, n, sizeof(double), CmpDouble);
+
+  double sum = 0.0;
+  for (size_t i = 0; i < n; i++) sum += sorted[i];
+  double mean = sum / (double)n;
+
+  double sq = 0.0;
+  for (size_t i = 0; i < n; i++) {
+    double d = sorted[i] - mean;
+    sq += d * d;
+  }
+  double stddev = n > 1 ? sqrt(sq / (double)(n - 1)) : 0.0;
+  double half = TCritical95(n - 1) * stddev / sqrt((double)n);
+
+  out->min = sorted[0];
+  out->max = sorted[n - 1];
+  out->median = Percentile(sorted, n, 0.50);
+  out->mean = mean;
+  out->p90 = Percentile(sorted, n, 0.90);
+  out->p99 = Percentile(sorted, n, 0.99);
+  out->stddev = stddev;
+  out->ci_low = mean - half;
+  out->ci_high = mean + half;
+
+  free(sorted);
+}
+
+double RelativeCiHalfWidth(const BenchStats *stats) {
+  if (stats->trials < 2 || stats->mean <= 0.0) return INFINITY;
+  return (stats->ci_high - stats->ci_low) / 2.0 / stats->mean;
+}
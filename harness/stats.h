@@ -0,0 +1,20 @@
+#ifndef HARNESS_STATS_H_
+#define HARNESS_STATS_H_
+
+#include "bench.h"
+
+#include <stddef.h>
+
+// Summarizes `n` samples (ns per access, one per timed trial) into `out`.
+// The samples are not modified. With fewer than two samples the spread
+// fields are zero and the confidence interval collapses onto the mean.
+void ComputeStats(const double *samples, size_t n, BenchStats *out);
+
+// Half-width of the 95% confidence interval relative to the mean
+// (0.01 == +/-1%). Returns a large value when it cannot be estimated yet.
+double RelativeCiHalfWidth(const BenchStats *stats);
+
+// Two-sided 95% Student t critical value for `df` degrees of freedom.
+double TCritical95(size_t df);
+
+#endif
@@ -0,0 +1,226 @@
+#include "harness/sweep.h"
+
+#include "harness/report.h"
+#include "harness/units.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// A new level starts once latency exceeds the current plateau by this much.
+static const double kLevelRise = 1.3;
+// Points within this factor of the plateau still belong to it; steps larger
+// than this are treated as part of a transition.
+static const double kPlateauTolerance = 1.1;
+
+#define MAX_LEVELS 8
+#define MAX_SYSFS_CACHES 8
+
+typedef struct {
+  int level;
+  char type[16];
+  size_t bytes;
+} SysfsCache;
+
+static int CmpDouble(const void *a, const void *b) {
+  double x = *(const double *)a;
+  double y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+// Median of values[lo..hi]; `scratch` must hold hi - lo + 1 doubles.
+static double Median(const double *values, size_t lo, size_t hi,
+                     double *scratch) {
+  size_t n = hi - lo + 1;
+  memcpy(scratch, values + lo, n * sizeof(double));
+  qsort(scratch, n, sizeof(double), CmpDouble);
+  return n % 2 ? scratch[n / 2] : (scratch[n / 2 - 1] + scratch[n / 2]) / 2.0;
+}
+
+size_t DetectCacheLevels(const size_t *sizes, const double *ns, size_t count,
+                         CacheLevel *levels, size_t max_levels) {
+  if (count == 0 || max_levels == 0) return 0;
+  double *smooth = malloc(count * sizeof(double));
+  double *scratch = malloc(count * sizeof(double));
+  if (!smooth || !scratch) {
+    free(smooth);
+    free(scratch);
+    return 0;
+  }
+
+  // Median-of-3 smoothing so a single noisy point cannot fake a knee.
+  for (size_t i = 0; i < count; i++) {
+    size_t lo = i > 0 ? i - 1 : i;
+    size_t hi = i + 1 < count ? i + 1 : i;
+    smooth[i] = Median(ns, lo, hi, scratch);
+  }
+
+  size_t num_levels = 0;
+  size_t start = 0;
+  size_t i = 1;
+  while (i < count && num_levels + 1 < max_levels) {
+    double ref = Median(ns, start, i - 1, scratch);
+    if (smooth[i] <= ref * kLevelRise) {
+      i++;
+      continue;
+    }
+
+    // The knee is the last point that still sat on the plateau.
+    size_t knee = i - 1;
+    while (knee > start && smooth[knee] > ref * kPlateauTolerance) knee--;
+    levels[num_levels++] = (CacheLevel){
+        .start_bytes = sizes[start],
+        .capacity_bytes = sizes[knee],
+        .ns_per_access = Median(ns, start, knee, scratch),
+    };
+
+    // Skip the transition until the curve flattens out again.
+    size_t j = i;
+    while (j + 1 < count && smooth[j + 1] > smooth[j] * kPlateauTolerance) j++;
+    start = j;
+    i = j + 1;
+  }
+
+  levels[num_levels++] = (CacheLevel){
+      .start_bytes = sizes[start],
+      .capacity_bytes = 0,
+      .ns_per_access = Median(ns, start, count - 1, scratch),
+  };
+  free(smooth);
+  free(scratch);
+  return num_levels;
+}
+
+static size_t ReadSysfsCaches(SysfsCache *caches, size_t max) {
+  size_t found = 0;
+  for (int index = 0; index < 16 && found < max; index++) {
+    char path[128], buf[64];
+    SysfsCache c = {0};
+
+    snprintf(path, sizeof(path),
+             "/sys/devices/system/cpu/cpu0/cache/index%d/level", index);
+    FILE *f = fopen(path, "r");
+    if (!f) break;
+    if (fscanf(f, "%d", &c.level) != 1) c.level = 0;
+    fclose(f);
+
+    snprintf(path, sizeof(path),
+             "/sys/devices/system/cpu/cpu0/cache/index%d/type", index);
+    f = fopen(path, "r");
+    if (f && fscanf(f, "%15s", c.type) != 1) c.type[0] = '\0';
+    if (f) fclose(f);
+    if (strcmp(c.type, "Instruction") == 0) continue;
+
+    snprintf(path, sizeof(path),
+             "/sys/devices/system/cpu/cpu0/cache/index%d/size", index);
+    f = fopen(path, "r");
+    if (f && fscanf(f, "%63s", buf) == 1) ParseByteSize(buf, 1, &c.bytes);
+    if (f) fclose(f);
+    if (c.level > 0 && c.bytes > 0) caches[found++] = c;
+  }
+  return found;
+}
+
+static void PrintLevels(const CacheLevel *levels, size_t num_levels,
+                        const SysfsCache *caches, size_t num_caches) {
+  size_t largest_cache = 0;
+  for (size_t c = 0; c < num_caches; c++) {
+    if (caches[c].bytes > largest_cache) largest_cache = caches[c].bytes;
+  }
+
+  char buf[32];
+  BenchLog("\nDetected levels:\n");
+  for (size_t l = 0; l < num_levels; l++) {
+    char name[24];
+    if (levels[l].capacity_bytes) {
+      snprintf(name, sizeof(name), "L%zu", l + 1);
+      BenchLog("  %-5s up to ~%-12s %8.2f ns\n", name,
+               FormatBytes(levels[l].capacity_bytes, buf, sizeof(buf)),
+               levels[l].ns_per_access);
+      continue;
+    }
+    // The last plateau is only memory if the sweep went past every cache.
+    int is_dram = largest_cache ? levels[l].start_bytes > largest_cache
+                                : num_levels >= 4;
+    if (is_dram) {
+      snprintf(name, sizeof(name), "DRAM");
+    } else {
+      snprintf(name, sizeof(name), "L%zu", l + 1);
+    }
+    BenchLog("  %-5s %-21s %8.2f ns\n", name,
+             is_dram ? "" : "(sweep ended inside)", levels[l].ns_per_access);
+  }
+
+  if (num_caches) {
+    BenchLog("sysfs reports:");
+    for (size_t c = 0; c < num_caches; c++) {
+      BenchLog(" L%d%s %s%s", caches[c].level,
+               strcmp(caches[c].type, "Data") == 0 ? "d" : "",
+               FormatBytes(caches[c].bytes, buf, sizeof(buf)),
+               c + 1 < num_caches ? "," : "\n");
+    }
+  }
+}
+
+int RunSweep(const char *id, const BenchCall *call, uint64_t *array,
+             const SweepConfig *sweep, const TrialConfig *trials) {
+  size_t per_octave = sweep->points_per_octave ? sweep->points_per_octave : 1;
+  double factor = pow(2.0, 1.0 / (double)per_octave);
+  size_t max_points =
+      (size_t)(log2((double)sweep->max_bytes / (double)sweep->min_bytes) *
+               per_octave) + 2;
+
+  size_t *sizes = malloc(max_points * sizeof(size_t));
+  double *ns = malloc(max_points * sizeof(double));
+  if (!sizes || !ns) {
+    fprintf(stderr, "Failed to allocate sweep points\n");
+    free(sizes);
+    free(ns);
+    return 0;
+  }
+
+  char lo[32], hi[32], buf[32];
+  BenchLog("\n=== Working-set sweep: %s (%s .. %s, %zu points/octave) ===\n",
+           id, FormatBytes(sweep->min_bytes, lo, sizeof(lo)),
+           FormatBytes(sweep->max_bytes, hi, sizeof(hi)), per_octave);
+  BenchLog("%14s %12s %10s\n", "working set", "ns/access", "+/- CI");
+
+  size_t count = 0;
+  double target = (double)sweep->min_bytes;
+  while (count < max_points) {
+    // Whole cache lines, and never the same size twice after rounding.
+    size_t bytes = ((size_t)(target + 0.5) + 63) & ~(size_t)63;
+    if (bytes > sweep->max_bytes) break;
+    target *= factor;
+    if (count > 0 && bytes <= sizes[count - 1]) continue;
+
+    BenchResult result = RunTrials(call, array, bytes / sizeof(uint64_t),
+                                   trials);
+    if (result.iterations == 0) {
+      free(sizes);
+      free(ns);
+      return 0;
+    }
+    sizes[count] = bytes;
+    ns[count] = result.ns_per_access;
+    count++;
+
+    double half = (result.stats.ci_high - result.stats.ci_low) / 2.0;
+    BenchLog("%14s %12.2f %10.2f\n", FormatBytes(bytes, buf, sizeof(buf)),
+             result.ns_per_access, half);
+    char point_id[64];
+    snprintf(point_id, sizeof(point_id), "%s@%zu", id, bytes);
+    ReportPoint(point_id, "", bytes, &result);
+  }
+
+  CacheLevel levels[MAX_LEVELS];
+  size_t num_levels = DetectCacheLevels(sizes, ns, count, levels, MAX_LEVELS);
+  SysfsCache caches[MAX_SYSFS_CACHES];
+  size_t num_caches = ReadSysfsCaches(caches, MAX_SYSFS_CACHES);
+  PrintLevels(levels, num_levels, caches, num_caches);
+
+  free(sizes);
+  free(ns);
+  return 1;
+}
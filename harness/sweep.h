@@ -0,0 +1,37 @@
+#ifndef HARNESS_SWEEP_H_
+#define HARNESS_SWEEP_H_
+
+#include "bench.h"
+#include "harness/runner.h"
+
+#include <stddef.h>
+
+typedef struct {
+  size_t min_bytes;
+  size_t max_bytes;
+  size_t points_per_octave;
+} SweepConfig;
+
+#define SWEEP_CONFIG_DEFAULT                                        \
+  {.min_bytes = 4096, .max_bytes = (size_t)512 << 20,               \
+   .points_per_octave = 4}
+
+typedef struct {
+  size_t start_bytes;     // Smallest working set on the level's plateau
+  size_t capacity_bytes;  // Largest working set served by the level; 0 = last
+  double ns_per_access;   // Median latency on the level's plateau
+} CacheLevel;
+
+// Runs `call` on the first k bytes of `array` for a geometric series of k
+// from sweep->min_bytes to sweep->max_bytes (array must hold max_bytes),
+// prints the latency-vs-size curve and the cache levels inferred from it.
+// Returns 0 if a point failed.
+int RunSweep(const char *id, const BenchCall *call, uint64_t *array,
+             const SweepConfig *sweep, const TrialConfig *trials);
+
+// Splits a latency curve into plateaus separated by knees. `sizes` must be
+// increasing. Returns the number of levels written (at most max_levels).
+size_t DetectCacheLevels(const size_t *sizes, const double *ns, size_t count,
+                         CacheLevel *levels, size_t max_levels);
+
+#endif
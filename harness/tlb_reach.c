@@ -0,0 +1,257 @@
+#include "harness/tlb_reach.h"
+
+#include "bench.h"
+#include "harness/report.h"
+#include "harness/units.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static const ParamBenchEntry kReachEntry = {
+    "tlbreach", "TLB reach sweep", NULL, kStateScratch,
+    {{"page", "bytes per page", 4096, 64, (int64_t)1 << 30, NULL}}};
+
+#define MIN_PAGES 8
+#define MAX_PAGES ((size_t)1 << 20)
+#define MAX_POINTS 64
+// Past this many bytes of page-table entries the walks themselves miss in
+// the data caches; those points are shown but not fitted.
+#define FIT_PTE_BYTES ((size_t)64 << 10)
+// A second TLB level must cut the squared error by this much and cost at
+// least MIN_LEVEL_NS per miss to be reported.
+#define SECOND_LEVEL_GAIN 0.75
+#define MIN_LEVEL_NS 0.3
+
+typedef struct {
+  size_t pages;
+  double spread_ns;
+  double packed_ns;
+} ReachPoint;
+
+// Penalty model: base + s * m(c1) + w * m(c2), where m(c) is the miss rate
+// of a c-entry TLB under uniformly random pages, applied to the spread
+// layout minus the packed control's own (much smaller) page set.
+typedef struct {
+  size_t c1, c2;  // Entries; c1 == 0 for a single level
+  double base, s, w;
+  double sse;
+} ReachFit;
+
+static double MissRate(size_t entries, double pages) {
+  return pages > entries ? 1.0 - entries / pages : 0.0;
+}
+
+int TlbReachGridInit(ParamGrid *grid, PagePolicy pages) {
+  if (!ParamGridInit(grid, &kReachEntry)) return 0;
+  switch (pages) {
+    case kPagesThp:
+    case kPages2M: grid->values[0][0] = (int64_t)2 << 20; break;
+    case kPages1G: grid->values[0][0] = (int64_t)1 << 30; break;
+    default: break;
+  }
+  return 1;
+}
+
+// Weighted least squares for the coefficients of `cols` columns (3 at
+// most) against y; returns the weighted squared error, or INFINITY if
+// singular.
+static double Solve(double x[][3], const double *y, const double *weight,
+                    size_t rows, int cols, double *coef) {
+  double a[3][4] = {{0}};
+  for (size_t r = 0; r < rows; r++) {
+    double w2 = weight[r] * weight[r];
+    for (int i = 0; i < cols; i++) {
+      for (int j = 0; j < cols; j++) a[i][j] += w2 * x[r][i] * x[r][j];
+      a[i][cols] += w2 * x[r][i] * y[r];
+    }
+  }
+  for (int i = 0; i < cols; i++) {
+    int pivot = i;
+    for (int r = i + 1; r < cols; r++) {
+      if (fabs(a[r][i]) > fabs(a[pivot][i])) pivot = r;
+    }
+    if (fabs(a[pivot][i]) < 1e-12) return INFINITY;
+    for (int j = 0; j <= cols; j++) {
+      double t = a[i][j];
+      a[i][j] = a[pivot][j];
+      a[pivot][j] = t;
+    }
+    for (int r = 0; r < cols; r++) {
+      if (r == i) continue;
+      double f = a[r][i] / a[i][i];
+      for (int j = i; j <= cols; j++) a[r][j] -= f * a[i][j];
+    }
+  }
+  for (int i = 0; i < cols; i++) coef[i] = a[i][cols] / a[i][i];
+  double sse = 0;
+  for (size_t r = 0; r < rows; r++) {
+    double e = y[r];
+    for (int i = 0; i < cols; i++) e -= coef[i] * x[r][i];
+    sse += weight[r] * weight[r] * e * e;
+  }
+  return sse;
+}
+
+// Column of miss-rate differences for a `entries`-entry level.
+static void MissColumn(const ReachPoint *pts, size_t count, size_t entries,
+                       size_t lines_per_page, double x[][3], int col) {
+  for (size_t i = 0; i < count; i++) {
+    double packed_pages = (double)pts[i].pages / lines_per_page;
+    x[i][col] = MissRate(entries, pts[i].pages) -
+                MissRate(entries, packed_pages);
+  }
+}
+
+// Tries capacities on a quarter-octave grid: every single level, then every
+// pair, keeping the pair only if it clearly beats one level. Errors are
+// relative to the access time, so the few-ns step of an L1 dTLB miss counts
+// as much as the tens of ns of a page walk.
+static ReachFit FitLevels(const ReachPoint *pts, size_t count,
+                          size_t lines_per_page) {
+  double y[MAX_POINTS], weight[MAX_POINTS], x[MAX_POINTS][3];
+  for (size_t i = 0; i < count; i++) {
+    y[i] = pts[i].spread_ns - pts[i].packed_ns;
+    weight[i] = 1.0 / pts[i].spread_ns;
+    x[i][0] = 1.0;
+  }
+  size_t caps[96];
+  size_t num_caps = 0;
+  for (int k = 0; k < 96; k++) {
+    size_t c = (size_t)(4.0 * pow(2.0, k / 4.0) + 0.5);
+    if (c > pts[count - 1].pages) break;
+    caps[num_caps++] = c;
+  }
+
+  ReachFit one = {.sse = INFINITY};
+  for (size_t a = 0; a < num_caps; a++) {
+    MissColumn(pts, count, caps[a], lines_per_page, x, 1);
+    double coef[3] = {0};
+    double sse = Solve(x, y, weight, count, 2, coef);
+    if (coef[1] > 0 && sse < one.sse) {
+      one = (ReachFit){.c2 = caps[a], .base = coef[0], .w = coef[1],
+                       .sse = sse};
+    }
+  }
+  ReachFit two = {.sse = INFINITY};
+  for (size_t a = 0; a < num_caps; a++) {
+    MissColumn(pts, count, caps[a], lines_per_page, x, 1);
+    for (size_t b = a + 2; b < num_caps; b++) {
+      MissColumn(pts, count, caps[b], lines_per_page, x, 2);
+      double coef[3] = {0};
+      double sse = Solve(x, y, weight, count, 3, coef);
+      if (coef[1] >= MIN_LEVEL_NS && coef[2] > 0 && sse < two.sse) {
+        two = (ReachFit){.c1 = caps[a], .c2 = caps[b], .base = coef[0],
+                         .s = coef[1], .w = coef[2], .sse = sse};
+      }
+    }
+  }
+  return two.sse < one.sse * SECOND_LEVEL_GAIN ? two : one;
+}
+
+static void LogReach(size_t entries, size_t page_bytes, const char *what) {
+  char reach[32];
+  BenchLog("  %-9s ~%zu entries (%s reach)", what, entries,
+           FormatBytes(entries * page_bytes, reach, sizeof(reach)));
+}
+
+static void PrintFit(const ReachFit *fit, size_t page_bytes,
+                     const ReachPoint *last) {
+  if (!isfinite(fit->sse) || fit->w < MIN_LEVEL_NS) {
+    BenchLog("  No translation cost visible; try a larger array\n");
+    return;
+  }
+  if (fit->c1) {
+    LogReach(fit->c1, page_bytes, "L1 dTLB:");
+    BenchLog("\n");
+    LogReach(fit->c2, page_bytes, "STLB:");
+    BenchLog(", +%.1f ns per L1 dTLB miss\n", fit->s);
+  } else {
+    LogReach(fit->c2, page_bytes, "TLB:");
+    BenchLog(" (one level resolved)\n");
+  }
+  BenchLog("  Page walk: +%.1f ns per %s miss (page tables in cache)\n",
+           fit->w, fit->c1 ? "STLB" : "TLB");
+  double tail = last->spread_ns - last->packed_ns - fit->base;
+  char span[32];
+  BenchLog("  At %zu pages (%s): +%.1f ns per access\n", last->pages,
+           FormatBytes(last->pages * page_bytes, span, sizeof(span)), tail);
+}
+
+static int Measure(uint64_t *array, size_t n, const TrialConfig *trials,
+                   size_t pages, size_t page_bytes, int layout, int text,
+                   double *ns) {
+  BenchCall call = {.param_func = BenchTlbReach,
+                    .params = {(int64_t)pages, (int64_t)page_bytes, layout},
+                    .input = kStateScratch};
+  SetBenchLogQuiet(1);
+  BenchResult result = RunTrials(&call, array, n, trials);
+  SetBenchLogQuiet(0);
+  if (result.iterations == 0) return 0;
+  *ns = result.ns_per_access;
+  if (!text) {
+    char params[96];
+    snprintf(params, sizeof(params), "page=%zu,pages=%zu,layout=%s",
+             page_bytes, pages, layout ? "packed" : "spread");
+    ReportResult("tlbreach", params, n * sizeof(uint64_t), &result);
+  }
+  return 1;
+}
+
+static int Sweep(uint64_t *array, size_t n, const TrialConfig *trials,
+                 size_t page_bytes, int text) {
+  size_t max_pages = n * sizeof(uint64_t) / page_bytes;
+  if (max_pages > MAX_PAGES) max_pages = MAX_PAGES;
+  char size[32];
+  BenchLog("\n=== TLB reach: %s pages, one random line per page ===\n",
+           FormatBytes(page_bytes, size, sizeof(size)));
+  if (max_pages < MIN_PAGES) {
+    fprintf(stderr, "TLB reach: the array holds only %zu pages of %zu "
+                    "bytes\n", max_pages, page_bytes);
+    return 0;
+  }
+  BenchLog("  %9s  %10s  %10s  %10s  %10s\n", "pages", "span", "spread ns",
+           "packed ns", "penalty ns");
+
+  ReachPoint pts[MAX_POINTS];
+  size_t count = 0, fitted = 0;
+  // Half-octave steps: 8, 12, 16, 24, 32, ...
+  for (size_t p = MIN_PAGES; p <= max_pages && count < MAX_POINTS;
+       p = (p & (p - 1)) ? (p / 3) * 4 : p * 3 / 2) {
+    ReachPoint *pt = &pts[count];
+    pt->pages = p;
+    if (!Measure(array, n, trials, p, page_bytes, 0, text, &pt->spread_ns) ||
+        !Measure(array, n, trials, p, page_bytes, 1, text, &pt->packed_ns)) {
+      return 0;
+    }
+    BenchLog("  %9zu  %10s  %10.2f  %10.2f  %10.2f\n", p,
+             FormatBytes(p * page_bytes, size, sizeof(size)), pt->spread_ns,
+             pt->packed_ns, pt->spread_ns - pt->packed_ns);
+    count++;
+    if (p * sizeof(uint64_t) <= FIT_PTE_BYTES) fitted = count;
+  }
+  if (fitted < 6) {
+    BenchLog("  Too few points to fit TLB levels\n");
+    return 1;
+  }
+  ReachFit fit = FitLevels(pts, fitted, page_bytes / 64);
+  BenchLog("\n");
+  PrintFit(&fit, page_bytes, &pts[count - 1]);
+  return 1;
+}
+
+int RunTlbReach(const ParamGrid *grid, uint64_t *array, size_t n,
+                const TrialConfig *trials) {
+  PageBacking backing;
+  if (QueryPageBacking(array, &backing) && HugePageFraction(&backing) > 0.5) {
+    BenchLog("Note: %.0f%% of the array is in huge pages; spacings below "
+             "the huge page size measure huge-page translations (use "
+             "--pages=4k for base pages)\n",
+             100 * HugePageFraction(&backing));
+  }
+  int text = ReportFormat() == kFormatText;
+  for (size_t v = 0; v < grid->num_values[0]; v++) {
+    if (!Sweep(array, n, trials, (size_t)grid->values[0][v], text)) return 0;
+  }
+  return 1;
+}
@@ -0,0 +1,27 @@
+#ifndef HARNESS_TLB_REACH_H_
+#define HARNESS_TLB_REACH_H_
+
+#include "harness/alloc.h"
+#include "harness/params.h"
+#include "harness/runner.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// TLB reach: runs tlb_reach over a growing number of pages, each time once
+// with one random line per page and once with the same lines packed, and
+// takes the difference as the cost of translation. A two-level model
+// (L1 dTLB and STLB capacity, the extra cost of each miss) is then fitted
+// to that curve, giving the TLB capacities and the page-walk penalty.
+
+// Grid of page sizes. Default: the huge page size for --pages=thp, 2m and
+// 1g, else 4 KiB.
+int TlbReachGridInit(ParamGrid *grid, PagePolicy pages);
+
+// Sweeps 8 pages up to 1M pages (or what fits the array) for every page
+// size and prints the curve and the fitted TLB levels. Returns 0 if a
+// measurement failed.
+int RunTlbReach(const ParamGrid *grid, uint64_t *array, size_t n,
+                const TrialConfig *trials);
+
+#endif
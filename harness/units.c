@@ -0,0 +1,47 @@
+#include "harness/units.h"
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+int ParseByteSize(const char *text, size_t default_unit, size_t *out) {
+  char *end;
+  double value = strtod(text, &end);
+  if (end == text || value <= 0) return 0;
+
+  double unit = (double)default_unit;
+  switch (toupper((unsigned char)*end)) {
+    case 'B': unit = 1.0; break;
+    case 'K': unit = 1024.0; end++; break;
+    case 'M': unit = 1024.0 * 1024; end++; break;
+    case 'G': unit = 1024.0 * 1024 * 1024; end++; break;
+    case 'T': unit = 1024.0 * 1024 * 1024 * 1024; end++; break;
+    case '\0': break;
+    default: return 0;
+  }
+  if (toupper((unsigned char)*end) == 'I') end++;
+  if (toupper((unsigned char)*end) == 'B') end++;
+  if (*end != '\0') return 0;
+
+  double bytes = value * unit;
+  if (bytes < 1.0 || bytes >= (double)SIZE_MAX) return 0;
+  *out = (size_t)bytes;
+  return 1;
+}
+
+const char *FormatBytes(size_t bytes, char *buf, size_t size) {
+  static const char *kUnits[] = {"B", "KiB", "MiB", "GiB", "TiB"};
+  double value = (double)bytes;
+  int unit = 0;
+  while (value >= 1024.0 && unit < 4) {
+    value /= 1024.0;
+    unit++;
+  }
+  if (value == (double)(uint64_t)value) {
+    snprintf(buf, size, "%.0f %s", value, kUnits[unit]);
+  } else {
+    snprintf(buf, size, "%.3g %s", value, kUnits[unit]);
+  }
+  return buf;
+}
@@ -0,0 +1,16 @@
+#ifndef HARNESS_UNITS_H_
+#define HARNESS_UNITS_H_
+
+#include <stddef.h>
+
+// Parses a byte count such as "4K", "512M", "64G" or "1.5g" (binary units,
+// optional trailing "B"/"iB"). A bare number is multiplied by
+// `default_unit`, so legacy sizes like "256" can still mean megabytes.
+// Returns 0 on malformed input or overflow.
+int ParseByteSize(const char *text, size_t default_unit, size_t *out);
+
+// Formats `bytes` with the largest binary unit that keeps at least one
+// whole unit ("48 KiB", "1.25 MiB"). Returns `buf`.
+const char *FormatBytes(size_t bytes, char *buf, size_t size);
+
+#endif
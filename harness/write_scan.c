@@ -0,0 +1,148 @@
+#include "harness/write_scan.h"
+
+#include "bench.h"
+#include "harness/report.h"
+#include "harness/units.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+enum { kOpFill, kOpCopy };
+
+static const char *const kOpNames[] = {"fill", "copy", NULL};
+static const char *const kMethodNames[WRITE_NUM_METHODS] = {
+    "loop", "nt", "rep", "libc", "avx2", "avx512"};
+
+static const ParamBenchEntry kScanEntry = {
+    "writescan", "Write-path scan", NULL, kStateScratch,
+    {{"op", "memset- or memcpy-like", kOpFill, kOpFill, kOpCopy, kOpNames},
+     {"misalign", "destination bytes past a cache line", 0, 0, 63, NULL}}};
+
+#define MIN_SIZE ((size_t)64)
+#define MAX_SIZES 48
+// Room `write` needs besides the data: page rounding and the source skew.
+#define LAYOUT_SLACK ((size_t)8 << 10)
+// The previous size's winner keeps the lead unless another method beats it
+// by more than this, so run-to-run noise between near-equal methods does
+// not show up as crossovers.
+#define TIE 1.05
+
+int WriteScanGridInit(ParamGrid *grid) {
+  if (!ParamGridInit(grid, &kScanEntry)) return 0;
+  int64_t *ops = malloc(2 * sizeof(int64_t));
+  int64_t *offsets = malloc(2 * sizeof(int64_t));
+  if (!ops || !offsets) {
+    free(ops);
+    free(offsets);
+    return 0;
+  }
+  ops[0] = kOpFill;
+  ops[1] = kOpCopy;
+  offsets[0] = 0;
+  offsets[1] = 1;
+  free(grid->values[0]);
+  grid->values[0] = ops;
+  grid->num_values[0] = 2;
+  free(grid->values[1]);
+  grid->values[1] = offsets;
+  grid->num_values[1] = 2;
+  return 1;
+}
+
+// Largest power-of-two size the array holds for `op`.
+static size_t MaxSize(size_t bytes, int op) {
+  size_t room = op == kOpCopy ? bytes / 2 : bytes;
+  size_t size = MIN_SIZE;
+  while (size * 2 + LAYOUT_SLACK <= room) size *= 2;
+  return size;
+}
+
+static void PrintCrossovers(const size_t *sizes, const int *best,
+                            size_t count) {
+  BenchLog("  Best by size:");
+  size_t start = 0;
+  for (size_t i = 1; i <= count; i++) {
+    if (i < count && best[i] == best[start]) continue;
+    char from[32], to[32];
+    FormatBytes(sizes[start], from, sizeof(from));
+    FormatBytes(sizes[i - 1], to, sizeof(to));
+    if (start == i - 1) {
+      BenchLog("%s %s %s", start ? " |" : "", from,
+               kMethodNames[best[start]]);
+    } else {
+      BenchLog("%s %s-%s %s", start ? " |" : "", from, to,
+               kMethodNames[best[start]]);
+    }
+    start = i;
+  }
+  BenchLog("\n");
+}
+
+static int ScanPoint(uint64_t *array, size_t n, const TrialConfig *trials,
+                     int op, int64_t misalign, int text) {
+  int methods[WRITE_NUM_METHODS];
+  size_t num_methods = 0;
+  for (int m = 0; m < WRITE_NUM_METHODS; m++) {
+    if (WriteMethodSupported(m)) methods[num_methods++] = m;
+  }
+
+  BenchLog("\n=== Write path: %s, destination +%lld bytes (GB/s) ===\n",
+           kOpNames[op], (long long)misalign);
+  BenchLog("  %9s", "size");
+  for (size_t m = 0; m < num_methods; m++) {
+    BenchLog(" %7s", kMethodNames[methods[m]]);
+  }
+  BenchLog("  best\n");
+
+  size_t sizes[MAX_SIZES];
+  int best[MAX_SIZES];
+  size_t count = 0;
+  size_t max = MaxSize(n * sizeof(uint64_t), op);
+  for (size_t size = MIN_SIZE; size <= max && count < MAX_SIZES; size *= 2) {
+    char text_size[32];
+    BenchLog("  %9s", FormatBytes(size, text_size, sizeof(text_size)));
+    double gbps[WRITE_NUM_METHODS] = {0};
+    int winner = methods[0];
+    for (size_t m = 0; m < num_methods; m++) {
+      BenchCall call = {.param_func = BenchWrite,
+                        .params = {op, methods[m], (int64_t)size, misalign},
+                        .input = kStateScratch};
+      SetBenchLogQuiet(1);
+      BenchResult result = RunTrials(&call, array, n, trials);
+      SetBenchLogQuiet(0);
+      if (result.iterations == 0) return 0;
+      BenchLog(" %7.2f", result.gbps);
+      gbps[methods[m]] = result.gbps;
+      if (result.gbps > gbps[winner]) winner = methods[m];
+      if (!text) {
+        char params[96];
+        snprintf(params, sizeof(params), "op=%s,method=%s,size=%zu,"
+                 "misalign=%lld", kOpNames[op], kMethodNames[methods[m]],
+                 size, (long long)misalign);
+        ReportResult("writescan", params, n * sizeof(uint64_t), &result);
+      }
+    }
+    if (count && gbps[best[count - 1]] * TIE >= gbps[winner]) {
+      winner = best[count - 1];
+    }
+    best[count] = winner;
+    BenchLog("  %s\n", kMethodNames[winner]);
+    sizes[count++] = size;
+  }
+  PrintCrossovers(sizes, best, count);
+  return 1;
+}
+
+int RunWriteScan(const ParamGrid *grid, uint64_t *array, size_t n,
+                 const TrialConfig *trials) {
+  int text = ReportFormat() == kFormatText;
+  size_t points = ParamGridSize(grid);
+  for (size_t i = 0; i < points; i++) {
+    int64_t params[MAX_BENCH_PARAMS];
+    ParamGridPoint(grid, i, params);
+    if (!ScanPoint(array, n, trials, (int)params[0], params[1], text)) {
+      return 0;
+    }
+  }
+  return 1;
+}
@@ -0,0 +1,24 @@
+#ifndef HARNESS_WRITE_SCAN_H_
+#define HARNESS_WRITE_SCAN_H_
+
+#include "harness/params.h"
+#include "harness/runner.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Write-path scan: runs `write` with every store method this CPU supports
+// on power-of-two sizes from 64 bytes up to what the array holds, and
+// reports the fastest method by size class and the sizes where the winner
+// changes.
+
+// Grid of op (fill, copy) x destination misalignment. Defaults: both ops,
+// line-aligned and one byte off.
+int WriteScanGridInit(ParamGrid *grid);
+
+// Prints one GB/s table per grid point followed by its crossovers. Returns
+// 0 if a measurement failed.
+int RunWriteScan(const ParamGrid *grid, uint64_t *array, size_t n,
+                 const TrialConfig *trials);
+
+#endif
@@ -0,0 +1,260 @@
+#include "bench.h"
+#include "harness/parallel.h"
+#include "harness/rng.h"
+#include "harness/units.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// The array is a table of one-line nodes: slot 0 links to a random node,
+// slot 1 is the payload. A lookup hashes its key to a bucket node and
+// follows the links until it has touched `depth` nodes (bucket -> node ->
+// ... -> payload), so every lookup is a short chain of dependent misses
+// and different lookups are independent.
+#define NODE_SLOTS 8
+#define MAX_LOOKUPS ((size_t)1 << 20)
+#define MAX_BATCH 1024
+#define LOOKUP_STREAM 0x6c6f6f6b75700000ULL  // "lookup"
+// Nodes are linked in blocks with one random stream each, so the table
+// comes out the same however many workers build it.
+#define BUILD_BLOCK ((size_t)1 << 16)
+
+// Parameter values, in the order of the names registered in main.c.
+enum { kMethodNaive, kMethodGroup, kMethodPipeline, kMethodAmac };
+enum { kLengthsFixed, kLengthsVaried };
+
+static const char *const kMethodNames[] = {
+    "naive", "group prefetch", "software pipelining", "AMAC"};
+
+typedef struct {
+  const uint64_t *nodes;
+  size_t num_nodes;
+  size_t count;  // Lookups
+  size_t depth;  // Nodes per lookup (the most, if varied)
+  int varied;    // Lengths uniform in 1..depth instead of all `depth`
+  size_t batch;  // Lookups in flight
+  uint64_t seed;
+} Lookups;
+
+// One lookup in flight: the node it is about to read (already prefetched
+// by the pipelined methods) and how many links it still has to follow.
+typedef struct {
+  uint64_t node;
+  uint64_t left;
+} Cursor;
+
+typedef uint64_t (*LookupFunc)(const Lookups *lk);
+
+// SplitMix64 finalizer: key i's hash, computed rather than loaded so the
+// key stream adds no misses of its own.
+static inline uint64_t HashKey(uint64_t seed, size_t i) {
+  uint64_t z = seed + (i + 1) * 0x9e3779b97f4a7c15ULL;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+static inline Cursor StartLookup(const Lookups *lk, size_t i) {
+  uint64_t h = HashKey(lk->seed, i);
+  uint64_t length = lk->varied ? 1 + (h >> 40) % lk->depth : lk->depth;
+  return (Cursor){.node = (uint64_t)(((__uint128_t)h * lk->num_nodes) >> 64),
+                  .left = length - 1};
+}
+
+static inline const uint64_t *Node(const Lookups *lk, uint64_t node) {
+  return lk->nodes + node * NODE_SLOTS;
+}
+
+static inline void Prefetch(const Lookups *lk, uint64_t node) {
+  __builtin_prefetch(Node(lk, node), 0, 3);
+}
+
+// Reads the cursor's node: follows one link, or returns 1 once the node is
+// the payload.
+static inline int Step(const Lookups *lk, Cursor *c) {
+  if (c->left == 0) return 1;
+  c->node = Node(lk, c->node)[0];
+  c->left--;
+  return 0;
+}
+
+static uint64_t LookupNaive(const Lookups *lk) {
+  uint64_t sum = 0;
+  for (size_t i = 0; i < lk->count; i++) {
+    Cursor c = StartLookup(lk, i);
+    while (!Step(lk, &c)) {
+    }
+    sum += Node(lk, c.node)[1];
+  }
+  return sum;
+}
+
+// Group prefetching (Chen et al.): start a group of lookups and prefetch
+// their buckets, then advance the whole group one node per pass. With
+// varied lengths the group waits for its longest chain.
+static uint64_t LookupGroup(const Lookups *lk) {
+  Cursor group[MAX_BATCH];
+  uint64_t sum = 0;
+  for (size_t base = 0; base < lk->count; base += lk->batch) {
+    size_t size = lk->count - base < lk->batch ? lk->count - base : lk->batch;
+    for (size_t g = 0; g < size; g++) {
+      group[g] = StartLookup(lk, base + g);
+      Prefetch(lk, group[g].node);
+    }
+    for (size_t pass = 1; pass < lk->depth; pass++) {
+      for (size_t g = 0; g < size; g++) {
+        if (!Step(lk, &group[g])) Prefetch(lk, group[g].node);
+      }
+    }
+    for (size_t g = 0; g < size; g++) sum += Node(lk, group[g].node)[1];
+  }
+  return sum;
+}
+
+// Software pipelining: lookup i is in stage k at iteration i + k * dist,
+// so each iteration starts one lookup, advances `depth - 1` others one node
+// each and finishes one. dist = batch / depth keeps about `batch` lookups in
+// flight. Short chains idle through their remaining stages.
+static uint64_t LookupPipeline(const Lookups *lk) {
+  size_t dist = lk->batch / lk->depth ? lk->batch / lk->depth : 1;
+  size_t span = lk->depth * dist;
+  size_t slots = 1;
+  while (slots < span) slots *= 2;
+  Cursor *ring = malloc(slots * sizeof(Cursor));
+  if (!ring) return 0;
+  size_t mask = slots - 1;
+  uint64_t sum = 0;
+  for (size_t i = 0; i < lk->count + span; i++) {
+    if (i >= span) sum += Node(lk, ring[(i - span) & mask].node)[1];
+    for (size_t k = lk->depth - 1; k > 0; k--) {
+      size_t j = i - k * dist;
+      if (i >= k * dist && j < lk->count) {
+        Cursor *c = &ring[j & mask];
+        if (!Step(lk, c)) Prefetch(lk, c->node);
+      }
+    }
+    if (i < lk->count) {
+      ring[i & mask] = StartLookup(lk, i);
+      Prefetch(lk, ring[i & mask].node);
+    }
+  }
+  free(ring);
+  return sum;
+}
+
+// Asynchronous memory access chaining (Kocberber et al.): `batch` lookups
+// run as independent state machines, visited round-robin. A visit reads
+// the node prefetched on the previous visit and either prefetches the next
+// one or, at the payload, retires the lookup and starts a new one in its
+// slot, so no slot ever waits for a slower neighbour.
+static uint64_t LookupAmac(const Lookups *lk) {
+  Cursor slots[MAX_BATCH];
+  size_t width = lk->batch < lk->count ? lk->batch : lk->count;
+  size_t next = 0;
+  for (; next < width; next++) {
+    slots[next] = StartLookup(lk, next);
+    Prefetch(lk, slots[next].node);
+  }
+  uint64_t sum = 0;
+  size_t active = width;
+  while (active > 0) {
+    for (size_t s = 0; s < width; s++) {
+      Cursor *c = &slots[s];
+      if (c->node == UINT64_MAX) continue;
+      if (!Step(lk, c)) {
+        Prefetch(lk, c->node);
+        continue;
+      }
+      sum += Node(lk, c->node)[1];
+      if (next < lk->count) {
+        *c = StartLookup(lk, next++);
+        Prefetch(lk, c->node);
+      } else {
+        c->node = UINT64_MAX;
+        active--;
+      }
+    }
+  }
+  return sum;
+}
+
+static const LookupFunc kLookups[] = {
+    [kMethodNaive] = LookupNaive,
+    [kMethodGroup] = LookupGroup,
+    [kMethodPipeline] = LookupPipeline,
+    [kMethodAmac] = LookupAmac,
+};
+
+typedef struct {
+  uint64_t *array;
+  size_t num_nodes;
+  uint64_t seed;
+} Build;
+
+// Links every node of blocks [begin, end) to a random one and stores its
+// own index as payload.
+static void BuildBlocks(size_t begin, size_t end, void *ctx) {
+  const Build *b = ctx;
+  for (size_t block = begin; block < end; block++) {
+    Rng rng;
+    RngSeed(&rng, b->seed, LOOKUP_STREAM + block);
+    size_t lo = block * BUILD_BLOCK;
+    size_t hi = lo + BUILD_BLOCK < b->num_nodes ? lo + BUILD_BLOCK
+                                                : b->num_nodes;
+    for (size_t i = lo; i < hi; i++) {
+      b->array[i * NODE_SLOTS] = RngBounded(&rng, b->num_nodes);
+      b->array[i * NODE_SLOTS + 1] = i;
+    }
+  }
+}
+
+static void BuildNodes(uint64_t *array, size_t num_nodes, uint64_t seed) {
+  Build b = {.array = array, .num_nodes = num_nodes, .seed = seed};
+  ParallelForEach((num_nodes + BUILD_BLOCK - 1) / BUILD_BLOCK, BuildBlocks,
+                  &b);
+}
+
+static BenchResult RunLookup(uint64_t *array, size_t n, int method,
+                             size_t batch, size_t depth, int varied) {
+  BenchResult error = {0};
+  Lookups lk = {.nodes = array, .num_nodes = n / NODE_SLOTS,
+                .depth = depth, .varied = varied, .batch = batch,
+                .seed = BenchSeed()};
+  if (lk.num_nodes < 2) {
+    fprintf(stderr, "Lookup: array too small\n");
+    return error;
+  }
+  lk.count = lk.num_nodes < MAX_LOOKUPS ? lk.num_nodes : MAX_LOOKUPS;
+  BuildNodes(array, lk.num_nodes, lk.seed);
+
+  BenchTimer timer;
+  TimerStart(&timer);
+  uint64_t sum = kLookups[method](&lk);
+  uint64_t ns = TimerStop(&timer);
+  Escape(&sum);
+
+  // The naive walk is the reference every method must match.
+  uint64_t expected = method == kMethodNaive ? sum : LookupNaive(&lk);
+
+  char table[32];
+  BenchLog("  %s, %zu in flight, %s%zu nodes per lookup, %s table\n",
+           kMethodNames[method], method == kMethodNaive ? (size_t)1 : batch,
+           varied ? "1.." : "", depth,
+           FormatBytes(lk.num_nodes * NODE_SLOTS * sizeof(uint64_t), table,
+                       sizeof(table)));
+  BenchLog("  Lookups: %.1f M/s\n", lk.count * 1e3 / (double)ns);
+  if (sum != expected) {
+    fprintf(stderr, "Lookup: %s disagrees with the naive walk\n",
+            kMethodNames[method]);
+    return error;
+  }
+
+  return (BenchResult){.name = "Lookup", .iterations = lk.count,
+                       .total_ns = ns, .ns_per_access = (double)ns / lk.count};
+}
+
+BenchResult BenchLookup(uint64_t *array, size_t n, const int64_t *params) {
+  return RunLookup(array, n, (int)params[0], (size_t)params[1],
+                   (size_t)params[2], params[3] == kLengthsVaried);
+}
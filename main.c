@@ -1,52 +1,221 @@
 #include "bench.h"
+#include "harness/alloc.h"
+#include "harness/array_state.h"
+#include "harness/assoc_scan.h"
+#include "harness/c2c_matrix.h"
+#include "harness/compare.h"
+#include "harness/cpu_isa.h"
+#include "harness/loaded_latency.h"
+#include "harness/mlp_search.h"
+#include "harness/numa.h"
+#include "harness/numa_matrix.h"
+#include "harness/parallel.h"
+#include "harness/params.h"
+#include "harness/perf_counters.h"
+#include "harness/pool.h"
+#include "harness/prefetch_tuner.h"
+#include "harness/report.h"
+#include "harness/rng.h"
+#include "harness/runner.h"
+#include "harness/sweep.h"
+#include "harness/tlb_reach.h"
+#include "harness/units.h"
+#include "harness/write_scan.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 static const BenchEntry kBenchmarks[] = {
-    {"seq", "Sequential access", BenchSequential},
-    {"ran", "Random access (parallel loads)", BenchRandom},
-    {"chase", "Pointer chasing (serial loads)", BenchPointerChase},
-    {"red_naive", "Reduction naive (1 accumulator)", BenchReductionNaive},
-    {"red_ilp", "Reduction ILP (8 accumulators)", BenchReductionILP},
-    {"red_simd", "Reduction SIMD (AVX2/SSE2)", BenchReductionSimd},
-    {"red_thread", "Reduction threaded (8 threads)", BenchReductionThread},
-    {"red_ilp_simd", "Reduction ILP+SIMD combined", BenchReductionILPSimd},
-    {"red_all", "Reduction all (threads+ILP+SIMD)", BenchReductionAll},
-    {"red_opt", "Reduction optimized (compiler free)", BenchReductionOpt},
-    {"mlp1", "Chase 1 chain (MLP=1)", BenchChase1},
-    {"mlp2", "Chase 2 chains (MLP=2)", BenchChase2},
-    {"mlp4", "Chase 4 chains (MLP=4)", BenchChase4},
-    {"mlp8", "Chase 8 chains (MLP=8)", BenchChase8},
-    {"mlp16", "Chase 16 chains (MLP=16)", BenchChase16},
-    {"pf_none", "Random no prefetch", BenchPrefetchNone},
-    {"pf_8", "Random prefetch +8", BenchPrefetch8},
-    {"pf_32", "Random prefetch +32", BenchPrefetch32},
-    {"pf_128", "Random prefetch +128", BenchPrefetch128},
-    {"pf_seq", "Sequential no sw prefetch", BenchSeqPrefetchNone},
-    {"pf_seq64", "Sequential sw prefetch +64", BenchSeqPrefetch64},
-    {"fs_bad", "False sharing (packed)", BenchFalseSharing},
-    {"fs_good", "No false sharing (padded)", BenchNoFalseSharing},
-    {"tlb_seq", "Stride 8B (sequential)", BenchTlbSeq},
-    {"tlb_64", "Stride 64B (cache line)", BenchTlb64},
-    {"tlb_512", "Stride 512B", BenchTlb512},
-    {"tlb_4k", "Stride 4KB (1 per page)", BenchTlbPage},
-    {"tlb_8k", "Stride 8KB (skip pages)", BenchTlb2Page},
-    {"br_sort", "Branch sorted (predictable)", BenchBranchSorted},
-    {"br_rand", "Branch random (unpredictable)", BenchBranchRandom},
-    {"br_less", "Branchless (mask)", BenchBranchless},
-    {"bw_1", "Bandwidth 1 thread", BenchBw1},
-    {"bw_2", "Bandwidth 2 threads", BenchBw2},
-    {"bw_4", "Bandwidth 4 threads", BenchBw4},
-    {"bw_8", "Bandwidth 8 threads", BenchBw8},
-    {"sf_fwd", "Store-load aligned (forwarding)", BenchStoreFwdSame},
-    {"sf_stall", "Store-load overlap (stall)", BenchStoreFwdDiff},
-    {"sf_indep", "Store-load independent (no dep)", BenchStoreFwdNone},
+    {"seq", "Sequential access", BenchSequential, kStateIdentity},
+    {"ran", "Random access (parallel loads)", BenchRandom, kStateAny},
+    {"chase", "Pointer chasing (serial loads)", BenchPointerChase,
+     kStateRandomCycle},
+    {"chase_line", "Pointer chase, 1 node per cache line", BenchChaseLine,
+     kStateLineCycle},
+    {"chase_page", "Pointer chase, 1 node per 4K page", BenchChasePage,
+     kStatePageCycle},
+    {"chase_inpage", "Pointer chase, all lines of a page in turn",
+     BenchChaseInPage, kStateInPageCycle},
+    {"red_naive", "Reduction naive (1 accumulator)", BenchReductionNaive,
+     kStateIdentity},
+    {"red_ilp", "Reduction ILP (8 accumulators)", BenchReductionILP,
+     kStateIdentity},
+    {"red_simd", "Reduction SIMD (SSE2/AVX2/AVX-512)", BenchReductionSimd,
+     kStateIdentity},
+    {"red_thread", "Reduction threaded (1 thread per CPU)",
+     BenchReductionThread, kStateIdentity},
+    {"red_ilp_simd", "Reduction ILP+SIMD combined", BenchReductionILPSimd,
+     kStateIdentity},
+    {"red_all", "Reduction all (threads+ILP+SIMD)", BenchReductionAll,
+     kStateIdentity},
+    {"red_opt", "Reduction optimized (compiler free)", BenchReductionOpt,
+     kStateIdentity},
+    {"mlp1", "Chase 1 chain (MLP=1)", BenchChase1, kStateRandomCycle},
+    {"mlp2", "Chase 2 chains (MLP=2)", BenchChase2, kStateRandomCycle},
+    {"mlp4", "Chase 4 chains (MLP=4)", BenchChase4, kStateRandomCycle},
+    {"mlp8", "Chase 8 chains (MLP=8)", BenchChase8, kStateRandomCycle},
+    {"mlp16", "Chase 16 chains (MLP=16)", BenchChase16, kStateRandomCycle},
+    {"pf_none", "Random no prefetch", BenchPrefetchNone, kStateAny},
+    {"pf_8", "Random prefetch +8", BenchPrefetch8, kStateAny},
+    {"pf_32", "Random prefetch +32", BenchPrefetch32, kStateAny},
+    {"pf_128", "Random prefetch +128", BenchPrefetch128, kStateAny},
+    {"pf_seq", "Sequential no sw prefetch", BenchSeqPrefetchNone, kStateAny},
+    {"pf_seq64", "Sequential sw prefetch +64", BenchSeqPrefetch64, kStateAny},
+    {"fs_bad", "False sharing (packed)", BenchFalseSharing, kStateAny},
+    {"fs_good", "No false sharing (padded)", BenchNoFalseSharing, kStateAny},
+    {"tlb_seq", "Stride 8B (sequential)", BenchTlbSeq, kStateAny},
+    {"tlb_64", "Stride 64B (cache line)", BenchTlb64, kStateAny},
+    {"tlb_512", "Stride 512B", BenchTlb512, kStateAny},
+    {"tlb_4k", "Stride 4KB (1 per page)", BenchTlbPage, kStateAny},
+    {"tlb_8k", "Stride 8KB (skip pages)", BenchTlb2Page, kStateAny},
+    {"br_sort", "Branch sorted (predictable)", BenchBranchSorted, kStateSorted},
+    {"br_rand", "Branch random (unpredictable)", BenchBranchRandom,
+     kStateRandomValues},
+    {"br_less", "Branchless (mask)", BenchBranchless, kStateRandomValues},
+    {"bw_1", "Bandwidth 1 thread", BenchBw1, kStateIdentity},
+    {"bw_2", "Bandwidth 2 threads", BenchBw2, kStateIdentity},
+    {"bw_4", "Bandwidth 4 threads", BenchBw4, kStateIdentity},
+    {"bw_8", "Bandwidth 8 threads", BenchBw8, kStateIdentity},
+    {"st_read", "STREAM read (sum)", BenchStreamRead, kStateScratch},
+    {"st_write", "STREAM write (fill)", BenchStreamWrite, kStateScratch},
+    {"st_copy", "STREAM copy", BenchStreamCopy, kStateScratch},
+    {"st_scale", "STREAM scale", BenchStreamScale, kStateScratch},
+    {"st_add", "STREAM add", BenchStreamAdd, kStateScratch},
+    {"st_triad", "STREAM triad", BenchStreamTriad, kStateScratch},
+    {"sf_fwd", "Store-load aligned (forwarding)", BenchStoreFwdSame,
+     kStateScratch},
+    {"sf_stall", "Store-load overlap (stall)", BenchStoreFwdDiff,
+     kStateScratch},
+    {"sf_indep", "Store-load independent (no dep)", BenchStoreFwdNone,
+     kStateScratch},
 };
 
 static const size_t kNumBenchmarks = sizeof(kBenchmarks) / sizeof(kBenchmarks[0]);
 
+static const char *const kStreamKernels[] = {"read", "write", "copy", "scale",
+                                             "add",  "triad", NULL};
+static const char *const kStreamIsas[] = {"auto", "scalar", "sse2", "avx2",
+                                          "avx512", NULL};
+static const char *const kStreamStores[] = {"cached", "nt", NULL};
+
+static const char *const kPfPatterns[] = {"random", "chase", "strided", NULL};
+static const char *const kPfOps[] = {"load", "update", NULL};
+static const char *const kPfHints[] = {"nta", "t2", "t1", "t0", NULL};
+static const char *const kPfIntents[] = {"read", "write", NULL};
+
+static const char *const kRedKernels[] = {"naive", "simd", NULL};
+static const char *const kSchedules[] = {"static", "dynamic", NULL};
+
+static const char *const kGatherMethods[] = {"scalar", "avx2", "avx512",
+                                             NULL};
+static const char *const kGatherPatterns[] = {"random", "clustered",
+                                              "sequential", NULL};
+
+static const char *const kLookupMethods[] = {"naive", "group", "pipeline",
+                                             "amac", NULL};
+static const char *const kLookupLengths[] = {"fixed", "varied", NULL};
+
+static const char *const kWriteOps[] = {"fill", "copy", NULL};
+static const char *const kWriteMethods[] = {"loop", "nt",   "rep",
+                                            "libc", "avx2", "avx512", NULL};
+
+static const char *const kAtomicOps[] = {"add",  "cas",   "xchg",
+                                         "load", "store", NULL};
+static const char *const kAtomicOrders[] = {"relaxed", "acqrel", "seqcst",
+                                            NULL};
+static const char *const kAtomicLayouts[] = {"shared", "padded", "sharded",
+                                             "node", NULL};
+
+static const char *const kReachLayouts[] = {"spread", "packed", NULL};
+
+static const ParamBenchEntry kParamBenchmarks[] = {
+    {"tlb", "Strided sweep", BenchTlbStride, kStateAny,
+     {{"stride", "bytes between accesses", 4096, 8, (int64_t)1 << 30, NULL}}},
+    {"tlb_reach", "Random chase, one line per page", BenchTlbReach,
+     kStateScratch,
+     {{"pages", "distinct pages", 64, 1, (int64_t)1 << 24, NULL},
+      {"page", "bytes per page", 4096, 64, (int64_t)1 << 30, NULL},
+      {"layout", "one line per page, or the lines packed", 0, 0, 1,
+       kReachLayouts}}},
+    {"pf", "Random access with software prefetch", BenchPrefetchDist,
+     kStateAny,
+     {{"dist", "prefetch distance in accesses", 32, 0, (int64_t)1 << 30, NULL}}},
+    {"pf_seq_dist", "Sequential access with software prefetch",
+     BenchSeqPrefetchDist, kStateAny,
+     {{"dist", "prefetch distance in elements", 64, 0, (int64_t)1 << 30, NULL}}},
+    {"pf_tune", "Software prefetch with every knob", BenchPrefetchTune,
+     kStateScratch,
+     {{"pattern", "access pattern", 0, 0, 2, kPfPatterns},
+      {"op", "what each access does", 0, 0, 1, kPfOps},
+      {"dist", "prefetch distance in accesses (0: none)", 32, 0,
+       (int64_t)1 << 24, NULL},
+      {"hint", "locality hint", 3, 0, 3, kPfHints},
+      {"intent", "prefetch for read or write", 0, 0, 1, kPfIntents},
+      {"lines", "prefetches per batch", 1, 1, 64, NULL},
+      {"stride", "bytes between strided accesses", 4096, 8,
+       (int64_t)1 << 30, NULL}}},
+    {"bw", "Read bandwidth", BenchBwThreads, kStateIdentity,
+     {{"threads", "reader threads", 4, 1, 1024, NULL}}},
+    {"mlp", "Interleaved pointer chase", BenchChaseChains, kStateRandomCycle,
+     {{"chains", "independent chains per thread", 4, 1, MAX_CHASE_CHAINS,
+       NULL},
+      {"threads", "chasing threads", 1, 1, 1024, NULL}}},
+    {"red_mt", "Threaded reduction", BenchReductionMt, kStateIdentity,
+     {{"kernel", "per-thread loop", 0, 0, 1, kRedKernels},
+      {"threads", "worker threads (0: one per CPU)", 0, 0, 1024, NULL},
+      {"schedule", "partitioning", 1, 0, 1, kSchedules},
+      {"chunk", "elements per dynamic chunk", 8192, 64, (int64_t)1 << 30,
+       NULL}}},
+    {"gather", "Indexed loads: scalar vs hardware gather", BenchGather,
+     kStateScratch,
+     {{"method", "load instructions", 0, 0, 2, kGatherMethods},
+      {"pattern", "index distribution", 0, 0, 2, kGatherPatterns},
+      {"span", "table bytes (0: half the array)", 0, 0, (int64_t)1 << 40,
+       NULL}}},
+    {"write", "Fill or copy with one store method", BenchWrite,
+     kStateScratch,
+     {{"op", "memset- or memcpy-like", 0, 0, 1, kWriteOps},
+      {"method", "how the bytes are stored", 3, 0, WRITE_NUM_METHODS - 1,
+       kWriteMethods},
+      {"size", "bytes per call", 4096, 1, (int64_t)1 << 40, NULL},
+      {"misalign", "destination bytes past a cache line", 0, 0, 63, NULL}}},
+    {"assoc", "Chase over addresses one stride apart (set conflicts)",
+     BenchAssoc, kStateScratch,
+     {{"ways", "addresses in the cycle", 8, 1, 1024, NULL},
+      {"stride", "bytes between addresses", 4096, 8, (int64_t)1 << 30,
+       NULL}}},
+    {"alias4k", "Copy with stores delta bytes past the loads mod 4 KiB",
+     BenchAlias4k, kStateScratch,
+     {{"delta",
+       "store offset from a 4 KiB multiple of the loads; a multiple of 8",
+       0, 0, 4095, NULL}}},
+    {"lookup", "Batched dependent lookups (bucket -> node -> payload)",
+     BenchLookup, kStateScratch,
+     {{"method", "how lookups overlap", 0, 0, 3, kLookupMethods},
+      {"batch", "lookups in flight", 16, 1, 1024, NULL},
+      {"depth", "dependent nodes per lookup", 3, 1, 16, NULL},
+      {"lengths", "every lookup depth nodes, or 1..depth", 0, 0, 1,
+       kLookupLengths}}},
+    {"atomic", "Atomic counter contention", BenchAtomics, kStateAny,
+     {{"op", "operation", 0, 0, 4, kAtomicOps},
+      {"order", "memory order", 2, 0, 2, kAtomicOrders},
+      {"layout", "counter placement", 0, 0, 3, kAtomicLayouts},
+      {"threads", "worker threads", 4, 1, 1024, NULL}}},
+    {"pingpong", "Cache line round trip between two CPUs", BenchPingPong,
+     kStateAny,
+     {{"cpu_a", "initiating CPU", 0, 0, MAX_CPUS - 1, NULL},
+      {"cpu_b", "answering CPU", 1, 0, MAX_CPUS - 1, NULL}}},
+    {"stream", "STREAM kernels", BenchStream, kStateScratch,
+     {{"kernel", "kernel", 5, 0, 5, kStreamKernels},
+      {"isa", "instruction set", 0, 0, 4, kStreamIsas},
+      {"stores", "store type", 0, 0, 1, kStreamStores},
+      {"threads", "worker threads", 1, 1, 1024, NULL}}},
+};
+
+static const size_t kNumParamBenchmarks =
+    sizeof(kParamBenchmarks) / sizeof(kParamBenchmarks[0]);
+
 static const BenchEntry *FindBenchmark(const char *name) {
   for (size_t i = 0; i < kNumBenchmarks; i++) {
     if (strcmp(name, kBenchmarks[i].cli_name) == 0) {
@@ -56,94 +225,580 @@ static const BenchEntry *FindBenchmark(const char *name) {
   return NULL;
 }
 
+static const ParamBenchEntry *FindParamBenchmark(const char *name) {
+  for (size_t i = 0; i < kNumParamBenchmarks; i++) {
+    if (strcmp(name, kParamBenchmarks[i].cli_name) == 0) {
+      return &kParamBenchmarks[i];
+    }
+  }
+  return NULL;
+}
+
 static void PrintUsage(const char *prog_name) {
-  fprintf(stderr, "Usage: %s <benchmark_type> [array_size_mb]\n", prog_name);
+  fprintf(stderr,
+          "Usage: %s [options] <benchmark_type> [param=values...] "
+          "[array_size]\n",
+          prog_name);
   fprintf(stderr, "\nBenchmark types:\n");
   fprintf(stderr, "  %-12s - %s\n", "all", "Run all benchmarks");
+  fprintf(stderr, "  %-12s - %s\n", "sweep",
+          "Latency vs working-set size, detects cache levels");
+  fprintf(stderr, "  %-12s - %s\n", "numa",
+          "Node x node latency and bandwidth matrix");
+  fprintf(stderr, "  %-12s - %s\n", "c2c",
+          "Core-to-core cache line round-trip matrix");
+  fprintf(stderr, "  %-12s - %s\n", "loaded",
+          "Chase latency vs injected bandwidth (injectors=, traffic=, "
+          "delay=)");
+  fprintf(stderr, "  %-12s - %s\n", "writescan",
+          "Fastest fill/copy method by size, and crossovers (op=, "
+          "misalign=)");
+  fprintf(stderr, "  %-12s - %s\n", "assocscan",
+          "Cache associativity and set span from set conflicts (stride=)");
+  fprintf(stderr, "  %-12s - %s\n", "tlbreach",
+          "L1 dTLB / STLB capacity and page-walk cost (page=)");
+  fprintf(stderr, "  %-12s - %s\n", "mlpsat",
+          "Chains per thread where chase throughput saturates (threads=)");
+  fprintf(stderr, "  %-12s - %s\n", "pftune",
+          "Best software prefetch settings per pattern and working set "
+          "(pattern=, op=, size=, stride=)");
   for (size_t i = 0; i < kNumBenchmarks; i++) {
     fprintf(stderr, "  %-12s - %s\n", kBenchmarks[i].cli_name,
             kBenchmarks[i].description);
   }
+  fprintf(stderr, "\nParameterized benchmarks:\n");
+  for (size_t i = 0; i < kNumParamBenchmarks; i++) {
+    const ParamBenchEntry *e = &kParamBenchmarks[i];
+    fprintf(stderr, "  %-12s - %s\n", e->cli_name, e->description);
+    for (size_t p = 0; p < MAX_BENCH_PARAMS && e->params[p].name; p++) {
+      const BenchParam *param = &e->params[p];
+      if (param->names) {
+        char def[32];
+        fprintf(stderr, "      %s=%s  %s [", param->name,
+                FormatParamValue(param, param->def, def, sizeof(def)),
+                param->help);
+        for (size_t v = 0; param->names[v]; v++) {
+          fprintf(stderr, "%s%s", v ? "|" : "", param->names[v]);
+        }
+        fprintf(stderr, "]\n");
+        continue;
+      }
+      fprintf(stderr, "      %s=%lld  %s [%lld..%lld]\n", param->name,
+              (long long)param->def, param->help, (long long)param->min,
+              (long long)param->max);
+    }
+  }
+  fprintf(stderr, "  Values: 4096 | 4K,16K | 1..64 | 1..64:8 | 1..1024*2 "
+                  "(cartesian product over parameters)\n");
   fprintf(stderr, "\nOptional:\n");
-  fprintf(stderr, "  array_size_mb - Size of array in MB (default: 128)\n");
+  fprintf(stderr, "  array_size - Array size, e.g. 256 (MB), 64K, 8G "
+                  "(default: 128M; sweep: largest working set, 512M)\n");
+  fprintf(stderr, "\nOptions:\n");
+  fprintf(stderr, "  --warmup=N      Untimed passes per benchmark (default: 1)\n");
+  fprintf(stderr, "  --trials=N      Minimum timed trials (default: 3)\n");
+  fprintf(stderr, "  --max-trials=N  Maximum timed trials (default: 30)\n");
+  fprintf(stderr, "  --ci=PCT        Stop once the 95%% CI is within +/-PCT%% "
+                  "of the mean (default: 1)\n");
+  fprintf(stderr, "  --budget=SEC    Stop adding trials after SEC seconds "
+                  "(default: 10)\n");
+  fprintf(stderr, "  --format=FMT    Report format: text, json or csv "
+                  "(default: text)\n");
+  fprintf(stderr, "  --compare=FILE  Compare against a --format=json baseline;"
+                  " exit 2 on regressions\n");
+  fprintf(stderr, "  --threshold=PCT Slowdown that counts as a regression "
+                  "(default: 5)\n");
+  fprintf(stderr, "  --no-counters   Do not sample hardware performance "
+                  "counters\n");
+  fprintf(stderr, "  --sweep-min=SIZE    Smallest sweep working set "
+                  "(default: 4K)\n");
+  fprintf(stderr, "  --sweep-points=N    Sweep sizes per doubling "
+                  "(default: 4)\n");
+  fprintf(stderr, "  --sweep-bench=LIST  Comma-separated benchmarks to sweep "
+                  "(default: chase)\n");
+  fprintf(stderr, "  --pages=POLICY  Array pages: default, 4k, thp, 2m or 1g "
+                  "(default: default)\n");
+  fprintf(stderr, "  --mem-node=N    Bind the array and all benchmark memory "
+                  "to NUMA node N\n");
+  fprintf(stderr, "  --state-cache=SIZE  Memory for cached benchmark inputs "
+                  "(0 disables, default: half of available)\n");
+  fprintf(stderr, "  --seed=N        Seed for shuffles, cycles and random data "
+                  "(default: 42)\n");
+  fprintf(stderr, "  --isa=ISA       Vector kernels: scalar, sse2, avx2 or "
+                  "avx512 (default: widest the CPU supports)\n");
+  fprintf(stderr, "  --cpus=LIST     Pin the main thread to the first CPU and "
+                  "workers round-robin, e.g. 0-3,8\n");
   fprintf(stderr, "\nExample: %s seq 256\n", prog_name);
   fprintf(stderr, "         %s all 64\n", prog_name);
+  fprintf(stderr, "         %s --trials=10 --ci=0.5 chase 1024\n", prog_name);
+  fprintf(stderr, "         %s --format=json all 256 > baseline.json\n",
+          prog_name);
+  fprintf(stderr, "         %s --compare baseline.json all 256\n", prog_name);
+  fprintf(stderr, "         %s --sweep-bench=chase,ran sweep 16G\n", prog_name);
+  fprintf(stderr, "         %s --isa=sse2 red_simd 256\n", prog_name);
+  fprintf(stderr,
+          "         %s red_mt schedule=static,dynamic threads=1..128*2 1G\n",
+          prog_name);
+  fprintf(stderr, "         %s tlb stride=4096,16384 1G\n", prog_name);
+  fprintf(stderr, "         %s bw threads=1..64*2 4G\n", prog_name);
+  fprintf(stderr, "         %s --pages=2m tlb stride=4096 1G\n", prog_name);
+  fprintf(stderr, "         %s --pages=4k tlbreach 4G\n", prog_name);
+  fprintf(stderr, "         %s --pages=2m assocscan 2G\n", prog_name);
+  fprintf(stderr, "         %s writescan op=copy misalign=0,1,33 4G\n",
+          prog_name);
+  fprintf(stderr, "         %s --cpus=0 --mem-node=1 chase 1G\n", prog_name);
+  fprintf(stderr, "         %s numa 1G\n", prog_name);
+  fprintf(stderr, "         %s --cpus=0-15 c2c\n", prog_name);
+  fprintf(stderr, "         %s --cpus=0-15 mlpsat threads=1,8,16 1G\n",
+          prog_name);
+  fprintf(stderr, "         %s pftune pattern=chase op=load,update 1G\n",
+          prog_name);
+  fprintf(stderr, "         %s --cpus=0-7 loaded traffic=read,write 2G\n",
+          prog_name);
+}
+
+typedef struct {
+  TrialConfig trials;
+  OutputFormat format;
+  const char *compare_path;
+  double threshold;
+  int counters;
+  SweepConfig sweep;
+  const char *sweep_benches;
+  PagePolicy pages;
+  int mem_node;      // -1: first-touch placement
+  const char *cpus;  // NULL: threads are not pinned
+} Options;
+
+// Matches "--name=value" or "--name value" (consuming the next argument).
+// Returns the value, or NULL if argv[*i] is a different option.
+static const char *OptionValue(int argc, char **argv, int *i,
+                               const char *name) {
+  size_t len = strlen(name);
+  const char *arg = argv[*i];
+  if (strncmp(arg, name, len) != 0) return NULL;
+  if (arg[len] == '=') return arg + len + 1;
+  if (arg[len] == '\0' && *i + 1 < argc) return argv[++*i];
+  return NULL;
 }
 
-static void PrintResult(const BenchResult *result) {
-  printf("\n=== %s ===\n", result->name);
-  printf("Iterations:     %zu\n", result->iterations);
-  printf("Total time:     %.2f ms\n", result->total_ns / 1e6);
-  printf("Time per access: %.2f ns\n", result->ns_per_access);
-  printf("\n");
+static int ParseSize(const char *value, size_t *out) {
+  char *end;
+  long long v = strtoll(value, &end, 10);
+  if (*end != '\0' || v < 0) return 0;
+  *out = (size_t)v;
+  return 1;
 }
 
-static int RunAllBenchmarks(uint64_t *array, size_t n) {
-  printf("\n========================================\n");
-  printf("Running all %zu benchmarks...\n", kNumBenchmarks);
-  printf("========================================\n");
+static int ParseDouble(const char *value, double *out) {
+  char *end;
+  double v = strtod(value, &end);
+  if (*end != '\0' || v < 0) return 0;
+  *out = v;
+  return 1;
+}
 
+// Returns 1 if argv[*i] was a valid option, 0 otherwise.
+static int ParseOption(int argc, char **argv, int *i, Options *opts) {
+  const char *v;
+  double pct;
+  if ((v = OptionValue(argc, argv, i, "--warmup")))
+    return ParseSize(v, &opts->trials.warmup);
+  if ((v = OptionValue(argc, argv, i, "--trials")))
+    return ParseSize(v, &opts->trials.min_trials);
+  if ((v = OptionValue(argc, argv, i, "--max-trials")))
+    return ParseSize(v, &opts->trials.max_trials);
+  if ((v = OptionValue(argc, argv, i, "--budget")))
+    return ParseDouble(v, &opts->trials.budget_sec);
+  if ((v = OptionValue(argc, argv, i, "--ci"))) {
+    if (!ParseDouble(v, &pct)) return 0;
+    opts->trials.ci_target = pct / 100.0;
+    return 1;
+  }
+  if ((v = OptionValue(argc, argv, i, "--format")))
+    return ParseOutputFormat(v, &opts->format);
+  if ((v = OptionValue(argc, argv, i, "--compare"))) {
+    opts->compare_path = v;
+    return 1;
+  }
+  if ((v = OptionValue(argc, argv, i, "--threshold"))) {
+    if (!ParseDouble(v, &pct)) return 0;
+    opts->threshold = pct / 100.0;
+    return 1;
+  }
+  if ((v = OptionValue(argc, argv, i, "--sweep-min")))
+    return ParseByteSize(v, 1, &opts->sweep.min_bytes);
+  if ((v = OptionValue(argc, argv, i, "--sweep-points")))
+    return ParseSize(v, &opts->sweep.points_per_octave);
+  if ((v = OptionValue(argc, argv, i, "--sweep-bench"))) {
+    opts->sweep_benches = v;
+    return 1;
+  }
+  if ((v = OptionValue(argc, argv, i, "--pages")))
+    return ParsePagePolicy(v, &opts->pages);
+  if ((v = OptionValue(argc, argv, i, "--mem-node"))) {
+    size_t node;
+    if (!ParseSize(v, &node) || node >= MAX_NUMA_NODES) return 0;
+    opts->mem_node = (int)node;
+    return 1;
+  }
+  if ((v = OptionValue(argc, argv, i, "--state-cache"))) {
+    size_t budget = 0;
+    if (strcmp(v, "0") != 0 && !ParseByteSize(v, 1, &budget)) return 0;
+    SetStateCacheBudget(budget);
+    return 1;
+  }
+  if ((v = OptionValue(argc, argv, i, "--seed"))) {
+    size_t seed;
+    if (!ParseSize(v, &seed)) return 0;
+    SetBenchSeed(seed);
+    return 1;
+  }
+  if ((v = OptionValue(argc, argv, i, "--isa"))) {
+    Isa isa;
+    if (!ParseIsa(v, &isa)) return 0;
+    if (!SetActiveIsa(isa)) {
+      fprintf(stderr, "This CPU cannot run %s kernels\n", v);
+      return 0;
+    }
+    return 1;
+  }
+  if ((v = OptionValue(argc, argv, i, "--cpus"))) {
+    opts->cpus = v;
+    return 1;
+  }
+  if (strcmp(argv[*i], "--no-counters") == 0) {
+    opts->counters = 0;
+    return 1;
+  }
+  return 0;
+}
+
+// Returns 0 if any benchmark failed; the others still run.
+static int RunAllBenchmarks(uint64_t *array, size_t n, const TrialConfig *cfg) {
+  BenchLog("\n========================================\n");
+  BenchLog("Running all %zu benchmarks...\n", kNumBenchmarks);
+  BenchLog("========================================\n");
+
+  int ok = 1;
   for (size_t i = 0; i < kNumBenchmarks; i++) {
-    BenchResult result = kBenchmarks[i].func(array, n);
-    PrintResult(&result);
+    BenchCall call = {.func = kBenchmarks[i].func,
+                      .input = kBenchmarks[i].input};
+    BenchResult result = RunTrials(&call, array, n, cfg);
+    if (result.iterations == 0) {
+      fprintf(stderr, "Error: %s failed\n", kBenchmarks[i].cli_name);
+      ok = 0;
+      continue;
+    }
+    ReportResult(kBenchmarks[i].cli_name, "", n * sizeof(uint64_t), &result);
   }
 
-  printf("========================================\n");
-  printf("All benchmarks complete.\n");
-  printf("========================================\n");
-  return 0;
+  BenchLog("========================================\n");
+  BenchLog("All benchmarks complete.\n");
+  BenchLog("========================================\n");
+  return ok;
+}
+
+// Runs every point of the parameter grid. Returns 0 if any point failed;
+// the others still run.
+static int RunParamGrid(const ParamGrid *grid, uint64_t *array, size_t n,
+                        const TrialConfig *cfg) {
+  size_t points = ParamGridSize(grid);
+  BenchCall call = {.param_func = grid->entry->func,
+                    .input = grid->entry->input};
+  char params[128];
+  int ok = 1;
+  for (size_t i = 0; i < points; i++) {
+    ParamGridPoint(grid, i, call.params);
+    FormatParams(grid->entry, call.params, params, sizeof(params));
+    BenchResult result = RunTrials(&call, array, n, cfg);
+    if (result.iterations == 0) {
+      fprintf(stderr, "Error: %s (%s) failed\n", grid->entry->cli_name,
+              params);
+      ok = 0;
+      continue;
+    }
+    ReportResult(grid->entry->cli_name, params, n * sizeof(uint64_t), &result);
+  }
+  return ok;
+}
+
+// Validates (array == NULL) or runs the comma-separated --sweep-bench list.
+static int RunSweeps(const Options *opts, uint64_t *array) {
+  char names[256];
+  snprintf(names, sizeof(names), "%s", opts->sweep_benches);
+  for (char *save, *name = strtok_r(names, ",", &save); name;
+       name = strtok_r(NULL, ",", &save)) {
+    const BenchEntry *bench = FindBenchmark(name);
+    const ParamBenchEntry *param_bench = FindParamBenchmark(name);
+    if (!bench && !param_bench) {
+      fprintf(stderr, "Error: Unknown sweep benchmark '%s'\n", name);
+      return 0;
+    }
+    // Parameterized benchmarks are swept at their default parameters.
+    BenchCall call = {0};
+    if (bench) {
+      call.func = bench->func;
+      call.input = bench->input;
+    } else {
+      call.param_func = param_bench->func;
+      call.input = param_bench->input;
+      for (size_t p = 0; p < MAX_BENCH_PARAMS; p++) {
+        call.params[p] = param_bench->params[p].def;
+      }
+    }
+    if (array && !RunSweep(name, &call, array, &opts->sweep, &opts->trials)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+// Applies --cpus and --mem-node before anything is allocated or spawned.
+static int SetupPlacement(const Options *opts) {
+  SaveLaunchAffinity();
+  if (opts->cpus) {
+    int cpus[MAX_CPUS];
+    int count = ParseCpuList(opts->cpus, cpus, MAX_CPUS);
+    if (count <= 0) {
+      fprintf(stderr, "Error: Bad CPU list '%s'\n", opts->cpus);
+      return 0;
+    }
+    if (!PinCurrentThread(cpus[0])) {
+      fprintf(stderr, "Error: Cannot run on CPU %d\n", cpus[0]);
+      return 0;
+    }
+    SetWorkerCpus(cpus, count);
+  }
+  if (opts->mem_node >= 0) {
+    if (opts->mem_node >= NumaNodeCount() ||
+        !NumaNodeHasMemory(opts->mem_node)) {
+      fprintf(stderr, "Error: NUMA node %d has no memory (%d node(s))\n",
+              opts->mem_node, NumaNodeCount());
+      return 0;
+    }
+    if (!NumaSetThreadPolicy(opts->mem_node)) return 0;
+  }
+  return 1;
+}
+
+// Exit status: 0, or 2 if --compare found regressions (1 on errors).
+static int CompareResults(const Options *opts) {
+  if (!opts->compare_path) return 0;
+  int regressions = CompareWithBaseline(opts->compare_path, opts->threshold);
+  if (regressions < 0) return 1;
+  return regressions > 0 ? 2 : 0;
 }
 
 int main(int argc, char **argv) {
-  if (argc < 2) {
+  Options opts = {
+      .trials = TRIAL_CONFIG_DEFAULT,
+      .format = kFormatText,
+      .compare_path = NULL,
+      .threshold = 0.05,
+      .counters = 1,
+      .sweep = SWEEP_CONFIG_DEFAULT,
+      .sweep_benches = "chase",
+      .pages = kPagesDefault,
+      .mem_node = -1,
+      .cpus = NULL,
+  };
+  const char *positional[2] = {NULL, NULL};
+  int num_positional = 0;
+  const char *assignments[MAX_BENCH_PARAMS * 2];
+  int num_assignments = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (strncmp(argv[i], "--", 2) == 0) {
+      if (!ParseOption(argc, argv, &i, &opts)) {
+        fprintf(stderr, "Error: Bad option '%s'\n", argv[i]);
+        PrintUsage(argv[0]);
+        return 1;
+      }
+    } else if (strchr(argv[i], '=') && num_positional == 1) {
+      if (num_assignments == MAX_BENCH_PARAMS * 2) {
+        fprintf(stderr, "Error: Too many parameter assignments\n");
+        return 1;
+      }
+      assignments[num_assignments++] = argv[i];
+    } else if (num_positional < 2) {
+      positional[num_positional++] = argv[i];
+    } else {
+      fprintf(stderr, "Error: Unexpected argument '%s'\n", argv[i]);
+      PrintUsage(argv[0]);
+      return 1;
+    }
+  }
+
+  if (num_positional < 1) {
     PrintUsage(argv[0]);
     return 1;
   }
+  TrialConfig *cfg = &opts.trials;
+  if (cfg->max_trials < cfg->min_trials) cfg->max_trials = cfg->min_trials;
 
-  const char *bench_type = argv[1];
-  size_t size_mb = 128;
+  const char *bench_type = positional[0];
+  int run_all = (strcmp(bench_type, "all") == 0);
+  int run_sweep = (strcmp(bench_type, "sweep") == 0);
+  int run_numa = (strcmp(bench_type, "numa") == 0);
+  int run_loaded = (strcmp(bench_type, "loaded") == 0);
+  int run_pftune = (strcmp(bench_type, "pftune") == 0);
+  int run_mlpsat = (strcmp(bench_type, "mlpsat") == 0);
+  int run_tlbreach = (strcmp(bench_type, "tlbreach") == 0);
+  int run_assocscan = (strcmp(bench_type, "assocscan") == 0);
+  int run_writescan = (strcmp(bench_type, "writescan") == 0);
+  int run_c2c = (strcmp(bench_type, "c2c") == 0);
+  size_t bytes = run_sweep ? opts.sweep.max_bytes : (size_t)128 << 20;
 
-  if (argc >= 3) {
-    size_mb = atoi(argv[2]);
-    if (size_mb == 0 || size_mb > 4096) {
-      fprintf(stderr, "Error: Array size must be between 1 and 4096 MB\n");
+  if (num_positional >= 2) {
+    // Plain numbers are megabytes, as before.
+    if (!ParseByteSize(positional[1], (size_t)1 << 20, &bytes) ||
+        bytes < 64) {
+      fprintf(stderr, "Error: Bad array size '%s'\n", positional[1]);
       return 1;
     }
   }
 
-  int run_all = (strcmp(bench_type, "all") == 0);
+  if (run_sweep) {
+    opts.sweep.max_bytes = bytes;
+    if (opts.sweep.min_bytes > bytes) opts.sweep.min_bytes = bytes;
+    if (!RunSweeps(&opts, NULL)) return 1;
+  }
 
-  if (!run_all) {
-    const BenchEntry *bench = FindBenchmark(bench_type);
-    if (!bench) {
-      fprintf(stderr, "Error: Unknown benchmark type '%s'\n", bench_type);
-      PrintUsage(argv[0]);
+  const ParamBenchEntry *param_bench = FindParamBenchmark(bench_type);
+  ParamGrid grid = {0};
+  if (param_bench || run_loaded || run_pftune || run_mlpsat ||
+      run_tlbreach || run_assocscan || run_writescan) {
+    int ok = run_loaded      ? LoadedLatencyGridInit(&grid)
+             : run_pftune    ? PrefetchTunerGridInit(&grid, bytes)
+             : run_mlpsat    ? MlpSearchGridInit(&grid)
+             : run_tlbreach  ? TlbReachGridInit(&grid, opts.pages)
+             : run_assocscan ? AssocScanGridInit(&grid, bytes)
+             : run_writescan ? WriteScanGridInit(&grid)
+                             : ParamGridInit(&grid, param_bench);
+    if (!ok) {
+      fprintf(stderr, "Failed to allocate parameter grid\n");
       return 1;
     }
+    for (int a = 0; a < num_assignments; a++) {
+      if (!ParamGridSet(&grid, assignments[a])) return 1;
+    }
+  } else if (num_assignments > 0) {
+    fprintf(stderr, "Error: '%s' takes no parameters\n", bench_type);
+    return 1;
+  } else if (!run_all && !run_sweep && !run_numa &&
+             !run_c2c && !FindBenchmark(bench_type)) {
+    fprintf(stderr, "Error: Unknown benchmark type '%s'\n", bench_type);
+    PrintUsage(argv[0]);
+    return 1;
+  }
+  if (run_numa && (opts.mem_node >= 0 || opts.cpus)) {
+    fprintf(stderr, "Error: numa places memory and threads itself; drop "
+                    "--mem-node/--cpus\n");
+    return 1;
+  }
+  if (!SetupPlacement(&opts)) return 1;
+
+  size_t n = bytes / sizeof(uint64_t);
+  char size_text[32];
+  FormatBytes(n * sizeof(uint64_t), size_text, sizeof(size_text));
+  ReportBegin(opts.format);
+  if (opts.counters) PerfCountersOpen();
+
+  if (run_c2c) {
+    RunInfo run = {.trials = cfg, .page_policy = PagePolicyName(opts.pages)};
+    ReportHeader(&run);
+    int ok = RunCoreToCoreMatrix(cfg);
+    ReportEnd();
+    PoolShutdown();
+    PerfCountersClose();
+    return ok ? CompareResults(&opts) : 1;
+  }
+
+  if (run_numa) {
+    RunInfo run = {
+        .array_bytes = n * sizeof(uint64_t),
+        .trials = cfg,
+        .page_policy = PagePolicyName(opts.pages),
+    };
+    ReportHeader(&run);
+    int ok = RunNumaMatrix(n * sizeof(uint64_t), opts.pages, cfg);
+    ReportEnd();
+    PoolShutdown();
+    PerfCountersClose();
+    return ok ? CompareResults(&opts) : 1;
   }
 
-  size_t n = (size_mb * 1024 * 1024) / sizeof(uint64_t);
-  printf("Allocating %zu MB array...\n", size_mb);
+  BenchLog("Allocating %s array (%s pages)...\n", size_text,
+           PagePolicyName(opts.pages));
+  uint64_t init_start = NowNs();
 
-  uint64_t *array = malloc(n * sizeof(uint64_t));
+  uint64_t *array = AllocArray(n * sizeof(uint64_t), opts.pages);
   if (!array) {
-    fprintf(stderr, "Failed to allocate %zu MB\n", size_mb);
+    fprintf(stderr, "Failed to allocate %s\n", size_text);
     return 1;
   }
-
-  printf("Initializing array...\n");
-  for (size_t i = 0; i < n; i++) {
-    array[i] = i;
+  if (opts.mem_node >= 0 &&
+      !NumaBindMemory(array, n * sizeof(uint64_t), opts.mem_node)) {
+    return 1;
   }
 
+  BenchLog("Initializing array on %zu threads...\n", SetupWorkers());
+  ParallelFillIdentity(array, n);
+  uint64_t init_ns = NowNs() - init_start;
+  BenchLog("Initialized in %.1f ms\n", init_ns / 1e6);
+
+  // Page backing is only known once the array has been touched.
+  RunInfo run = {
+      .array_bytes = n * sizeof(uint64_t),
+      .trials = cfg,
+      .page_policy = PagePolicyName(opts.pages),
+      .init_ns = init_ns,
+  };
+  QueryPageBacking(array, &run.pages);
+  ReportHeader(&run);
+
+  int ok;
   if (run_all) {
-    RunAllBenchmarks(array, n);
+    ok = RunAllBenchmarks(array, n, cfg);
+  } else if (run_sweep) {
+    ok = RunSweeps(&opts, array);
+  } else if (run_writescan) {
+    ok = RunWriteScan(&grid, array, n, cfg);
+    ParamGridFree(&grid);
+  } else if (run_assocscan) {
+    ok = RunAssocScan(&grid, array, n, cfg);
+    ParamGridFree(&grid);
+  } else if (run_tlbreach) {
+    ok = RunTlbReach(&grid, array, n, cfg);
+    ParamGridFree(&grid);
+  } else if (run_mlpsat) {
+    ok = RunMlpSearch(&grid, array, n, cfg);
+    ParamGridFree(&grid);
+  } else if (run_pftune) {
+    ok = RunPrefetchTuner(&grid, array, n, cfg);
+    ParamGridFree(&grid);
+  } else if (run_loaded) {
+    ok = RunLoadedLatency(&grid, array, n, cfg);
+    ParamGridFree(&grid);
+  } else if (param_bench) {
+    ok = RunParamGrid(&grid, array, n, cfg);
+    ParamGridFree(&grid);
   } else {
     const BenchEntry *bench = FindBenchmark(bench_type);
-    BenchResult result = bench->func(array, n);
-    PrintResult(&result);
+    BenchCall call = {.func = bench->func, .input = bench->input};
+    BenchResult result = RunTrials(&call, array, n, cfg);
+    ok = result.iterations > 0;
+    if (ok) {
+      ReportResult(bench->cli_name, "", n * sizeof(uint64_t), &result);
+    } else {
+      fprintf(stderr, "Error: %s failed\n", bench->cli_name);
+    }
   }
+  ReportEnd();
 
-  free(array);
-  return 0;
+  PoolShutdown();
+  PerfCountersClose();
+  ArrayStateShutdown();
+  FreeArray(array, n * sizeof(uint64_t), opts.pages);
+  return ok ? CompareResults(&opts) : 1;
 }
@@ -1,57 +1,65 @@
 #include "bench.h"
+#include "harness/array_state.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
 
-BenchResult BenchPointerChase(uint64_t *array, size_t n) {
-  size_t *indices = malloc(n * sizeof(size_t));
-  if (!indices) {
-    fprintf(stderr, "Failed to allocate indices\n");
-    BenchResult error = {0};
-    return error;
-  }
+// Small working sets walk the cycle several times so that cache-resident
+// sizes (see `bench sweep`) are timed over enough hops.
+#define MIN_HOPS (1u << 20)
 
-  for (size_t i = 0; i < n; i++) {
-    indices[i] = i;
-  }
+// Follows the prepared cycle for max(nodes, MIN_HOPS) dependent loads.
+static BenchResult Chase(const uint64_t *array, size_t nodes,
+                         const char *name) {
+  size_t hops = nodes < MIN_HOPS ? MIN_HOPS : nodes;
+  size_t index = CycleStart(0, 1);
 
-  srand(42);
-  for (size_t i = n - 1; i > 0; i--) {
-    size_t j = rand() % (i + 1);
-    size_t temp = indices[i];
-    indices[i] = indices[j];
-    indices[j] = temp;
-  }
+  BenchTimer timer;
+  TimerStart(&timer);
 
-  for (size_t i = 0; i < n - 1; i++) {
-    array[indices[i]] = indices[i + 1];
-  }
-  array[indices[n - 1]] = indices[0];
-
-  free(indices);
-
-  struct timespec start, end;
-  clock_gettime(CLOCK_MONOTONIC, &start);
-
-  size_t index = 0;
-  for (size_t i = 0; i < n; i++) {
+  for (size_t i = 0; i < hops; i++) {
     index = array[index];
     Clobber();
   }
 
-  clock_gettime(CLOCK_MONOTONIC, &end);
-  uint64_t ns = (end.tv_sec - start.tv_sec) * 1000000000ULL +
-                (end.tv_nsec - start.tv_nsec);
+  uint64_t ns = TimerStop(&timer);
 
   Escape(&index);
 
   BenchResult result = {
-      .name = "Pointer Chase (Serial DRAM Latency)",
-      .iterations = n,
+      .name = name,
+      .iterations = hops,
       .total_ns = ns,
-      .ns_per_access = (double)ns / n
+      .ns_per_access = (double)ns / hops
   };
 
   return result;
 }
+
+// The harness hands over the array as a single random cycle.
+BenchResult BenchPointerChase(uint64_t *array, size_t n) {
+  return Chase(array, n, "Pointer Chase (Serial DRAM Latency)");
+}
+
+// One node per cache line: no two hops share a line, so neither the
+// adjacent-line prefetcher nor a lucky same-line hit shortens the chain.
+BenchResult BenchChaseLine(uint64_t *array, size_t n) {
+  return Chase(array, CycleNodes(n, kStateLineCycle),
+               "Pointer Chase (1 node per line)");
+}
+
+// One node per 4 KiB page: every hop is a cache miss and, past TLB reach,
+// a TLB miss.
+BenchResult BenchChasePage(uint64_t *array, size_t n) {
+  return Chase(array, CycleNodes(n, kStatePageCycle),
+               "Pointer Chase (1 node per page)");
+}
+
+// Every line of a page before the next page: still a cache miss per hop,
+// but only one TLB miss per 64 hops. The gap to BenchChaseLine is the
+// translation cost.
+BenchResult BenchChaseInPage(uint64_t *array, size_t n) {
+  return Chase(array, CycleNodes(n, kStateInPageCycle),
+               "Pointer Chase (random within page)");
+}
@@ -1,26 +1,17 @@
 #include "bench.h"
+#include "harness/array_state.h"
+#include "harness/rng.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
 
-static void Shuffle(size_t *arr, size_t n) {
-  srand(42);
-  for (size_t i = n - 1; i > 0; i--) {
-    size_t j = rand() % (i + 1);
-    size_t tmp = arr[i];
-    arr[i] = arr[j];
-    arr[j] = tmp;
-  }
-}
-
 static BenchResult RunPrefetch(uint64_t *array, size_t n, size_t dist, const char *name) {
-  size_t *indices = malloc(n * sizeof(size_t));
-  for (size_t i = 0; i < n; i++) indices[i] = i;
-  Shuffle(indices, n);
+  const size_t *indices = AcquirePermutation(n);
+  if (!indices) return (BenchResult){0};
 
-  struct timespec start, end;
-  clock_gettime(CLOCK_MONOTONIC, &start);
+  BenchTimer timer;
+  TimerStart(&timer);
 
   uint64_t sum = 0;
   if (dist == 0) {
@@ -36,17 +27,17 @@ static BenchResult RunPrefetch(uint64_t *array, size_t n, size_t dist, const cha
     }
   }
 
-  clock_gettime(CLOCK_MONOTONIC, &end);
+  uint64_t ns = TimerStop(&timer);
   Escape(&sum);
-  free(indices);
+  ReleasePermutation(indices);
 
-  uint64_t ns = (end.tv_sec - start.tv_sec) * 1000000000ULL + (end.tv_nsec - start.tv_nsec);
-  return (BenchResult){name, n, ns, (double)ns / n};
+  return (BenchResult){.name = name, .iterations = n,
+                       .total_ns = ns, .ns_per_access = (double)ns / n};
 }
 
 static BenchResult RunSeqPrefetch(uint64_t *array, size_t n, size_t dist, const char *name) {
-  struct timespec start, end;
-  clock_gettime(CLOCK_MONOTONIC, &start);
+  BenchTimer timer;
+  TimerStart(&timer);
 
   uint64_t sum = 0;
   if (dist == 0) {
@@ -62,11 +53,11 @@ static BenchResult RunSeqPrefetch(uint64_t *array, size_t n, size_t dist, const
     }
   }
 
-  clock_gettime(CLOCK_MONOTONIC, &end);
+  uint64_t ns = TimerStop(&timer);
   Escape(&sum);
 
-  uint64_t ns = (end.tv_sec - start.tv_sec) * 1000000000ULL + (end.tv_nsec - start.tv_nsec);
-  return (BenchResult){name, n, ns, (double)ns / n};
+  return (BenchResult){.name = name, .iterations = n,
+                       .total_ns = ns, .ns_per_access = (double)ns / n};
 }
 
 BenchResult BenchPrefetchNone(uint64_t *a, size_t n) {
@@ -89,3 +80,212 @@ BenchResult BenchSeqPrefetch64(uint64_t *a, size_t n) {
   return RunSeqPrefetch(a, n, 64, "Sequential sw prefetch +64");
 }
 
+
+BenchResult BenchPrefetchDist(uint64_t *a, size_t n, const int64_t *params) {
+  return RunPrefetch(a, n, (size_t)params[0], "Random prefetch");
+}
+
+BenchResult BenchSeqPrefetchDist(uint64_t *a, size_t n, const int64_t *params) {
+  return RunSeqPrefetch(a, n, (size_t)params[0], "Sequential sw prefetch");
+}
+
+// Tunable prefetching over three access patterns. Prefetches are issued in
+// batches: every `lines` accesses, one prefetch for each of the `lines`
+// accesses that lie `dist` ahead, so the work stays the same while the
+// number of prefetch instructions and their grouping change.
+
+// Short working sets are repeated until a trial makes this many accesses.
+#define TUNE_MIN_ACCESSES ((size_t)1 << 16)
+// Chase nodes are one cache line: slot 0 is the next node, slots 1..6
+// point 'dist' ahead (jump pointers), slot 7 is the payload.
+#define NODE_SLOTS 8
+#define NODE_JUMPS 6
+#define NODE_PAYLOAD 7
+
+// Parameter values, in the order of the names registered in main.c.
+enum { kTuneRandom, kTuneChase, kTuneStride, kNumTunePatterns };
+enum { kTuneLoad, kTuneUpdate };
+enum { kIntentRead, kIntentWrite };
+
+static const char *const kTunePatternNames[] = {"random", "chase", "strided"};
+static const char *const kHintNames[] = {"nta", "t2", "t1", "t0"};
+
+typedef struct {
+  uint64_t *array;
+  const size_t *indices;  // kTuneRandom: access order
+  size_t start;           // kTuneChase: slot of the first node
+  size_t count;           // Accesses per pass
+  size_t stride;          // kTuneStride: elements between accesses
+  size_t dist;            // 0: no prefetching
+  size_t lines;
+  int update;
+} TuneArgs;
+
+typedef uint64_t (*TuneKernel)(const TuneArgs *t);
+
+// The element an access touches: a load adds it to the sum, an update
+// increments it in place.
+#define TOUCH(p)    \
+  do {              \
+    if (update) {   \
+      (*(p))++;     \
+    } else {        \
+      sum += *(p);  \
+    }               \
+    Clobber();      \
+  } while (0)
+
+// __builtin_prefetch needs constant arguments, so there is one kernel per
+// (pattern, read/write intent, locality hint).
+#define DEFINE_TUNE_KERNELS(Suffix, Attr, RW, LOC)                          \
+  Attr static uint64_t Random##Suffix(const TuneArgs *t) {                  \
+    uint64_t *a = t->array, sum = 0;                                        \
+    const size_t *idx = t->indices;                                         \
+    size_t count = t->count, dist = t->dist, lines = t->lines;              \
+    int update = t->update;                                                 \
+    for (size_t i = 0; i < count; i += lines) {                             \
+      size_t stop = i + lines < count ? i + lines : count;                  \
+      for (size_t j = i + dist; dist && j < stop + dist && j < count; j++) { \
+        __builtin_prefetch(&a[idx[j]], RW, LOC);                            \
+      }                                                                     \
+      for (size_t j = i; j < stop; j++) TOUCH(&a[idx[j]]);                  \
+    }                                                                       \
+    return sum;                                                             \
+  }                                                                         \
+  Attr static uint64_t Chase##Suffix(const TuneArgs *t) {                   \
+    uint64_t *a = t->array, sum = 0;                                        \
+    size_t p = t->start, count = t->count, lines = t->lines;                \
+    int update = t->update;                                                 \
+    for (size_t i = 0; i < count; i += lines) {                             \
+      for (size_t k = 1; t->dist && k <= lines; k++) {                      \
+        __builtin_prefetch(&a[a[p + k]], RW, LOC);                          \
+      }                                                                     \
+      for (size_t j = 0; j < lines && i + j < count; j++) {                 \
+        TOUCH(&a[p + NODE_PAYLOAD]);                                        \
+        p = a[p];                                                           \
+      }                                                                     \
+    }                                                                       \
+    return sum;                                                             \
+  }                                                                         \
+  Attr static uint64_t Stride##Suffix(const TuneArgs *t) {                  \
+    uint64_t *a = t->array, sum = 0;                                        \
+    size_t count = t->count, dist = t->dist, lines = t->lines;              \
+    size_t stride = t->stride;                                              \
+    int update = t->update;                                                 \
+    for (size_t i = 0; i < count; i += lines) {                             \
+      size_t stop = i + lines < count ? i + lines : count;                  \
+      for (size_t j = i + dist; dist && j < stop + dist && j < count; j++) { \
+        __builtin_prefetch(&a[j * stride], RW, LOC);                        \
+      }                                                                     \
+      for (size_t j = i; j < stop; j++) TOUCH(&a[j * stride]);              \
+    }                                                                       \
+    return sum;                                                             \
+  }
+
+// Write intent becomes prefetchw, which the baseline target does not
+// enable; CPUs without it execute the encoding as a NOP.
+#if defined(__x86_64__)
+#define WRITE_ATTR __attribute__((target("prfchw")))
+#else
+#define WRITE_ATTR
+#endif
+
+DEFINE_TUNE_KERNELS(ReadNta, , 0, 0)
+DEFINE_TUNE_KERNELS(ReadT2, , 0, 1)
+DEFINE_TUNE_KERNELS(ReadT1, , 0, 2)
+DEFINE_TUNE_KERNELS(ReadT0, , 0, 3)
+DEFINE_TUNE_KERNELS(WriteNta, WRITE_ATTR, 1, 0)
+DEFINE_TUNE_KERNELS(WriteT2, WRITE_ATTR, 1, 1)
+DEFINE_TUNE_KERNELS(WriteT1, WRITE_ATTR, 1, 2)
+DEFINE_TUNE_KERNELS(WriteT0, WRITE_ATTR, 1, 3)
+
+#define TUNE_ROW(Pattern)                                            \
+  {{Pattern##ReadNta, Pattern##ReadT2, Pattern##ReadT1, Pattern##ReadT0}, \
+   {Pattern##WriteNta, Pattern##WriteT2, Pattern##WriteT1,           \
+    Pattern##WriteT0}}
+
+// [pattern][intent][hint]
+static const TuneKernel kTuneKernels[kNumTunePatterns][2][4] = {
+    [kTuneRandom] = TUNE_ROW(Random),
+    [kTuneChase] = TUNE_ROW(Chase),
+    [kTuneStride] = TUNE_ROW(Stride),
+};
+
+// Links the array's lines into one random cycle of nodes whose jump
+// pointers lead `dist` and more nodes ahead. Returns the first node's
+// slot, or (size_t)-1 if out of memory.
+static size_t BuildJumpCycle(uint64_t *array, size_t nodes, size_t dist) {
+  size_t *order = RandomPermutation(nodes, BenchSeed());
+  if (!order) return (size_t)-1;
+  for (size_t i = 0; i < nodes; i++) {
+    uint64_t *node = array + order[i] * NODE_SLOTS;
+    node[0] = order[(i + 1) % nodes] * NODE_SLOTS;
+    for (size_t k = 1; k <= NODE_JUMPS; k++) {
+      node[k] = order[(i + dist + k - 1) % nodes] * NODE_SLOTS;
+    }
+    node[NODE_PAYLOAD] = i;
+  }
+  size_t start = order[0] * NODE_SLOTS;
+  free(order);
+  return start;
+}
+
+BenchResult BenchPrefetchTune(uint64_t *array, size_t n,
+                              const int64_t *params) {
+  BenchResult error = {0};
+  int pattern = (int)params[0];
+  TuneArgs t = {.array = array, .update = params[1] == kTuneUpdate,
+                .dist = (size_t)params[2], .lines = (size_t)params[5]};
+  int intent = (int)params[4], hint = (int)params[3];
+
+  switch (pattern) {
+    case kTuneRandom:
+      t.indices = AcquirePermutation(n);
+      if (!t.indices) return error;
+      t.count = n;
+      break;
+    case kTuneChase:
+      t.count = n / NODE_SLOTS;
+      if (t.lines > NODE_JUMPS) t.lines = NODE_JUMPS;
+      if (t.count < 2) break;
+      t.start = BuildJumpCycle(array, t.count, t.dist);
+      if (t.start == (size_t)-1) return error;
+      break;
+    default:
+      t.stride = (size_t)params[6] / sizeof(uint64_t);
+      if (t.stride == 0) t.stride = 1;
+      t.count = n / t.stride;
+      break;
+  }
+  if (t.count < 2) {
+    fprintf(stderr, "Prefetch: array too small for the %s pattern\n",
+            kTunePatternNames[pattern]);
+    if (t.indices) ReleasePermutation(t.indices);
+    return error;
+  }
+  size_t passes = (TUNE_MIN_ACCESSES + t.count - 1) / t.count;
+  TuneKernel kernel = kTuneKernels[pattern][intent][hint];
+
+  BenchTimer timer;
+  TimerStart(&timer);
+  uint64_t sum = 0;
+  for (size_t pass = 0; pass < passes; pass++) sum += kernel(&t);
+  uint64_t ns = TimerStop(&timer);
+  Escape(&sum);
+  if (t.indices) ReleasePermutation(t.indices);
+
+  size_t accesses = t.count * passes;
+  if (t.dist) {
+    BenchLog("  %s %s, prefetch %zu ahead, %s hint, %s intent, %zu per "
+             "batch\n",
+             kTunePatternNames[pattern], t.update ? "update" : "load", t.dist,
+             kHintNames[hint], intent == kIntentWrite ? "write" : "read",
+             t.lines);
+  } else {
+    BenchLog("  %s %s, no prefetch\n", kTunePatternNames[pattern],
+             t.update ? "update" : "load");
+  }
+  return (BenchResult){.name = "Prefetch tuning", .iterations = accesses,
+                       .total_ns = ns,
+                       .ns_per_access = (double)ns / accesses};
+}
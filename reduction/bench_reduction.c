@@ -1,29 +1,25 @@
 #include "bench.h"
+#include "harness/cpu_isa.h"
+#include "harness/parallel.h"
+#include "harness/pool.h"
+#include "harness/schedule.h"
 
-#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
-#ifdef __AVX2__
+#if ISA_X86
 #include <immintrin.h>
-#define HAS_AVX2 1
-#else
-#define HAS_AVX2 0
 #endif
 
-#ifdef __SSE2__
-#include <emmintrin.h>
-#define HAS_SSE2 1
-#else
-#define HAS_SSE2 0
-#endif
-
-#define NUM_THREADS 8
+#define CACHE_LINE 64
+// Per-worker partial sums sit a cache line apart.
+#define PARTIAL_STRIDE (CACHE_LINE / sizeof(uint64_t))
 
 static BenchResult MakeResult(const char *name, uint64_t sum, size_t n,
                                uint64_t ns) {
-  printf("  Sum: %lu\n", sum);
+  BenchLog("  Sum: %lu\n", sum);
 
   BenchResult result = {
       .name = name,
@@ -43,15 +39,13 @@ static uint64_t SumNaive(const uint64_t *array, size_t n) {
 }
 
 BenchResult BenchReductionNaive(uint64_t *array, size_t n) {
-  struct timespec start, end;
-  clock_gettime(CLOCK_MONOTONIC, &start);
+  BenchTimer timer;
+  TimerStart(&timer);
 
   uint64_t sum = SumNaive(array, n);
   Escape(&sum);
 
-  clock_gettime(CLOCK_MONOTONIC, &end);
-  uint64_t ns =
-      (end.tv_sec - start.tv_sec) * 1000000000ULL + (end.tv_nsec - start.tv_nsec);
+  uint64_t ns = TimerStop(&timer);
 
   return MakeResult("Reduction Naive (1 accumulator)", sum, n, ns);
 }
@@ -80,282 +74,249 @@ static uint64_t SumILP(const uint64_t *array, size_t n) {
 }
 
 BenchResult BenchReductionILP(uint64_t *array, size_t n) {
-  struct timespec start, end;
-  clock_gettime(CLOCK_MONOTONIC, &start);
+  BenchTimer timer;
+  TimerStart(&timer);
 
   uint64_t sum = SumILP(array, n);
   Escape(&sum);
 
-  clock_gettime(CLOCK_MONOTONIC, &end);
-  uint64_t ns =
-      (end.tv_sec - start.tv_sec) * 1000000000ULL + (end.tv_nsec - start.tv_nsec);
+  uint64_t ns = TimerStop(&timer);
 
   return MakeResult("Reduction ILP (8 accumulators)", sum, n, ns);
 }
 
-#if HAS_AVX2
-static uint64_t SumSimd(const uint64_t *array, size_t n) {
-  __m256i vsum = _mm256_setzero_si256();
 
-  size_t i = 0;
-  for (; i + 4 <= n; i += 4) {
-    __m256i v = _mm256_loadu_si256((const __m256i *)(array + i));
-    vsum = _mm256_add_epi64(vsum, v);
+// One family of kernels per ISA, W uint64_t per vector: Sum keeps a single
+// vector accumulator, SumILP four, SumPair two (what each thread of the
+// threaded variant runs over its chunks), and SumOpt is the plain loop the
+// compiler may vectorize for that target. The binary is built for the
+// baseline target; wider families carry their own target attribute and are
+// picked at run time.
+#define DEFINE_SUMS(Isa, Attr, Vec, W, Zero, Load, Add, Reduce)        \
+  Attr static uint64_t Sum##Isa(const uint64_t *array, size_t n) {     \
+    Vec vsum = Zero();                                                  \
+    size_t i = 0;                                                       \
+    for (; i + W <= n; i += W) vsum = Add(vsum, Load(array + i));       \
+    uint64_t sum = Reduce(vsum);                                        \
+    for (; i < n; i++) sum += array[i];                                 \
+    return sum;                                                         \
+  }                                                                     \
+  Attr static uint64_t SumILP##Isa(const uint64_t *array, size_t n) {  \
+    Vec v0 = Zero(), v1 = Zero(), v2 = Zero(), v3 = Zero();             \
+    size_t i = 0;                                                       \
+    for (; i + 4 * W <= n; i += 4 * W) {                                \
+      v0 = Add(v0, Load(array + i));                                    \
+      v1 = Add(v1, Load(array + i + W));                                \
+      v2 = Add(v2, Load(array + i + 2 * W));                            \
+      v3 = Add(v3, Load(array + i + 3 * W));                            \
+    }                                                                   \
+    uint64_t sum = Reduce(Add(Add(v0, v1), Add(v2, v3)));               \
+    for (; i < n; i++) sum += array[i];                                 \
+    return sum;                                                         \
+  }                                                                     \
+  Attr static uint64_t SumPair##Isa(const uint64_t *array, size_t n) { \
+    Vec v0 = Zero(), v1 = Zero();                                       \
+    size_t i = 0;                                                       \
+    for (; i + 2 * W <= n; i += 2 * W) {                                \
+      v0 = Add(v0, Load(array + i));                                    \
+      v1 = Add(v1, Load(array + i + W));                                \
+    }                                                                   \
+    uint64_t sum = Reduce(Add(v0, v1));                                 \
+    for (; i < n; i++) sum += array[i];                                 \
+    return sum;                                                         \
+  }                                                                     \
+  Attr static uint64_t SumOpt##Isa(const uint64_t *array, size_t n) {  \
+    uint64_t sum = 0;                                                   \
+    for (size_t i = 0; i < n; i++) sum += array[i];                     \
+    return sum;                                                         \
   }
 
-  uint64_t tmp[4];
-  _mm256_storeu_si256((__m256i *)tmp, vsum);
-  uint64_t sum = tmp[0] + tmp[1] + tmp[2] + tmp[3];
-
-  for (; i < n; i++) {
-    sum += array[i];
-  }
-  return sum;
-}
-#elif HAS_SSE2
-static uint64_t SumSimd(const uint64_t *array, size_t n) {
-  __m128i vsum = _mm_setzero_si128();
-
-  size_t i = 0;
-  for (; i + 2 <= n; i += 2) {
-    __m128i v = _mm_loadu_si128((const __m128i *)(array + i));
-    vsum = _mm_add_epi64(vsum, v);
-  }
-
-  uint64_t tmp[2];
-  _mm_storeu_si128((__m128i *)tmp, vsum);
-  uint64_t sum = tmp[0] + tmp[1];
-
-  for (; i < n; i++) {
-    sum += array[i];
-  }
-  return sum;
-}
-#else
-static uint64_t SumSimd(const uint64_t *array, size_t n) {
-  return SumILP(array, n);
-}
-#endif
-
-BenchResult BenchReductionSimd(uint64_t *array, size_t n) {
-  struct timespec start, end;
-  clock_gettime(CLOCK_MONOTONIC, &start);
+#define SCALAR_ZERO() 0
+#define SCALAR_LOAD(p) (*(p))
+#define SCALAR_ADD(x, y) ((x) + (y))
+#define SCALAR_REDUCE(x) (x)
 
-  uint64_t sum = SumSimd(array, n);
-  Escape(&sum);
+// Keep the scalar family scalar, whatever the baseline target allows.
+#define SCALAR_ATTR __attribute__((optimize("no-tree-vectorize")))
 
-  clock_gettime(CLOCK_MONOTONIC, &end);
-  uint64_t ns =
-      (end.tv_sec - start.tv_sec) * 1000000000ULL + (end.tv_nsec - start.tv_nsec);
+DEFINE_SUMS(Scalar, SCALAR_ATTR, uint64_t, 1, SCALAR_ZERO, SCALAR_LOAD,
+            SCALAR_ADD, SCALAR_REDUCE)
 
-  const char *name = HAS_AVX2 ? "Reduction SIMD (AVX2 4x64)"
-                              : (HAS_SSE2 ? "Reduction SIMD (SSE2 2x64)"
-                                          : "Reduction SIMD (fallback)");
-  return MakeResult(name, sum, n, ns);
+#if ISA_X86
+ISA_TARGET_SSE2 static inline __m128i Load128(const uint64_t *p) {
+  return _mm_loadu_si128((const __m128i *)p);
 }
 
-typedef struct {
-  const uint64_t *array;
-  size_t start;
-  size_t end;
-  uint64_t result;
-} ThreadArg;
-
-static void *ThreadSum(void *arg) {
-  ThreadArg *ta = (ThreadArg *)arg;
-  uint64_t sum = 0;
-  for (size_t i = ta->start; i < ta->end; i++) {
-    sum += ta->array[i];
-  }
-  ta->result = sum;
-  return NULL;
+ISA_TARGET_SSE2 static inline uint64_t Reduce128(__m128i v) {
+  uint64_t tmp[2];
+  _mm_storeu_si128((__m128i *)tmp, v);
+  return tmp[0] + tmp[1];
 }
 
-static uint64_t SumThreaded(const uint64_t *array, size_t n) {
-  pthread_t threads[NUM_THREADS];
-  ThreadArg args[NUM_THREADS];
-
-  size_t chunk_size = n / NUM_THREADS;
-  size_t remainder = n % NUM_THREADS;
-
-  size_t offset = 0;
-  for (int t = 0; t < NUM_THREADS; t++) {
-    args[t].array = array;
-    args[t].start = offset;
-    size_t this_chunk = chunk_size + (t < (int)remainder ? 1 : 0);
-    args[t].end = offset + this_chunk;
-    args[t].result = 0;
-    offset = args[t].end;
-    pthread_create(&threads[t], NULL, ThreadSum, &args[t]);
-  }
-
-  uint64_t sum = 0;
-  for (int t = 0; t < NUM_THREADS; t++) {
-    pthread_join(threads[t], NULL);
-    sum += args[t].result;
-  }
-  return sum;
+ISA_TARGET_AVX2 static inline __m256i Load256(const uint64_t *p) {
+  return _mm256_loadu_si256((const __m256i *)p);
 }
 
-BenchResult BenchReductionThread(uint64_t *array, size_t n) {
-  struct timespec start, end;
-  clock_gettime(CLOCK_MONOTONIC, &start);
-
-  uint64_t sum = SumThreaded(array, n);
-  Escape(&sum);
-
-  clock_gettime(CLOCK_MONOTONIC, &end);
-  uint64_t ns =
-      (end.tv_sec - start.tv_sec) * 1000000000ULL + (end.tv_nsec - start.tv_nsec);
-
-  return MakeResult("Reduction Threaded (8 threads)", sum, n, ns);
+ISA_TARGET_AVX2 static inline uint64_t Reduce256(__m256i v) {
+  uint64_t tmp[4];
+  _mm256_storeu_si256((__m256i *)tmp, v);
+  return tmp[0] + tmp[1] + tmp[2] + tmp[3];
 }
 
-#if HAS_AVX2
-static uint64_t SumILPSimd(const uint64_t *array, size_t n) {
-  __m256i vsum0 = _mm256_setzero_si256();
-  __m256i vsum1 = _mm256_setzero_si256();
-  __m256i vsum2 = _mm256_setzero_si256();
-  __m256i vsum3 = _mm256_setzero_si256();
-
-  size_t i = 0;
-  for (; i + 16 <= n; i += 16) {
-    __m256i v0 = _mm256_loadu_si256((const __m256i *)(array + i + 0));
-    __m256i v1 = _mm256_loadu_si256((const __m256i *)(array + i + 4));
-    __m256i v2 = _mm256_loadu_si256((const __m256i *)(array + i + 8));
-    __m256i v3 = _mm256_loadu_si256((const __m256i *)(array + i + 12));
-    vsum0 = _mm256_add_epi64(vsum0, v0);
-    vsum1 = _mm256_add_epi64(vsum1, v1);
-    vsum2 = _mm256_add_epi64(vsum2, v2);
-    vsum3 = _mm256_add_epi64(vsum3, v3);
-  }
+DEFINE_SUMS(Sse2, ISA_TARGET_SSE2, __m128i, 2, _mm_setzero_si128, Load128,
+            _mm_add_epi64, Reduce128)
+DEFINE_SUMS(Avx2, ISA_TARGET_AVX2, __m256i, 4, _mm256_setzero_si256,
+            Load256, _mm256_add_epi64, Reduce256)
+DEFINE_SUMS(Avx512, ISA_TARGET_AVX512, __m512i, 8, _mm512_setzero_si512,
+            _mm512_loadu_si512, _mm512_add_epi64, _mm512_reduce_add_epi64)
+#endif
 
-  vsum0 = _mm256_add_epi64(vsum0, vsum1);
-  vsum2 = _mm256_add_epi64(vsum2, vsum3);
-  vsum0 = _mm256_add_epi64(vsum0, vsum2);
+typedef uint64_t (*SumFunc)(const uint64_t *array, size_t n);
 
-  uint64_t tmp[4];
-  _mm256_storeu_si256((__m256i *)tmp, vsum0);
-  uint64_t sum = tmp[0] + tmp[1] + tmp[2] + tmp[3];
+typedef struct {
+  const char *simd_name;
+  const char *ilp_simd_name;
+  SumFunc sum;
+  SumFunc sum_ilp;
+  SumFunc sum_pair;
+  SumFunc sum_opt;
+} ReductionKernels;
+
+#define KERNELS(Isa, SimdName, IlpSimdName) \
+  {SimdName, IlpSimdName, Sum##Isa, SumILP##Isa, SumPair##Isa, SumOpt##Isa}
+
+// Indexed by Isa; only entries the CPU supports are ever selected.
+static const ReductionKernels kKernels[kNumIsas] = {
+    [kIsaScalar] = KERNELS(Scalar, "Reduction SIMD (fallback)",
+                           "Reduction ILP+SIMD (fallback)"),
+#if ISA_X86
+    [kIsaSse2] = KERNELS(Sse2, "Reduction SIMD (SSE2 2x64)",
+                         "Reduction ILP+SIMD (4xSSE2)"),
+    [kIsaAvx2] = KERNELS(Avx2, "Reduction SIMD (AVX2 4x64)",
+                         "Reduction ILP+SIMD (4xAVX2)"),
+    [kIsaAvx512] = KERNELS(Avx512, "Reduction SIMD (AVX-512 8x64)",
+                           "Reduction ILP+SIMD (4xAVX-512)"),
+#endif
+};
 
-  for (; i < n; i++) {
-    sum += array[i];
-  }
-  return sum;
-}
-#else
-static uint64_t SumILPSimd(const uint64_t *array, size_t n) {
-  return SumILP(array, n);
+// The kernels for the ISA chosen by CPUID or --isa.
+static const ReductionKernels *ActiveKernels(void) {
+  Isa isa = ActiveIsa();
+  BenchLog("  ISA: %s\n", IsaName(isa));
+  return &kKernels[isa];
 }
-#endif
 
-BenchResult BenchReductionILPSimd(uint64_t *array, size_t n) {
-  struct timespec start, end;
-  clock_gettime(CLOCK_MONOTONIC, &start);
+BenchResult BenchReductionSimd(uint64_t *array, size_t n) {
+  const ReductionKernels *k = ActiveKernels();
+  BenchTimer timer;
+  TimerStart(&timer);
 
-  uint64_t sum = SumILPSimd(array, n);
+  uint64_t sum = k->sum(array, n);
   Escape(&sum);
 
-  clock_gettime(CLOCK_MONOTONIC, &end);
-  uint64_t ns =
-      (end.tv_sec - start.tv_sec) * 1000000000ULL + (end.tv_nsec - start.tv_nsec);
+  uint64_t ns = TimerStop(&timer);
 
-  const char *name =
-      HAS_AVX2 ? "Reduction ILP+SIMD (4xAVX2)" : "Reduction ILP+SIMD (fallback)";
-  return MakeResult(name, sum, n, ns);
+  return MakeResult(k->simd_name, sum, n, ns);
 }
 
-static void *ThreadSumILPSimd(void *arg) {
-  ThreadArg *ta = (ThreadArg *)arg;
-#if HAS_AVX2
-  __m256i vsum0 = _mm256_setzero_si256();
-  __m256i vsum1 = _mm256_setzero_si256();
-
-  size_t i = ta->start;
-  for (; i + 8 <= ta->end; i += 8) {
-    __m256i v0 = _mm256_loadu_si256((const __m256i *)(ta->array + i + 0));
-    __m256i v1 = _mm256_loadu_si256((const __m256i *)(ta->array + i + 4));
-    vsum0 = _mm256_add_epi64(vsum0, v0);
-    vsum1 = _mm256_add_epi64(vsum1, v1);
-  }
-
-  vsum0 = _mm256_add_epi64(vsum0, vsum1);
-  uint64_t tmp[4];
-  _mm256_storeu_si256((__m256i *)tmp, vsum0);
-  uint64_t sum = tmp[0] + tmp[1] + tmp[2] + tmp[3];
+typedef struct {
+  const uint64_t *array;
+  SumFunc sum;
+  uint64_t *partials;  // PARTIAL_STRIDE apart, one per worker
+} ChunkSumCtx;
+
+static void SumChunk(size_t begin, size_t end, size_t worker, void *ctx) {
+  ChunkSumCtx *c = ctx;
+  c->partials[worker * PARTIAL_STRIDE] += c->sum(c->array + begin,
+                                                 end - begin);
+}
 
-  for (; i < ta->end; i++) {
-    sum += ta->array[i];
+// Sums the array with `sum` on `threads` pool workers, partitioned by
+// `schedule`. Time is the workers' own start-to-finish window.
+static BenchResult SumThreaded(const uint64_t *array, size_t n, SumFunc sum,
+                               size_t threads, Schedule schedule,
+                               size_t chunk, int per_thread,
+                               const char *name) {
+  BenchResult error = {0};
+  uint64_t *partials =
+      aligned_alloc(CACHE_LINE, threads * PARTIAL_STRIDE * sizeof(uint64_t));
+  ScheduleWorker *workers = malloc(threads * sizeof(ScheduleWorker));
+  if (!partials || !workers) {
+    fprintf(stderr, "Failed to allocate %zu reduction threads\n", threads);
+    free(partials);
+    free(workers);
+    return error;
   }
-  ta->result = sum;
-#else
-  uint64_t sum = 0;
-  for (size_t i = ta->start; i < ta->end; i++) {
-    sum += ta->array[i];
+  memset(partials, 0, threads * PARTIAL_STRIDE * sizeof(uint64_t));
+  ChunkSumCtx ctx = {.array = array, .sum = sum, .partials = partials};
+  ScheduleStats stats = {.workers = workers};
+  if (!PoolReserve(threads)) {
+    free(partials);
+    free(workers);
+    return error;
   }
-  ta->result = sum;
-#endif
-  return NULL;
-}
 
-static uint64_t SumAll(const uint64_t *array, size_t n) {
-  pthread_t threads[NUM_THREADS];
-  ThreadArg args[NUM_THREADS];
-
-  size_t chunk_size = n / NUM_THREADS;
-  size_t remainder = n % NUM_THREADS;
-
-  size_t offset = 0;
-  for (int t = 0; t < NUM_THREADS; t++) {
-    args[t].array = array;
-    args[t].start = offset;
-    size_t this_chunk = chunk_size + (t < (int)remainder ? 1 : 0);
-    args[t].end = offset + this_chunk;
-    args[t].result = 0;
-    offset = args[t].end;
-    pthread_create(&threads[t], NULL, ThreadSumILPSimd, &args[t]);
-  }
+  BenchTimer timer;
+  TimerStart(&timer);
+  int ok = ScheduleRun(n, threads, schedule, chunk, SumChunk, &ctx, &stats);
+  TimerStop(&timer);
+
+  uint64_t total = 0;
+  for (size_t t = 0; t < threads; t++) total += partials[t * PARTIAL_STRIDE];
+  Escape(&total);
+  if (ok) LogScheduleStats(&stats, per_thread);
+  free(partials);
+  free(workers);
+  if (!ok) return error;
+  return MakeResult(name, total, n, stats.span_ns);
+}
 
-  uint64_t sum = 0;
-  for (int t = 0; t < NUM_THREADS; t++) {
-    pthread_join(threads[t], NULL);
-    sum += args[t].result;
-  }
-  return sum;
+BenchResult BenchReductionThread(uint64_t *array, size_t n) {
+  return SumThreaded(array, n, SumNaive, SetupWorkers(), kScheduleDynamic,
+                     SCHEDULE_DEFAULT_CHUNK, 0,
+                     "Reduction Threaded (1 thread per CPU)");
 }
 
-BenchResult BenchReductionAll(uint64_t *array, size_t n) {
-  struct timespec start, end;
-  clock_gettime(CLOCK_MONOTONIC, &start);
+BenchResult BenchReductionILPSimd(uint64_t *array, size_t n) {
+  const ReductionKernels *k = ActiveKernels();
+  BenchTimer timer;
+  TimerStart(&timer);
 
-  uint64_t sum = SumAll(array, n);
+  uint64_t sum = k->sum_ilp(array, n);
   Escape(&sum);
 
-  clock_gettime(CLOCK_MONOTONIC, &end);
-  uint64_t ns =
-      (end.tv_sec - start.tv_sec) * 1000000000ULL + (end.tv_nsec - start.tv_nsec);
+  uint64_t ns = TimerStop(&timer);
 
-  return MakeResult("Reduction All (8 threads + ILP + SIMD)", sum, n, ns);
+  return MakeResult(k->ilp_simd_name, sum, n, ns);
 }
 
-static uint64_t SumOptimizable(const uint64_t *array, size_t n) {
-  uint64_t sum = 0;
-  for (size_t i = 0; i < n; i++) {
-    sum += array[i];
-  }
-  return sum;
+BenchResult BenchReductionAll(uint64_t *array, size_t n) {
+  const ReductionKernels *k = ActiveKernels();
+  return SumThreaded(array, n, k->sum_pair, SetupWorkers(), kScheduleDynamic,
+                     SCHEDULE_DEFAULT_CHUNK, 0,
+                     "Reduction All (threads + ILP + SIMD)");
 }
 
 BenchResult BenchReductionOpt(uint64_t *array, size_t n) {
-  struct timespec start, end;
-  clock_gettime(CLOCK_MONOTONIC, &start);
+  const ReductionKernels *k = ActiveKernels();
+  BenchTimer timer;
+  TimerStart(&timer);
 
-  volatile uint64_t sum = SumOptimizable(array, n);
+  volatile uint64_t sum = k->sum_opt(array, n);
   (void)sum;
 
-  clock_gettime(CLOCK_MONOTONIC, &end);
-  uint64_t ns =
-      (end.tv_sec - start.tv_sec) * 1000000000ULL + (end.tv_nsec - start.tv_nsec);
+  uint64_t ns = TimerStop(&timer);
 
   return MakeResult("Reduction Optimized (compiler free)", sum, n, ns);
 }
+
+// Parameter values, in the order of the names registered in main.c.
+enum { kMtNaive, kMtSimd };
+
+BenchResult BenchReductionMt(uint64_t *array, size_t n,
+                             const int64_t *params) {
+  SumFunc sum = params[0] == kMtSimd ? ActiveKernels()->sum_pair : SumNaive;
+  size_t threads = params[1] ? (size_t)params[1] : SetupWorkers();
+  return SumThreaded(array, n, sum, threads, (Schedule)params[2],
+                     (size_t)params[3], 1, "Reduction Threaded");
+}
@@ -18,11 +18,12 @@ echo "Array Size: ${SIZE} MB"
 echo "=================================="
 echo ""
 
-# Run each benchmark with perf stats
+# Run each benchmark; hardware counters are sampled in-process around the
+# timed region only (see harness/perf_counters.h)
 for benchmark in seq ran chase; do
   echo "Running: $benchmark"
   echo "---"
-  perf stat -e LLC-loads,LLC-load-misses ./bench $benchmark $SIZE 2>&1 | tee ${benchmark}_${SIZE}mb.log
+  ./bench $benchmark $SIZE 2>&1 | tee ${benchmark}_${SIZE}mb.log
   echo ""
   echo "---"
   echo ""
@@ -39,7 +40,7 @@ for benchmark in seq ran chase; do
   if [ -f "$log" ]; then
     echo "=== $benchmark ==="
     grep "Time per access:" $log
-    grep "LLC-load-misses" $log | grep -v "cpu_atom"
+    grep -E "IPC:|Per access:" $log || true
     echo ""
   fi
 done
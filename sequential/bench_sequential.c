@@ -4,8 +4,8 @@
 #include <time.h>
 
 BenchResult BenchSequential(uint64_t *array, size_t n) {
-  struct timespec start, end;
-  clock_gettime(CLOCK_MONOTONIC, &start);
+  BenchTimer timer;
+  TimerStart(&timer);
 
   uint64_t sum = 0;
   for (size_t i = 0; i < n; i++) {
@@ -13,9 +13,7 @@ BenchResult BenchSequential(uint64_t *array, size_t n) {
     Clobber();
   }
 
-  clock_gettime(CLOCK_MONOTONIC, &end);
-  uint64_t ns = (end.tv_sec - start.tv_sec) * 1000000000ULL +
-                (end.tv_nsec - start.tv_nsec);
+  uint64_t ns = TimerStop(&timer);
 
   Escape(&sum);
 
@@ -6,8 +6,8 @@
 BenchResult BenchStoreFwdSame(uint64_t *array, size_t n) {
   uint8_t *bytes = (uint8_t *)array;
 
-  struct timespec start, end;
-  clock_gettime(CLOCK_MONOTONIC, &start);
+  BenchTimer timer;
+  TimerStart(&timer);
 
   uint64_t sum = 0;
   for (size_t i = 0; i < n; i++) {
@@ -16,18 +16,18 @@ BenchResult BenchStoreFwdSame(uint64_t *array, size_t n) {
     Clobber();
   }
 
-  clock_gettime(CLOCK_MONOTONIC, &end);
+  uint64_t ns = TimerStop(&timer);
   Escape(&sum);
 
-  uint64_t ns = (end.tv_sec - start.tv_sec) * 1000000000ULL + (end.tv_nsec - start.tv_nsec);
-  return (BenchResult){"Store-load aligned (fast forward)", n, ns, (double)ns / n};
+  return (BenchResult){.name = "Store-load aligned (fast forward)", .iterations = n,
+                       .total_ns = ns, .ns_per_access = (double)ns / n};
 }
 
 BenchResult BenchStoreFwdDiff(uint64_t *array, size_t n) {
   uint8_t *bytes = (uint8_t *)array;
 
-  struct timespec start, end;
-  clock_gettime(CLOCK_MONOTONIC, &start);
+  BenchTimer timer;
+  TimerStart(&timer);
 
   uint64_t sum = 0;
   for (size_t i = 0; i < n; i++) {
@@ -36,16 +36,16 @@ BenchResult BenchStoreFwdDiff(uint64_t *array, size_t n) {
     Clobber();
   }
 
-  clock_gettime(CLOCK_MONOTONIC, &end);
+  uint64_t ns = TimerStop(&timer);
   Escape(&sum);
 
-  uint64_t ns = (end.tv_sec - start.tv_sec) * 1000000000ULL + (end.tv_nsec - start.tv_nsec);
-  return (BenchResult){"Store-load overlap (stall)", n, ns, (double)ns / n};
+  return (BenchResult){.name = "Store-load overlap (stall)", .iterations = n,
+                       .total_ns = ns, .ns_per_access = (double)ns / n};
 }
 
 BenchResult BenchStoreFwdNone(uint64_t *array, size_t n) {
-  struct timespec start, end;
-  clock_gettime(CLOCK_MONOTONIC, &start);
+  BenchTimer timer;
+  TimerStart(&timer);
 
   uint64_t sum = 0;
   for (size_t i = 0; i < n; i++) {
@@ -54,10 +54,10 @@ BenchResult BenchStoreFwdNone(uint64_t *array, size_t n) {
     Clobber();
   }
 
-  clock_gettime(CLOCK_MONOTONIC, &end);
+  uint64_t ns = TimerStop(&timer);
   Escape(&sum);
 
-  uint64_t ns = (end.tv_sec - start.tv_sec) * 1000000000ULL + (end.tv_nsec - start.tv_nsec);
-  return (BenchResult){"Store-load independent (no dep)", n, ns, (double)ns / n};
+  return (BenchResult){.name = "Store-load independent (no dep)", .iterations = n,
+                       .total_ns = ns, .ns_per_access = (double)ns / n};
 }
 
@@ -0,0 +1,273 @@
+#include "bench.h"
+#include "harness/cpu_isa.h"
+#include "harness/parallel.h"
+#include "harness/pool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if ISA_X86
+#include <immintrin.h>
+#endif
+
+// Parameter values, in the order of the names registered in main.c.
+enum { kRead, kWrite, kCopy, kScale, kAdd, kTriad, kNumKernels };
+// The isa parameter is 0 for ActiveIsa(), else an Isa plus one.
+enum { kIsaParamAuto };
+enum { kStoresCached, kStoresNt };
+
+static const char *const kKernelNames[] = {
+    "STREAM Read", "STREAM Write", "STREAM Copy",
+    "STREAM Scale", "STREAM Add", "STREAM Triad"};
+
+// Arrays each kernel reads and writes per element (a, b, c as in STREAM).
+static const int kReads[kNumKernels] = {1, 0, 1, 1, 2, 2};
+static const int kWrites[kNumKernels] = {0, 1, 1, 1, 1, 1};
+
+static const double kScalar = 3.0;
+
+typedef struct {
+  double *a, *b, *c;
+  size_t begin, end;
+  int kernel;
+  double sum;  // kRead result
+} StreamArg;
+
+// Scalar stores: plain, or movnti of the double's bits.
+static inline void StoreScalar(double *p, double v) { *p = v; }
+static inline void StreamScalar(double *p, double v) {
+#if ISA_X86
+  long long bits;
+  memcpy(&bits, &v, sizeof(bits));
+  _mm_stream_si64((long long *)p, bits);
+#else
+  *p = v;
+#endif
+}
+
+// One kernel loop per (ISA, store) pair. Vectors of W doubles run over the
+// aligned body; the tail (last worker only) uses plain scalar code. The
+// read kernel keeps four accumulators so cache-resident sizes are not
+// bound by add latency.
+#define DEFINE_KERNELS(Name, Attr, Vec, W, Load, Store, Set1, Add, Mul, Sum) \
+  Attr static void Name(void *arg) {                                        \
+    StreamArg *s = arg;                                                     \
+    double *a = s->a, *b = s->b, *c = s->c;                                 \
+    size_t i = s->begin, end = s->end;                                      \
+    Vec q = Set1(kScalar);                                                  \
+    switch (s->kernel) {                                                    \
+      case kRead: {                                                         \
+        Vec s0 = Set1(0.0), s1 = Set1(0.0), s2 = Set1(0.0), s3 = Set1(0.0); \
+        for (; i + 4 * W <= end; i += 4 * W) {                              \
+          s0 = Add(s0, Load(a + i));                                        \
+          s1 = Add(s1, Load(a + i + W));                                    \
+          s2 = Add(s2, Load(a + i + 2 * W));                                \
+          s3 = Add(s3, Load(a + i + 3 * W));                                \
+        }                                                                   \
+        double sum = Sum(Add(Add(s0, s1), Add(s2, s3)));                    \
+        for (; i < end; i++) sum += a[i];                                   \
+        s->sum = sum;                                                       \
+        return;                                                             \
+      }                                                                     \
+      case kWrite:                                                          \
+        for (; i + W <= end; i += W) Store(a + i, q);                       \
+        for (; i < end; i++) a[i] = kScalar;                                \
+        break;                                                              \
+      case kCopy:                                                           \
+        for (; i + W <= end; i += W) Store(c + i, Load(a + i));             \
+        for (; i < end; i++) c[i] = a[i];                                   \
+        break;                                                              \
+      case kScale:                                                          \
+        for (; i + W <= end; i += W) Store(b + i, Mul(q, Load(c + i)));     \
+        for (; i < end; i++) b[i] = kScalar * c[i];                         \
+        break;                                                              \
+      case kAdd:                                                            \
+        for (; i + W <= end; i += W) {                                      \
+          Store(c + i, Add(Load(a + i), Load(b + i)));                      \
+        }                                                                   \
+        for (; i < end; i++) c[i] = a[i] + b[i];                            \
+        break;                                                              \
+      case kTriad:                                                          \
+        for (; i + W <= end; i += W) {                                      \
+          Store(a + i, Add(Load(b + i), Mul(q, Load(c + i))));              \
+        }                                                                   \
+        for (; i < end; i++) a[i] = b[i] + kScalar * c[i];                  \
+        break;                                                              \
+    }                                                                       \
+    FENCE();                                                                \
+  }
+
+#define SCALAR_LOAD(p) (*(p))
+#define SCALAR_SET1(x) (x)
+#define SCALAR_ADD(x, y) ((x) + (y))
+#define SCALAR_MUL(x, y) ((x) * (y))
+#define SCALAR_SUM(x) (x)
+
+// Keep the "scalar" kernels scalar: no auto-vectorization, and no
+// rewriting the copy loop into a memcpy call.
+#define SCALAR_ATTR \
+  __attribute__((optimize("no-tree-vectorize", "no-tree-loop-distribute-patterns")))
+
+#define FENCE()
+DEFINE_KERNELS(ScalarCached, SCALAR_ATTR, double, 1, SCALAR_LOAD, StoreScalar,
+               SCALAR_SET1, SCALAR_ADD, SCALAR_MUL, SCALAR_SUM)
+#undef FENCE
+
+#if ISA_X86
+#define FENCE() _mm_sfence()
+#else
+#define FENCE()
+#endif
+DEFINE_KERNELS(ScalarNt, SCALAR_ATTR, double, 1, SCALAR_LOAD, StreamScalar,
+               SCALAR_SET1, SCALAR_ADD, SCALAR_MUL, SCALAR_SUM)
+#undef FENCE
+
+#if ISA_X86
+ISA_TARGET_SSE2 static inline double Sum128(__m128d v) {
+  return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+ISA_TARGET_AVX2 static inline double Sum256(__m256d v) {
+  __m128d lo = _mm256_castpd256_pd128(v);
+  __m128d hi = _mm256_extractf128_pd(v, 1);
+  return Sum128(_mm_add_pd(lo, hi));
+}
+
+#define FENCE()
+DEFINE_KERNELS(Sse2Cached, ISA_TARGET_SSE2, __m128d, 2, _mm_load_pd,
+               _mm_store_pd, _mm_set1_pd, _mm_add_pd, _mm_mul_pd, Sum128)
+DEFINE_KERNELS(Avx2Cached, ISA_TARGET_AVX2, __m256d, 4, _mm256_load_pd,
+               _mm256_store_pd, _mm256_set1_pd, _mm256_add_pd, _mm256_mul_pd,
+               Sum256)
+DEFINE_KERNELS(Avx512Cached, ISA_TARGET_AVX512, __m512d, 8, _mm512_load_pd,
+               _mm512_store_pd, _mm512_set1_pd, _mm512_add_pd, _mm512_mul_pd,
+               _mm512_reduce_add_pd)
+#undef FENCE
+#define FENCE() _mm_sfence()
+DEFINE_KERNELS(Sse2Nt, ISA_TARGET_SSE2, __m128d, 2, _mm_load_pd,
+               _mm_stream_pd, _mm_set1_pd, _mm_add_pd, _mm_mul_pd, Sum128)
+DEFINE_KERNELS(Avx2Nt, ISA_TARGET_AVX2, __m256d, 4, _mm256_load_pd,
+               _mm256_stream_pd, _mm256_set1_pd, _mm256_add_pd, _mm256_mul_pd,
+               Sum256)
+DEFINE_KERNELS(Avx512Nt, ISA_TARGET_AVX512, __m512d, 8, _mm512_load_pd,
+               _mm512_stream_pd, _mm512_set1_pd, _mm512_add_pd, _mm512_mul_pd,
+               _mm512_reduce_add_pd)
+#undef FENCE
+#endif
+
+// [isa][stores]; only ISAs the CPU supports are ever selected.
+static const PoolTask kKernels[kNumIsas][2] = {
+    [kIsaScalar] = {ScalarCached, ScalarNt},
+#if ISA_X86
+    [kIsaSse2] = {Sse2Cached, Sse2Nt},
+    [kIsaAvx2] = {Avx2Cached, Avx2Nt},
+    [kIsaAvx512] = {Avx512Cached, Avx512Nt},
+#endif
+};
+
+typedef struct {
+  double *a, *b, *c;
+} InitCtx;
+
+// STREAM's starting values; they stay normal floats under every kernel.
+static void InitArrays(size_t begin, size_t end, void *arg) {
+  InitCtx *ctx = arg;
+  for (size_t i = begin; i < end; i++) {
+    ctx->a[i] = 1.0;
+    ctx->b[i] = 2.0;
+    ctx->c[i] = 0.0;
+  }
+}
+
+// Runs one kernel over three arrays carved out of the benchmark array. The
+// benchmark array is page aligned and each third is a whole number of
+// cache lines, so aligned vector loads and streaming stores are safe.
+static BenchResult RunStream(uint64_t *array, size_t n, int kernel,
+                             int isa_param, int nt, int num_threads) {
+  BenchResult error = {0};
+  Isa isa = isa_param == kIsaParamAuto ? ActiveIsa() : (Isa)(isa_param - 1);
+  if (!IsaSupported(isa)) {
+    fprintf(stderr, "STREAM: this CPU cannot run %s kernels\n", IsaName(isa));
+    return error;
+  }
+  PoolTask task = kKernels[isa][nt];
+  size_t m = (n / 3) & ~(size_t)7;
+  if (m < (size_t)num_threads * 8) {
+    fprintf(stderr, "STREAM: array too small for %d threads\n", num_threads);
+    return error;
+  }
+  double *a = (double *)array;
+  double *b = a + m;
+  double *c = b + m;
+  InitCtx init = {.a = a, .b = b, .c = c};
+  ParallelFor(m, InitArrays, &init);
+
+  StreamArg *args = malloc(num_threads * sizeof(StreamArg));
+  if (!args) {
+    fprintf(stderr, "Failed to allocate %d threads\n", num_threads);
+    return error;
+  }
+  size_t chunk = (m / num_threads) & ~(size_t)7;
+  for (int t = 0; t < num_threads; t++) {
+    args[t] = (StreamArg){.a = a, .b = b, .c = c, .begin = t * chunk,
+                          .end = t + 1 == num_threads ? m : (t + 1) * chunk,
+                          .kernel = kernel};
+  }
+
+  if (!PoolReserve(num_threads)) {
+    free(args);
+    return error;
+  }
+  PoolTiming timing;
+  BenchTimer timer;
+  TimerStart(&timer);
+  int ok = PoolRun(num_threads, task, args, sizeof(StreamArg), &timing);
+  TimerStop(&timer);
+  if (!ok) {
+    free(args);
+    return error;
+  }
+  double sum = 0;
+  for (int t = 0; t < num_threads; t++) sum += args[t].sum;
+  Escape(&sum);
+  free(args);
+
+  // STREAM counts the bytes the kernel names. A cached store also reads
+  // the line first (write-allocate / RFO), which the memory bus does see.
+  uint64_t ns = timing.span_ns;
+  size_t stream_bytes = m * sizeof(double) * (kReads[kernel] + kWrites[kernel]);
+  size_t bus_bytes = stream_bytes + (nt ? 0 : m * sizeof(double) * kWrites[kernel]);
+  const char *stores = !kWrites[kernel] ? "no"
+                       : nt             ? "non-temporal"
+                                        : "cached";
+  BenchLog("  Kernel: %s, %s, %s stores, %d thread%s\n", kKernelNames[kernel],
+           IsaName(isa), stores, num_threads, num_threads == 1 ? "" : "s");
+  if (bus_bytes != stream_bytes) {
+    BenchLog("  Bandwidth: %.1f GB/s (%.1f GB/s with write-allocate reads; "
+             "workers overlapped %.0f%% of %.2f ms)\n",
+             stream_bytes / (double)ns, bus_bytes / (double)ns,
+             100.0 * PoolOverlap(&timing), ns / 1e6);
+  } else {
+    BenchLog("  Bandwidth: %.1f GB/s (workers overlapped %.0f%% of %.2f ms)\n",
+             stream_bytes / (double)ns, 100.0 * PoolOverlap(&timing),
+             ns / 1e6);
+  }
+
+  return (BenchResult){.name = kKernelNames[kernel], .iterations = m,
+                       .total_ns = ns, .ns_per_access = (double)ns / m,
+                       .gbps = stream_bytes / (double)ns};
+}
+
+BenchResult BenchStreamRead(uint64_t *a, size_t n) { return RunStream(a, n, kRead, kIsaParamAuto, 0, 1); }
+BenchResult BenchStreamWrite(uint64_t *a, size_t n) { return RunStream(a, n, kWrite, kIsaParamAuto, 0, 1); }
+BenchResult BenchStreamCopy(uint64_t *a, size_t n) { return RunStream(a, n, kCopy, kIsaParamAuto, 0, 1); }
+BenchResult BenchStreamScale(uint64_t *a, size_t n) { return RunStream(a, n, kScale, kIsaParamAuto, 0, 1); }
+BenchResult BenchStreamAdd(uint64_t *a, size_t n) { return RunStream(a, n, kAdd, kIsaParamAuto, 0, 1); }
+BenchResult BenchStreamTriad(uint64_t *a, size_t n) { return RunStream(a, n, kTriad, kIsaParamAuto, 0, 1); }
+
+BenchResult BenchStream(uint64_t *a, size_t n, const int64_t *params) {
+  return RunStream(a, n, (int)params[0], (int)params[1],
+                   params[2] == kStoresNt, (int)params[3]);
+}
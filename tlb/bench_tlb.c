@@ -1,14 +1,24 @@
 #include "bench.h"
+#include "harness/rng.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <time.h>
 
+// tlb_reach chases a random cycle through one line in each of `pages`
+// pages, so each hop is a fresh translation once the pages outnumber a TLB
+// level. The packed layout puts the same number of lines side by side: the
+// same data-cache footprint on a handful of pages, the control that turns
+// the difference into translation cost alone.
+#define TLB_REACH_ACCESSES ((size_t)1 << 20)
+#define TLB_REACH_STREAM 0x746c620000000000ULL  // "tlb"
+
 static BenchResult RunStride(uint64_t *array, size_t n, size_t stride, const char *name) {
   size_t count = n / stride;
   if (count < 1) count = 1;
 
-  struct timespec start, end;
-  clock_gettime(CLOCK_MONOTONIC, &start);
+  BenchTimer timer;
+  TimerStart(&timer);
 
   uint64_t sum = 0;
   for (size_t rep = 0; rep < 10; rep++) {
@@ -18,13 +28,13 @@ static BenchResult RunStride(uint64_t *array, size_t n, size_t stride, const cha
     }
   }
 
-  clock_gettime(CLOCK_MONOTONIC, &end);
+  uint64_t ns = TimerStop(&timer);
   Escape(&sum);
 
-  uint64_t ns = (end.tv_sec - start.tv_sec) * 1000000000ULL + (end.tv_nsec - start.tv_nsec);
   size_t total = count * 10;
 
-  return (BenchResult){name, total, ns, (double)ns / total};
+  return (BenchResult){.name = name, .iterations = total,
+                       .total_ns = ns, .ns_per_access = (double)ns / total};
 }
 
 BenchResult BenchTlbSeq(uint64_t *a, size_t n) {
@@ -47,3 +57,69 @@ BenchResult BenchTlb2Page(uint64_t *a, size_t n) {
   return RunStride(a, n, 1024, "Stride 8KB (skip pages)");
 }
 
+
+BenchResult BenchTlbStride(uint64_t *a, size_t n, const int64_t *params) {
+  size_t stride = (size_t)params[0] / sizeof(uint64_t);
+  return RunStride(a, n, stride ? stride : 1, "Stride");
+}
+
+// Node `k` of a tlb_reach layout, as an element index: one random line in
+// page k when spread, line k when packed.
+static size_t ReachNode(size_t k, int spread, size_t page_elems,
+                        const uint16_t *lines) {
+  return spread ? k * page_elems + (size_t)lines[k] * 8 : k * 8;
+}
+
+static BenchResult RunReach(uint64_t *array, size_t n, size_t pages,
+                            size_t page_bytes, int spread) {
+  BenchResult error = {0};
+  size_t page_elems = page_bytes / sizeof(uint64_t);
+  size_t span = spread ? pages * page_elems : pages * 8;
+  if (page_elems < 8 || span > n) {
+    fprintf(stderr, "TLB reach: %zu pages of %zu bytes do not fit the "
+                    "array\n",
+            pages, page_bytes);
+    return error;
+  }
+  size_t *order = RandomPermutation(pages, BenchSeed());
+  uint16_t *lines = malloc(pages * sizeof(uint16_t));
+  if (!order || !lines) {
+    fprintf(stderr, "Failed to allocate a %zu-page layout\n", pages);
+    free(order);
+    free(lines);
+    return error;
+  }
+  // Random lines keep the nodes spread over the cache sets; at most 65536
+  // lines per page are told apart, which covers 4 MiB pages.
+  Rng rng;
+  RngSeed(&rng, BenchSeed(), TLB_REACH_STREAM);
+  size_t lines_per_page = page_bytes / 64 < 65536 ? page_bytes / 64 : 65536;
+  for (size_t k = 0; k < pages; k++) {
+    lines[k] = (uint16_t)RngBounded(&rng, lines_per_page);
+  }
+  for (size_t i = 0; i < pages; i++) {
+    size_t from = ReachNode(order[i], spread, page_elems, lines);
+    size_t to = ReachNode(order[(i + 1) % pages], spread, page_elems, lines);
+    array[from] = to;
+  }
+  size_t idx = ReachNode(order[0], spread, page_elems, lines);
+  free(order);
+  free(lines);
+
+  size_t accesses = 2 * pages > TLB_REACH_ACCESSES ? 2 * pages
+                                                   : TLB_REACH_ACCESSES;
+  BenchTimer timer;
+  TimerStart(&timer);
+  for (size_t i = 0; i < accesses; i++) idx = array[idx];
+  uint64_t ns = TimerStop(&timer);
+  Escape(&idx);
+
+  return (BenchResult){.name = spread ? "TLB reach" : "TLB reach (packed)",
+                       .iterations = accesses, .total_ns = ns,
+                       .ns_per_access = (double)ns / accesses};
+}
+
+BenchResult BenchTlbReach(uint64_t *a, size_t n, const int64_t *params) {
+  return RunReach(a, n, (size_t)params[0], (size_t)params[1],
+                  params[2] == 0);
+}
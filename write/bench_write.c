@@ -0,0 +1,302 @@
+#include "bench.h"
+#include "harness/cpu_isa.h"
+#include "harness/units.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#if ISA_X86
+#include <immintrin.h>
+#endif
+
+// Each trial repeats the operation until this many bytes have been
+// written, so small sizes run from cache many times over and large ones
+// once.
+#define WRITE_TARGET_BYTES ((size_t)64 << 20)
+// The copy source starts this far past a page boundary after the
+// destination, so its loads never 4K-alias the stores.
+#define SOURCE_SKEW 2048
+
+// Parameter values, in the order of the names registered in main.c.
+enum { kOpFill, kOpCopy };
+enum {
+  kMethodLoop,
+  kMethodNt,
+  kMethodRep,
+  kMethodLibc,
+  kMethodAvx2,
+  kMethodAvx512,
+};
+
+static const char *const kOpNames[] = {"fill", "copy"};
+static const char *const kMethodNames[] = {
+    "plain stores", "streaming stores", "rep stosb/movsb",
+    "libc memset/memcpy", "AVX2 stores", "AVX-512 stores"};
+static const Isa kMethodIsas[] = {kIsaScalar, kIsaSse2, kIsaScalar,
+                                  kIsaScalar, kIsaAvx2, kIsaAvx512};
+
+typedef void (*FillFunc)(uint8_t *dst, size_t size, int value);
+typedef void (*CopyFunc)(uint8_t *dst, const uint8_t *src, size_t size);
+
+// Without these GCC turns the loops back into memset/memcpy calls or
+// vectorizes them; each store here is one 8-byte mov that reads the line
+// for ownership first.
+#define PLAIN_ATTR \
+  __attribute__((optimize("no-tree-vectorize", \
+                          "no-tree-loop-distribute-patterns")))
+
+// The 8-byte accesses go through memcpy, which compiles to a single mov
+// and stays defined at the misaligned addresses `misalign` asks for.
+PLAIN_ATTR static void FillLoop(uint8_t *dst, size_t size, int value) {
+  uint64_t v = 0x0101010101010101ULL * (uint8_t)value;
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) memcpy(dst + i, &v, sizeof(v));
+  for (; i < size; i++) dst[i] = (uint8_t)value;
+}
+
+PLAIN_ATTR static void CopyLoop(uint8_t *dst, const uint8_t *src,
+                                size_t size) {
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    uint64_t v;
+    memcpy(&v, src + i, sizeof(v));
+    memcpy(dst + i, &v, sizeof(v));
+  }
+  for (; i < size; i++) dst[i] = src[i];
+}
+
+static void FillLibc(uint8_t *dst, size_t size, int value) {
+  memset(dst, value, size);
+}
+
+static void CopyLibc(uint8_t *dst, const uint8_t *src, size_t size) {
+  memcpy(dst, src, size);
+}
+
+#if ISA_X86
+static void FillRep(uint8_t *dst, size_t size, int value) {
+  __asm__ volatile("rep stosb"
+                   : "+D"(dst), "+c"(size)
+                   : "a"(value)
+                   : "memory");
+}
+
+static void CopyRep(uint8_t *dst, const uint8_t *src, size_t size) {
+  __asm__ volatile("rep movsb"
+                   : "+D"(dst), "+S"(src), "+c"(size)
+                   :
+                   : "memory");
+}
+
+// Streaming stores need 16-byte alignment: plain stores up to the first
+// aligned address and after the last full vector. The sfence orders the
+// write-combining buffers before the next trial reads the data.
+ISA_TARGET_SSE2 static void FillNt(uint8_t *dst, size_t size, int value) {
+  size_t head = (16 - ((uintptr_t)dst & 15)) & 15;
+  if (head > size) head = size;
+  FillLoop(dst, head, value);
+  __m128i v = _mm_set1_epi8((char)value);
+  size_t i = head;
+  for (; i + 16 <= size; i += 16) _mm_stream_si128((__m128i *)(dst + i), v);
+  FillLoop(dst + i, size - i, value);
+  _mm_sfence();
+}
+
+ISA_TARGET_SSE2 static void CopyNt(uint8_t *dst, const uint8_t *src,
+                                   size_t size) {
+  size_t head = (16 - ((uintptr_t)dst & 15)) & 15;
+  if (head > size) head = size;
+  CopyLoop(dst, src, head);
+  size_t i = head;
+  for (; i + 16 <= size; i += 16) {
+    _mm_stream_si128((__m128i *)(dst + i),
+                     _mm_loadu_si128((const __m128i *)(src + i)));
+  }
+  CopyLoop(dst + i, src + i, size - i);
+  _mm_sfence();
+}
+
+// Unaligned vector stores, four per iteration; the last vector overlaps
+// the previous one instead of running a byte tail.
+ISA_TARGET_AVX2 static void FillAvx2(uint8_t *dst, size_t size, int value) {
+  if (size < 32) {
+    FillLoop(dst, size, value);
+    return;
+  }
+  __m256i v = _mm256_set1_epi8((char)value);
+  size_t i = 0;
+  for (; i + 128 <= size; i += 128) {
+    _mm256_storeu_si256((__m256i *)(dst + i), v);
+    _mm256_storeu_si256((__m256i *)(dst + i + 32), v);
+    _mm256_storeu_si256((__m256i *)(dst + i + 64), v);
+    _mm256_storeu_si256((__m256i *)(dst + i + 96), v);
+  }
+  for (; i + 32 <= size; i += 32) _mm256_storeu_si256((__m256i *)(dst + i), v);
+  if (i < size) _mm256_storeu_si256((__m256i *)(dst + size - 32), v);
+}
+
+ISA_TARGET_AVX2 static void CopyAvx2(uint8_t *dst, const uint8_t *src,
+                                     size_t size) {
+  if (size < 32) {
+    CopyLoop(dst, src, size);
+    return;
+  }
+  size_t i = 0;
+  for (; i + 128 <= size; i += 128) {
+    __m256i a = _mm256_loadu_si256((const __m256i *)(src + i));
+    __m256i b = _mm256_loadu_si256((const __m256i *)(src + i + 32));
+    __m256i c = _mm256_loadu_si256((const __m256i *)(src + i + 64));
+    __m256i d = _mm256_loadu_si256((const __m256i *)(src + i + 96));
+    _mm256_storeu_si256((__m256i *)(dst + i), a);
+    _mm256_storeu_si256((__m256i *)(dst + i + 32), b);
+    _mm256_storeu_si256((__m256i *)(dst + i + 64), c);
+    _mm256_storeu_si256((__m256i *)(dst + i + 96), d);
+  }
+  for (; i + 32 <= size; i += 32) {
+    _mm256_storeu_si256((__m256i *)(dst + i),
+                        _mm256_loadu_si256((const __m256i *)(src + i)));
+  }
+  if (i < size) {
+    _mm256_storeu_si256(
+        (__m256i *)(dst + size - 32),
+        _mm256_loadu_si256((const __m256i *)(src + size - 32)));
+  }
+}
+
+ISA_TARGET_AVX512 static void FillAvx512(uint8_t *dst, size_t size,
+                                         int value) {
+  if (size < 64) {
+    FillAvx2(dst, size, value);
+    return;
+  }
+  __m512i v = _mm512_set1_epi8((char)value);
+  size_t i = 0;
+  for (; i + 256 <= size; i += 256) {
+    _mm512_storeu_si512(dst + i, v);
+    _mm512_storeu_si512(dst + i + 64, v);
+    _mm512_storeu_si512(dst + i + 128, v);
+    _mm512_storeu_si512(dst + i + 192, v);
+  }
+  for (; i + 64 <= size; i += 64) _mm512_storeu_si512(dst + i, v);
+  if (i < size) _mm512_storeu_si512(dst + size - 64, v);
+}
+
+ISA_TARGET_AVX512 static void CopyAvx512(uint8_t *dst, const uint8_t *src,
+                                         size_t size) {
+  if (size < 64) {
+    CopyAvx2(dst, src, size);
+    return;
+  }
+  size_t i = 0;
+  for (; i + 256 <= size; i += 256) {
+    __m512i a = _mm512_loadu_si512(src + i);
+    __m512i b = _mm512_loadu_si512(src + i + 64);
+    __m512i c = _mm512_loadu_si512(src + i + 128);
+    __m512i d = _mm512_loadu_si512(src + i + 192);
+    _mm512_storeu_si512(dst + i, a);
+    _mm512_storeu_si512(dst + i + 64, b);
+    _mm512_storeu_si512(dst + i + 128, c);
+    _mm512_storeu_si512(dst + i + 192, d);
+  }
+  for (; i + 64 <= size; i += 64) {
+    _mm512_storeu_si512(dst + i, _mm512_loadu_si512(src + i));
+  }
+  if (i < size) {
+    _mm512_storeu_si512(dst + size - 64, _mm512_loadu_si512(src + size - 64));
+  }
+}
+#endif
+
+// Indexed by method; x86-only methods stay NULL elsewhere.
+static const FillFunc kFills[WRITE_NUM_METHODS] = {
+    [kMethodLoop] = FillLoop,
+    [kMethodLibc] = FillLibc,
+#if ISA_X86
+    [kMethodNt] = FillNt,
+    [kMethodRep] = FillRep,
+    [kMethodAvx2] = FillAvx2,
+    [kMethodAvx512] = FillAvx512,
+#endif
+};
+
+static const CopyFunc kCopies[WRITE_NUM_METHODS] = {
+    [kMethodLoop] = CopyLoop,
+    [kMethodLibc] = CopyLibc,
+#if ISA_X86
+    [kMethodNt] = CopyNt,
+    [kMethodRep] = CopyRep,
+    [kMethodAvx2] = CopyAvx2,
+    [kMethodAvx512] = CopyAvx512,
+#endif
+};
+
+static int WriteMethodAvailable(int method) {
+  return kFills[method] != NULL && IsaSupported(kMethodIsas[method]);
+}
+
+static BenchResult RunWrite(uint64_t *array, size_t n, int op, int method,
+                            size_t size, size_t misalign) {
+  BenchResult error = {0};
+  if (!WriteMethodAvailable(method)) {
+    fprintf(stderr, "Write: this CPU cannot run %s\n", kMethodNames[method]);
+    return error;
+  }
+  // Destination first, `misalign` bytes past a line; the source follows.
+  uint8_t *base = (uint8_t *)array;
+  uint8_t *dst = base + misalign;
+  size_t dst_span = (misalign + size + 4095) / 4096 * 4096;
+  const uint8_t *src = base + dst_span + SOURCE_SKEW;
+  size_t needed = op == kOpCopy ? dst_span + SOURCE_SKEW + size : dst_span;
+  if (size == 0 || needed > n * sizeof(uint64_t)) {
+    char text[32];
+    fprintf(stderr, "Write: %s of %s does not fit the array\n", kOpNames[op],
+            FormatBytes(size, text, sizeof(text)));
+    return error;
+  }
+  size_t reps = WRITE_TARGET_BYTES / size ? WRITE_TARGET_BYTES / size : 1;
+
+  // One untimed call, so first touches and cold misses stay outside.
+  if (op == kOpFill) {
+    kFills[method](dst, size, 1);
+  } else {
+    kCopies[method](dst, src, size);
+  }
+  Clobber();
+
+  BenchTimer timer;
+  TimerStart(&timer);
+  if (op == kOpFill) {
+    FillFunc fill = kFills[method];
+    for (size_t r = 0; r < reps; r++) {
+      fill(dst, size, (int)r);
+      Clobber();
+    }
+  } else {
+    CopyFunc copy = kCopies[method];
+    for (size_t r = 0; r < reps; r++) {
+      copy(dst, src, size);
+      Clobber();
+    }
+  }
+  uint64_t ns = TimerStop(&timer);
+  Escape(dst);
+
+  double gbps = (double)size * reps / (double)ns;
+  char text[32];
+  BenchLog("  %s %s with %s, +%zu bytes: %.2f GB/s, %.1f ns per call\n",
+           kOpNames[op], FormatBytes(size, text, sizeof(text)),
+           kMethodNames[method], misalign, gbps, (double)ns / reps);
+
+  return (BenchResult){.name = "Write", .iterations = reps, .total_ns = ns,
+                       .ns_per_access = (double)ns / reps, .gbps = gbps};
+}
+
+int WriteMethodSupported(int method) {
+  return method >= 0 && method < WRITE_NUM_METHODS && WriteMethodAvailable(method);
+}
+
+BenchResult BenchWrite(uint64_t *array, size_t n, const int64_t *params) {
+  return RunWrite(array, n, (int)params[0], (int)params[1], (size_t)params[2],
+                  (size_t)params[3]);
+}